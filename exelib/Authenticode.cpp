@@ -0,0 +1,357 @@
+/// \file   Authenticode.cpp
+/// Implementation of the DER reader and Authenticode signer extraction.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Authenticode.h"
+
+namespace {
+
+// Contents of the object identifier 1.2.840.113549.1.7.2, PKCS#7 signedData.
+const uint8_t   oid_signed_data[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x02};
+
+bool equal(BytesView a, BytesView b) noexcept
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+void append_utf8(std::string &str, uint32_t code_point)
+{
+    if (code_point < 0x80)
+    {
+        str += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        str += static_cast<char>(0xC0 | (code_point >> 6));
+        str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+        str += static_cast<char>(0xE0 | (code_point >> 12));
+        str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+        str += static_cast<char>(0xF0 | (code_point >> 18));
+        str += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        str += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+std::string string_value(const DerElement &element)
+{
+    std::string rv;
+
+    switch (element.tag)
+    {
+        case DerElement::BmpString:     // UTF-16, big-endian
+            for (size_t i = 0; i + 1 < element.contents.size(); i += 2)
+            {
+                uint32_t    unit{static_cast<uint32_t>(element.contents[i] << 8 | element.contents[i + 1])};
+
+                if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < element.contents.size())
+                {
+                    uint32_t    low{static_cast<uint32_t>(element.contents[i + 2] << 8 | element.contents[i + 3])};
+
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    }
+                }
+                append_utf8(rv, unit);
+            }
+            break;
+
+        case DerElement::T61String:     // treated as Latin-1
+            for (auto ch : element.contents)
+                append_utf8(rv, ch);
+            break;
+
+        default:                        // UTF8String, PrintableString, IA5String, and anything else
+            rv.assign(reinterpret_cast<const char *>(element.contents.data()), element.contents.size());
+            break;
+    }
+
+    return rv;
+}
+
+const char *attribute_short_name(const std::string &oid)
+{
+    static const struct
+    {
+        const char *oid;
+        const char *name;
+    } names[] =
+    {
+        {"2.5.4.3",                 "CN"},
+        {"2.5.4.4",                 "SN"},
+        {"2.5.4.5",                 "SERIALNUMBER"},
+        {"2.5.4.6",                 "C"},
+        {"2.5.4.7",                 "L"},
+        {"2.5.4.8",                 "ST"},
+        {"2.5.4.9",                 "STREET"},
+        {"2.5.4.10",                "O"},
+        {"2.5.4.11",                "OU"},
+        {"2.5.4.12",                "T"},
+        {"2.5.4.42",                "G"},
+        {"1.2.840.113549.1.9.1",    "E"},
+        {"0.9.2342.19200300.100.1.25", "DC"}
+    };
+
+    for (const auto &entry : names)
+        if (oid == entry.oid)
+            return entry.name;
+
+    return nullptr;
+}
+
+// Find the signer's certificate among the certificates carried in SignedData.
+void find_certificate(BytesView certificates, AuthenticodeSigner &signer)
+{
+    DerReader   reader{certificates};
+    DerElement  certificate;
+
+    while (reader.next(certificate))
+    {
+        if (certificate.tag != DerElement::Sequence)
+            continue;   // other certificate choices are not X.509 certificates
+
+        DerReader   cert_reader{certificate.contents};
+        DerReader   tbs{cert_reader.expect(DerElement::Sequence).contents};
+        DerElement  element;
+
+        tbs.next_if(DerElement::Context0, element);     // version
+
+        auto    serial{tbs.expect(DerElement::Integer)};
+
+        tbs.expect(DerElement::Sequence);               // signature algorithm
+
+        auto    issuer{tbs.expect(DerElement::Sequence)};
+
+        tbs.expect(DerElement::Sequence);               // validity
+
+        auto    subject{tbs.expect(DerElement::Sequence)};
+
+        if (equal(serial.contents, signer.serial_number) && equal(issuer.encoding, signer.issuer))
+        {
+            signer.subject = subject.encoding;
+            signer.certificate = certificate.encoding;
+            return;
+        }
+    }
+}
+
+}   // anonymous namespace
+
+
+bool DerReader::next(DerElement &element)
+{
+    if (at_end())
+        return false;
+
+    const size_t    start{_pos};
+    const size_t    size{_bytes.size()};
+
+    if (size - _pos < 2)
+        throw std::runtime_error("Malformed DER encoding: truncated element");
+
+    element.tag = _bytes[_pos++];
+    if ((element.tag & 0x1F) == 0x1F)
+        throw std::runtime_error("Malformed DER encoding: unsupported high tag number");
+
+    size_t  length{_bytes[_pos++]};
+
+    if (length & 0x80)
+    {
+        size_t  count{length & 0x7F};
+
+        if (count == 0 || count > sizeof(uint32_t))
+            throw std::runtime_error("Malformed DER encoding: invalid length");
+        if (size - _pos < count)
+            throw std::runtime_error("Malformed DER encoding: truncated element");
+
+        length = 0;
+        while (count--)
+            length = (length << 8) | _bytes[_pos++];
+    }
+
+    if (length > size - _pos)
+        throw std::runtime_error("Malformed DER encoding: element extends beyond its container");
+
+    element.contents = _bytes.subview(_pos, length);
+    element.encoding = _bytes.subview(start, _pos + length - start);
+    _pos += length;
+
+    return true;
+}
+
+DerElement DerReader::expect(uint8_t tag)
+{
+    DerElement  element;
+
+    if (!next(element))
+        throw std::runtime_error("Malformed DER encoding: missing element");
+    if (element.tag != tag)
+        throw std::runtime_error("Malformed DER encoding: unexpected element");
+
+    return element;
+}
+
+bool DerReader::next_if(uint8_t tag, DerElement &element)
+{
+    if (at_end() || _bytes[_pos] != tag)
+        return false;
+
+    return next(element);
+}
+
+std::vector<AuthenticodeSigner> get_authenticode_signers(BytesView signed_data)
+{
+    std::vector<AuthenticodeSigner> rv;
+
+    // ContentInfo ::= SEQUENCE { contentType OID, content [0] EXPLICIT SignedData }
+    DerReader   outer{signed_data};
+    DerReader   content_info{outer.expect(DerElement::Sequence).contents};
+
+    if (!equal(content_info.expect(DerElement::ObjectId).contents, BytesView{oid_signed_data, sizeof(oid_signed_data)}))
+        throw std::runtime_error("Authenticode signature does not contain PKCS#7 SignedData");
+
+    DerReader   explicit_content{content_info.expect(DerElement::Context0).contents};
+    DerReader   content{explicit_content.expect(DerElement::Sequence).contents};
+    DerElement  element;
+    BytesView   certificates;
+
+    // SignedData ::= SEQUENCE { version, digestAlgorithms SET, contentInfo SEQUENCE,
+    //                           certificates [0] IMPLICIT OPTIONAL, crls [1] IMPLICIT OPTIONAL,
+    //                           signerInfos SET }
+    content.expect(DerElement::Integer);
+    content.expect(DerElement::Set);
+    content.expect(DerElement::Sequence);
+    if (content.next_if(DerElement::Context0, element))
+        certificates = element.contents;
+    content.next_if(DerElement::Context1, element);
+
+    DerReader   signer_infos{content.expect(DerElement::Set).contents};
+
+    while (signer_infos.next(element))
+    {
+        if (element.tag != DerElement::Sequence)
+            continue;
+
+        // SignerInfo ::= SEQUENCE { version, sid, ... }
+        // Authenticode always identifies the signer by issuer and serial number.
+        DerReader   signer_info{element.contents};
+
+        signer_info.expect(DerElement::Integer);
+
+        DerElement  sid;
+
+        if (!signer_info.next_if(DerElement::Sequence, sid))
+            continue;   // identified by subject key identifier; not used by Authenticode
+
+        DerReader           issuer_and_serial{sid.contents};
+        AuthenticodeSigner  signer;
+
+        signer.issuer = issuer_and_serial.expect(DerElement::Sequence).encoding;
+        signer.serial_number = issuer_and_serial.expect(DerElement::Integer).contents;
+
+        if (!certificates.empty())
+            find_certificate(certificates, signer);
+
+        rv.push_back(signer);
+    }
+
+    return rv;
+}
+
+std::string der_name_to_string(BytesView name)
+{
+    std::string rv;
+    DerReader   outer{name};
+    DerReader   rdns{outer.expect(DerElement::Sequence).contents};
+    DerElement  rdn;
+
+    // Name ::= SEQUENCE OF SET OF SEQUENCE { type OID, value ANY }
+    while (rdns.next(rdn))
+    {
+        DerReader   attributes{rdn.contents};
+        DerElement  attribute;
+
+        while (attributes.next(attribute))
+        {
+            DerReader   reader{attribute.contents};
+            auto        oid{der_oid_to_string(reader.expect(DerElement::ObjectId).contents)};
+            DerElement  value;
+
+            if (!reader.next(value))
+                continue;
+
+            const char *short_name{attribute_short_name(oid)};
+
+            if (!rv.empty())
+                rv += ", ";
+            rv += short_name ? short_name : oid;
+            rv += '=';
+            rv += string_value(value);
+        }
+    }
+
+    return rv;
+}
+
+std::string der_oid_to_string(BytesView oid)
+{
+    std::string rv;
+    uint64_t    value{0};
+    bool        first{true};
+
+    for (auto byte : oid)
+    {
+        value = (value << 7) | (byte & 0x7F);
+        if (byte & 0x80)
+            continue;
+
+        if (first)
+        {
+            // The first component combines the first two arcs.
+            uint64_t    arc{std::min<uint64_t>(value / 40, 2)};
+
+            rv = std::to_string(arc) + '.' + std::to_string(value - arc * 40);
+            first = false;
+        }
+        else
+        {
+            rv += '.';
+            rv += std::to_string(value);
+        }
+        value = 0;
+    }
+
+    return rv;
+}
+
+std::string der_bytes_to_hex(BytesView bytes)
+{
+    static const char   digits[] = "0123456789abcdef";
+    std::string         rv;
+
+    rv.reserve(bytes.size() * 2);
+    for (auto byte : bytes)
+    {
+        rv += digits[byte >> 4];
+        rv += digits[byte & 0x0F];
+    }
+
+    return rv;
+}
@@ -0,0 +1,130 @@
+/// \file   Authenticode.h
+/// Provides a light-weight DER reader and functions for extracting signer
+/// information from the Authenticode signatures in a PE Attribute
+/// Certificate Table, without the need for a cryptography library.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_AUTHENTICODE_H_
+#define _EXELIB_AUTHENTICODE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "views.h"
+
+
+/// \brief  A single element of a DER encoding.
+struct DerElement
+{
+    uint8_t     tag;        ///< The identifier octet: class, constructed flag, and tag number.
+    BytesView   contents;   ///< The contents octets.
+    BytesView   encoding;   ///< The complete encoding, including the identifier and length octets.
+
+    /// \brief  Common values of the identifier octet.
+    enum Tag : uint8_t
+    {
+        Integer         = 0x02,
+        BitString       = 0x03,
+        OctetString     = 0x04,
+        Null            = 0x05,
+        ObjectId        = 0x06,
+        Utf8String      = 0x0C,
+        PrintableString = 0x13,
+        T61String       = 0x14,
+        Ia5String       = 0x16,
+        UtcTime         = 0x17,
+        GeneralizedTime = 0x18,
+        BmpString       = 0x1E,
+        Sequence        = 0x30,
+        Set             = 0x31,
+        Context0        = 0xA0,     ///< Constructed, context-specific tag [0].
+        Context1        = 0xA1      ///< Constructed, context-specific tag [1].
+    };
+
+    /// \brief  Return \c true if the element contains other elements.
+    bool is_constructed() const noexcept
+    {
+        return (tag & 0x20) != 0;
+    }
+};
+
+/// \brief  Reads consecutive DER elements from a range of bytes.
+///
+/// The reader does not copy anything: each element's contents are a view
+/// into the bytes given to the constructor. To descend into a constructed
+/// element, construct another DerReader from its contents.
+class DerReader
+{
+public:
+    /// \brief  Construct a DerReader to read the elements in \p bytes.
+    explicit DerReader(BytesView bytes) noexcept
+      : _bytes{bytes}
+    {}
+
+    /// \brief  Return \c true if there are no more elements to read.
+    bool at_end() const noexcept
+    {
+        return _pos >= _bytes.size();
+    }
+
+    /// \brief  Read the next element.
+    /// \param element  Receives the element.
+    /// \return \c true if an element was read, \c false if there are no more.
+    ///
+    /// A \c std::runtime_error exception is thrown if the encoding is malformed.
+    bool next(DerElement &element);
+
+    /// \brief  Read the next element, which must have the given tag.
+    ///
+    /// A \c std::runtime_error exception is thrown if there are no more
+    /// elements, the encoding is malformed, or the tag does not match.
+    DerElement expect(uint8_t tag);
+
+    /// \brief  Read the next element only if it has the given tag.
+    /// \return \c true if the element was read, \c false if there are no
+    ///         more elements or the next element has a different tag.
+    bool next_if(uint8_t tag, DerElement &element);
+
+private:
+    BytesView   _bytes;
+    size_t      _pos{0};
+};
+
+/// \brief  Identifies the signer of an Authenticode signature.
+struct AuthenticodeSigner
+{
+    BytesView   issuer;         ///< DER encoding of the issuer's Name.
+    BytesView   serial_number;  ///< Contents of the serial number INTEGER, most significant byte first.
+    BytesView   subject;        ///< DER encoding of the subject Name of the signer's certificate.
+                                ///< Empty if the certificate is not included in the signature.
+    BytesView   certificate;    ///< DER encoding of the signer's certificate. Empty if it is not included.
+};
+
+/// \brief  Extract the signers from an Authenticode signature.
+/// \param signed_data  A PKCS#7 ContentInfo containing SignedData, such as the
+///                     \c certificate member of a PeCertificate entry of type
+///                     PeCertificate::PkcsSignedData.
+/// \return A vector of signers, whose members are views into \p signed_data.
+///
+/// Only the outermost signature is examined; nested signatures, which are
+/// carried in unauthenticated attributes, are not. A \c std::runtime_error
+/// exception is thrown if the structure is malformed.
+std::vector<AuthenticodeSigner> get_authenticode_signers(BytesView signed_data);
+
+/// \brief  Format a DER-encoded X.500 Name as a string such as
+///         "CN=Example, O=Example Corp, C=US".
+///
+/// Well-known attribute types are given their short names; others are shown
+/// as dotted object identifiers. Values are converted to UTF-8.
+std::string der_name_to_string(BytesView name);
+
+/// \brief  Format the contents of a DER-encoded object identifier in dotted form.
+std::string der_oid_to_string(BytesView oid);
+
+/// \brief  Format bytes, such as the contents of a serial number INTEGER, as hex digits.
+std::string der_bytes_to_hex(BytesView bytes);
+
+#endif  //_EXELIB_AUTHENTICODE_H_
@@ -0,0 +1,121 @@
+/// \file   BlobStore.cpp
+/// Implementation of the BlobStore class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <cstring>
+
+#include "BlobStore.h"
+
+namespace {
+
+inline uint64_t mix(uint64_t value) noexcept
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+}   // anonymous namespace
+
+
+uint64_t BlobStore::content_hash(const std::vector<uint8_t> &bytes) noexcept
+{
+    // Section data runs to megabytes, so the hash consumes eight bytes at
+    // a time. Equal hashes are always confirmed by comparing the content.
+    const uint8_t  *ptr{bytes.data()};
+    size_t          remaining{bytes.size()};
+    uint64_t        h{0x9E3779B97F4A7C15ull ^ bytes.size()};
+
+    for (; remaining >= 8; ptr += 8, remaining -= 8)
+    {
+        uint64_t    word;
+
+        std::memcpy(&word, ptr, sizeof(word));
+        h = (h ^ mix(word)) * 0x100000001B3ull;
+    }
+
+    uint64_t    tail{0};
+
+    if (remaining)
+        std::memcpy(&tail, ptr, remaining);
+    return mix(h ^ tail);
+}
+
+SharedBytes BlobStore::intern(const SharedBytes &bytes)
+{
+    if (!bytes.pointer())
+        return bytes;
+
+    const auto  hash{content_hash(bytes.vector())};
+
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    _interned_bytes += bytes.size();
+
+    auto    range{_blobs.equal_range(hash)};
+
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second == bytes.pointer() || *it->second == bytes.vector())
+            return SharedBytes{it->second};
+
+    _blobs.emplace(hash, bytes.pointer());
+    _stored_bytes += bytes.size();
+
+    return bytes;
+}
+
+size_t BlobStore::blob_count() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    return _blobs.size();
+}
+
+uint64_t BlobStore::stored_bytes() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    return _stored_bytes;
+}
+
+uint64_t BlobStore::interned_bytes() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    return _interned_bytes;
+}
+
+size_t BlobStore::prune()
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    size_t                      count{0};
+
+    for (auto it = _blobs.begin(); it != _blobs.end(); )
+    {
+        if (it->second.use_count() == 1)
+        {
+            _stored_bytes -= it->second->size();
+            it = _blobs.erase(it);
+            ++count;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    return count;
+}
+
+void BlobStore::clear()
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    _blobs.clear();
+    _stored_bytes = 0;
+}
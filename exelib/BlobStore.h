@@ -0,0 +1,154 @@
+/// \file   BlobStore.h
+/// Provides shared, immutable byte containers and a content-addressed store
+/// that keeps a single copy of each distinct container.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_BLOBSTORE_H_
+#define _EXELIB_BLOBSTORE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "views.h"
+
+
+/// \brief  An immutable, reference-counted container of bytes.
+///
+/// Copying a SharedBytes object shares the bytes rather than copying them.
+/// The interface mirrors the read-only parts of \c std::vector<uint8_t>.
+class SharedBytes
+{
+public:
+    using const_iterator = std::vector<uint8_t>::const_iterator;
+
+    /// \brief  Construct an empty container.
+    SharedBytes() noexcept
+    {}
+
+    /// \brief  Construct a container from a vector of bytes, which is moved.
+    explicit SharedBytes(std::vector<uint8_t> &&bytes)
+      : _bytes{std::make_shared<const std::vector<uint8_t>>(std::move(bytes))}
+    {}
+
+    /// \brief  Construct a container sharing existing bytes.
+    explicit SharedBytes(std::shared_ptr<const std::vector<uint8_t>> bytes) noexcept
+      : _bytes{std::move(bytes)}
+    {}
+
+    /// \brief  Return a reference to the underlying vector of bytes.
+    const std::vector<uint8_t> &vector() const noexcept
+    {
+        return _bytes ? *_bytes : empty_vector();
+    }
+
+    /// \brief  Return the pointer through which the bytes are shared. May be null.
+    const std::shared_ptr<const std::vector<uint8_t>> &pointer() const noexcept
+    {
+        return _bytes;
+    }
+
+    const uint8_t *data() const noexcept
+    {
+        return vector().data();
+    }
+
+    size_t size() const noexcept
+    {
+        return vector().size();
+    }
+
+    bool empty() const noexcept
+    {
+        return vector().empty();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return vector().begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return vector().end();
+    }
+
+    uint8_t operator[](size_t pos) const noexcept
+    {
+        return vector()[pos];
+    }
+
+    /// \brief  Return a non-owning view of the bytes.
+    operator BytesView() const noexcept
+    {
+        return BytesView{vector()};
+    }
+
+private:
+    static const std::vector<uint8_t> &empty_vector() noexcept
+    {
+        static const std::vector<uint8_t>   empty;
+
+        return empty;
+    }
+
+    std::shared_ptr<const std::vector<uint8_t>> _bytes;
+};
+
+/// \brief  A content-addressed store of byte containers.
+///
+/// Containers with identical content, such as the same \c .rsrc section in
+/// many versions of a DLL, are stored once. The store holds a reference to
+/// each distinct container; the containers themselves are shared with the
+/// objects that interned them and live as long as any of them does.
+///
+/// An object that interns its data gives up its own copy whenever the store
+/// already has an identical one, and views of the old copy then dangle.
+/// Share an executable's data when it is loaded, as the ExeInfo constructor
+/// taking a store does, before any views are taken.
+///
+/// All member functions may be called concurrently from several threads.
+class BlobStore
+{
+public:
+    BlobStore() = default;
+    BlobStore(const BlobStore &) = delete;              ///< The copy constructor is deleted
+    BlobStore &operator=(const BlobStore &) = delete;   ///< The copy assignment operator is deleted
+
+    /// \brief  Return a container with the same content as \p bytes, which
+    ///         is the stored container if there is one and \p bytes otherwise.
+    SharedBytes intern(const SharedBytes &bytes);
+
+    /// \brief  Return the number of distinct containers in the store.
+    size_t blob_count() const;
+
+    /// \brief  Return the total size of the distinct containers in the store.
+    uint64_t stored_bytes() const;
+
+    /// \brief  Return the total size of all containers interned so far,
+    ///         counting each time a container was interned.
+    uint64_t interned_bytes() const;
+
+    /// \brief  Remove the containers that are referenced only by the store.
+    /// \return The number of containers removed.
+    size_t prune();
+
+    /// \brief  Remove every container from the store.
+    ///
+    /// Containers previously returned by #intern() remain valid.
+    void clear();
+
+private:
+    static uint64_t content_hash(const std::vector<uint8_t> &bytes) noexcept;
+
+    mutable std::mutex                                                          _mutex;
+    std::unordered_multimap<uint64_t, std::shared_ptr<const std::vector<uint8_t>>>  _blobs;
+    uint64_t                                                                    _stored_bytes{0};
+    uint64_t                                                                    _interned_bytes{0};
+};
+
+#endif  //_EXELIB_BLOBSTORE_H_
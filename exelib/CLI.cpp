@@ -4,121 +4,266 @@
 /// \author Jeff Bienstadt
 ///
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <exception>
+#include <functional>
 #include <istream>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "CliRelations.h"
+#include "CliTypeNames.h"
 #include "LoadOptions.h"
 #include "PEExe.h"
 #include "readers.h"
 
 namespace {
-// calculate the length of an entry in a #US or #Blob CLI metadata stream
-uint32_t get_blob_length(const std::vector<uint8_t> &bytes, size_t &bytes_read)
+template<typename T>
+inline unsigned count_set_bits(T value)
 {
-    uint32_t    len{0};
-    uint8_t     b1{bytes[bytes_read++]};
-
-    if ((b1 & 0b11100000) == 0b11000000)
-    {
-        // need four bytes for the length
-        uint8_t b2 = bytes[bytes_read++];
-        uint8_t b3 = bytes[bytes_read++];
-        uint8_t b4 = bytes[bytes_read++];
-
-        len =    ((static_cast<uint32_t>(b1) & 0b00011111) << 24)
-                | (static_cast<uint32_t>(b2) << 16)
-                | (static_cast<uint32_t>(b3) << 8)
-                | (static_cast<uint32_t>(b4));
-
-    }
-    else if ((b1 & 0b11000000) == 0b10000000)
-    {
-        // need two bytes for the length
-        uint8_t b2 = bytes[bytes_read++];
+    unsigned rv{0};
 
-        len = ((static_cast<uint32_t>(b1) & 0b00111111) << 8) | static_cast<uint32_t>(b2);
-    }
-    else if ((b1 & 0b10000000) == 0b00000000)
-    {
-        // one byte does it
-        len = b1;
-    }
-    else
-    {
-        // should never get here!!!
-        throw std::runtime_error("Length in #US or #Blob stream is invalid.");
-    }
+    for (T i = 0; i < sizeof(T) * 8; ++i)
+        if (value & (static_cast<T>(1) << i))
+            ++rv;
 
-    return len;
+    return rv;
 }
 
-// calculate the length of an entry in a #US or #Blob CLI metadata stream.
-// return a std::pair containing the length value and a pointer to the data
-// that follows the length byte(s).
-std::pair<uint32_t, const uint8_t *> get_blob_length(const uint8_t *ptr)
+template<typename T>
+inline bool is_bit_set(T value, int bit_number)
 {
-    uint32_t    len{0};
-    uint8_t     b1{*ptr++};
-
-    if ((b1 & 0b11100000) == 0b11000000)
-    {
-        // need four bytes for the length
-        uint8_t b2 = *ptr++;
-        uint8_t b3 = *ptr++;
-        uint8_t b4 = *ptr++;
+    return value & (static_cast<T>(1) << bit_number);
+}
 
-        len =    ((static_cast<uint32_t>(b1) & 0b00011111) << 24)
-                | (static_cast<uint32_t>(b2) << 16)
-                | (static_cast<uint32_t>(b3) << 8)
-                | (static_cast<uint32_t>(b4));
+// When the metadata tables are decoded on several threads, large tables
+// are divided into blocks of this many rows.
+constexpr uint32_t rows_per_job{8192};
 
-    }
-    else if ((b1 & 0b11000000) == 0b10000000)
-    {
-        // need two bytes for the length
-        uint8_t b2 = *ptr++;
+// The bit of the heap_sizes member of the tables stream header indicating
+// that four bytes of extra data follow the row counts.
+constexpr uint8_t heap_sizes_extra_data{0x40};
 
-        len = ((static_cast<uint32_t>(b1) & 0b00111111) << 8) | static_cast<uint32_t>(b2);
-    }
-    else if ((b1 & 0b10000000) == 0b00000000)
-    {
-        // one byte does it
-        len = b1;
-    }
-    else
-    {
-        // should never get here!!!
-        throw std::runtime_error("Length in #US or #Blob stream is invalid.");
-    }
+// Marks an unused tag value in a coded index.
+constexpr uint8_t no_table{0xFF};
 
-    return {len, ptr};
+constexpr uint8_t table_id(PeCliMetadataTableId id)
+{
+    return static_cast<uint8_t>(id);
 }
 
-
-template<typename T>
-inline unsigned count_set_bits(T value)
+// Describes the tables that a coded index can reference. ECMA-335, section II.24.2.6.
+struct CodedIndexDefinition
 {
-    unsigned rv{0};
-
-    for (T i = 0; i < sizeof(T) * 8; ++i)
-        if (value & (static_cast<T>(1) << i))
-            ++rv;
+    const char *name;
+    uint8_t     tag_bits;
+    uint8_t     table_count;
+    uint8_t     tables[27];     // indexed by tag
+};
+
+// In the order of PeCliEncodedIndexType.
+constexpr CodedIndexDefinition coded_index_definitions[] =
+{
+    {"TypeDefOrRef", 2, 3, {table_id(PeCliMetadataTableId::TypeDef),
+                            table_id(PeCliMetadataTableId::TypeRef),
+                            table_id(PeCliMetadataTableId::TypeSpec)}},
+    {"HasConstant", 2, 3, {table_id(PeCliMetadataTableId::Field),
+                           table_id(PeCliMetadataTableId::Param),
+                           table_id(PeCliMetadataTableId::Property)}},
+    {"HasCustomAttribute", 5, 22, {table_id(PeCliMetadataTableId::MethodDef),
+                                   table_id(PeCliMetadataTableId::Field),
+                                   table_id(PeCliMetadataTableId::TypeRef),
+                                   table_id(PeCliMetadataTableId::TypeDef),
+                                   table_id(PeCliMetadataTableId::Param),
+                                   table_id(PeCliMetadataTableId::InterfaceImpl),
+                                   table_id(PeCliMetadataTableId::MemberRef),
+                                   table_id(PeCliMetadataTableId::Module),
+                                   no_table,    // "Permission", which is not a table
+                                   table_id(PeCliMetadataTableId::Property),
+                                   table_id(PeCliMetadataTableId::Event),
+                                   table_id(PeCliMetadataTableId::StandAloneSig),
+                                   table_id(PeCliMetadataTableId::ModuleRef),
+                                   table_id(PeCliMetadataTableId::TypeSpec),
+                                   table_id(PeCliMetadataTableId::Assembly),
+                                   table_id(PeCliMetadataTableId::AssemblyRef),
+                                   table_id(PeCliMetadataTableId::File),
+                                   table_id(PeCliMetadataTableId::ExportedType),
+                                   table_id(PeCliMetadataTableId::ManifestResource),
+                                   table_id(PeCliMetadataTableId::GenericParam),
+                                   table_id(PeCliMetadataTableId::GenericParamConstraint),
+                                   table_id(PeCliMetadataTableId::MethodSpec)}},
+    {"HasFieldMarshall", 1, 2, {table_id(PeCliMetadataTableId::Field),
+                                table_id(PeCliMetadataTableId::Param)}},
+    {"HasDeclSecurity", 2, 3, {table_id(PeCliMetadataTableId::TypeDef),
+                               table_id(PeCliMetadataTableId::MethodDef),
+                               table_id(PeCliMetadataTableId::Assembly)}},
+    {"MemberRefParent", 3, 5, {table_id(PeCliMetadataTableId::TypeDef),
+                               table_id(PeCliMetadataTableId::TypeRef),
+                               table_id(PeCliMetadataTableId::ModuleRef),
+                               table_id(PeCliMetadataTableId::MethodDef),
+                               table_id(PeCliMetadataTableId::TypeSpec)}},
+    {"HasSemantics", 1, 2, {table_id(PeCliMetadataTableId::Event),
+                            table_id(PeCliMetadataTableId::Property)}},
+    {"MethodDefOrRef", 1, 2, {table_id(PeCliMetadataTableId::MethodDef),
+                              table_id(PeCliMetadataTableId::MemberRef)}},
+    {"MemberForwarded", 1, 2, {table_id(PeCliMetadataTableId::Field),
+                               table_id(PeCliMetadataTableId::MethodDef)}},
+    {"Implementation", 2, 3, {table_id(PeCliMetadataTableId::File),
+                              table_id(PeCliMetadataTableId::AssemblyRef),
+                              table_id(PeCliMetadataTableId::ExportedType)}},
+    {"CustomAttributeType", 3, 5, {no_table,
+                                   no_table,
+                                   table_id(PeCliMetadataTableId::MethodDef),
+                                   table_id(PeCliMetadataTableId::MemberRef),
+                                   no_table}},
+    {"ResolutionScope", 2, 4, {table_id(PeCliMetadataTableId::Module),
+                               table_id(PeCliMetadataTableId::ModuleRef),
+                               table_id(PeCliMetadataTableId::AssemblyRef),
+                               table_id(PeCliMetadataTableId::TypeRef)}},
+    {"TypeOrMethodDef", 1, 2, {table_id(PeCliMetadataTableId::TypeDef),
+                               table_id(PeCliMetadataTableId::MethodDef)}},
+    // Portable PDB specification, "CustomDebugInformation Table".
+    {"HasCustomDebugInformation", 5, 27, {table_id(PeCliMetadataTableId::MethodDef),
+                                          table_id(PeCliMetadataTableId::Field),
+                                          table_id(PeCliMetadataTableId::TypeRef),
+                                          table_id(PeCliMetadataTableId::TypeDef),
+                                          table_id(PeCliMetadataTableId::Param),
+                                          table_id(PeCliMetadataTableId::InterfaceImpl),
+                                          table_id(PeCliMetadataTableId::MemberRef),
+                                          table_id(PeCliMetadataTableId::Module),
+                                          table_id(PeCliMetadataTableId::DeclSecurity),
+                                          table_id(PeCliMetadataTableId::Property),
+                                          table_id(PeCliMetadataTableId::Event),
+                                          table_id(PeCliMetadataTableId::StandAloneSig),
+                                          table_id(PeCliMetadataTableId::ModuleRef),
+                                          table_id(PeCliMetadataTableId::TypeSpec),
+                                          table_id(PeCliMetadataTableId::Assembly),
+                                          table_id(PeCliMetadataTableId::AssemblyRef),
+                                          table_id(PeCliMetadataTableId::File),
+                                          table_id(PeCliMetadataTableId::ExportedType),
+                                          table_id(PeCliMetadataTableId::ManifestResource),
+                                          table_id(PeCliMetadataTableId::GenericParam),
+                                          table_id(PeCliMetadataTableId::GenericParamConstraint),
+                                          table_id(PeCliMetadataTableId::MethodSpec),
+                                          table_id(PeCliMetadataTableId::Document),
+                                          table_id(PeCliMetadataTableId::LocalScope),
+                                          table_id(PeCliMetadataTableId::LocalVariable),
+                                          table_id(PeCliMetadataTableId::LocalConstant),
+                                          table_id(PeCliMetadataTableId::ImportScope)}}
+};
+
+// Shorthand for the column descriptions below.
+constexpr PeCliColumn u8{PeCliColumnKind::UInt8, 0};
+constexpr PeCliColumn u16{PeCliColumnKind::UInt16, 0};
+constexpr PeCliColumn u32{PeCliColumnKind::UInt32, 0};
+constexpr PeCliColumn str{PeCliColumnKind::StringIndex, 0};
+constexpr PeCliColumn guid{PeCliColumnKind::GuidIndex, 0};
+constexpr PeCliColumn blob{PeCliColumnKind::BlobIndex, 0};
+
+constexpr PeCliColumn table_index(PeCliMetadataTableId id)
+{
+    return {PeCliColumnKind::TableIndex, static_cast<uint8_t>(id)};
+}
 
-    return rv;
+constexpr PeCliColumn coded(PeCliEncodedIndexType type)
+{
+    return {PeCliColumnKind::CodedIndex, static_cast<uint8_t>(type)};
 }
 
-template<typename T>
-inline bool is_bit_set(T value, int bit_number)
+constexpr PeCliColumn list(PeCliMetadataTableId id)
 {
-    return value & (static_cast<T>(1) << bit_number);
+    return {PeCliColumnKind::ListIndex, static_cast<uint8_t>(id)};
 }
 
+// The columns of a table. ECMA-335, sections II.22.2 through II.22.39, and
+// the Portable PDB specification. The Ptr, ENCLog, and ENCMap tables are
+// not described by ECMA-335; their layout is that used by the CLR.
+struct TableDefinition
+{
+    uint8_t     column_count;   // zero if the table is not known
+    PeCliColumn columns[PeCliMetadataTableLayout::max_columns];
+};
+
+// Indexed by table identifier.
+constexpr TableDefinition table_definitions[] =
+{
+    /* 0x00 Module          */  {5, {u16, str, guid, guid, guid}},
+    /* 0x01 TypeRef         */  {3, {coded(PeCliEncodedIndexType::ResolutionScope), str, str}},
+    /* 0x02 TypeDef         */  {6, {u32, str, str, coded(PeCliEncodedIndexType::TypeDefOrRef),
+                                     list(PeCliMetadataTableId::Field), list(PeCliMetadataTableId::MethodDef)}},
+    /* 0x03 FieldPtr        */  {1, {table_index(PeCliMetadataTableId::Field)}},
+    /* 0x04 Field           */  {3, {u16, str, blob}},
+    /* 0x05 MethodPtr       */  {1, {table_index(PeCliMetadataTableId::MethodDef)}},
+    /* 0x06 MethodDef       */  {6, {u32, u16, u16, str, blob, list(PeCliMetadataTableId::Param)}},
+    /* 0x07 ParamPtr        */  {1, {table_index(PeCliMetadataTableId::Param)}},
+    /* 0x08 Param           */  {3, {u16, u16, str}},
+    /* 0x09 InterfaceImpl   */  {2, {table_index(PeCliMetadataTableId::TypeDef), coded(PeCliEncodedIndexType::TypeDefOrRef)}},
+    /* 0x0A MemberRef       */  {3, {coded(PeCliEncodedIndexType::MemberRefParent), str, blob}},
+    /* 0x0B Constant        */  {4, {u8, u8, coded(PeCliEncodedIndexType::HasConstant), blob}},
+    /* 0x0C CustomAttribute */  {3, {coded(PeCliEncodedIndexType::HasCustomAttribute),
+                                     coded(PeCliEncodedIndexType::CustomAttributeType), blob}},
+    /* 0x0D FieldMarshal    */  {2, {coded(PeCliEncodedIndexType::HasFieldMarshall), blob}},
+    /* 0x0E DeclSecurity    */  {3, {u16, coded(PeCliEncodedIndexType::HasDeclSecurity), blob}},
+    /* 0x0F ClassLayout     */  {3, {u16, u32, table_index(PeCliMetadataTableId::TypeDef)}},
+    /* 0x10 FieldLayout     */  {2, {u32, table_index(PeCliMetadataTableId::Field)}},
+    /* 0x11 StandAloneSig   */  {1, {blob}},
+    /* 0x12 EventMap        */  {2, {table_index(PeCliMetadataTableId::TypeDef), list(PeCliMetadataTableId::Event)}},
+    /* 0x13 EventPtr        */  {1, {table_index(PeCliMetadataTableId::Event)}},
+    /* 0x14 Event           */  {3, {u16, str, coded(PeCliEncodedIndexType::TypeDefOrRef)}},
+    /* 0x15 PropertyMap     */  {2, {table_index(PeCliMetadataTableId::TypeDef), list(PeCliMetadataTableId::Property)}},
+    /* 0x16 PropertyPtr     */  {1, {table_index(PeCliMetadataTableId::Property)}},
+    /* 0x17 Property        */  {3, {u16, str, blob}},
+    /* 0x18 MethodSemantics */  {3, {u16, table_index(PeCliMetadataTableId::MethodDef), coded(PeCliEncodedIndexType::HasSemantics)}},
+    /* 0x19 MethodImpl      */  {3, {table_index(PeCliMetadataTableId::TypeDef), coded(PeCliEncodedIndexType::MethodDefOrRef),
+                                     coded(PeCliEncodedIndexType::MethodDefOrRef)}},
+    /* 0x1A ModuleRef       */  {1, {str}},
+    /* 0x1B TypeSpec        */  {1, {blob}},
+    /* 0x1C ImplMap         */  {4, {u16, coded(PeCliEncodedIndexType::MemberForwarded), str, table_index(PeCliMetadataTableId::ModuleRef)}},
+    /* 0x1D FieldRVA        */  {2, {u32, table_index(PeCliMetadataTableId::Field)}},
+    /* 0x1E ENCLog          */  {2, {u32, u32}},
+    /* 0x1F ENCMap          */  {1, {u32}},
+    /* 0x20 Assembly        */  {9, {u32, u16, u16, u16, u16, u32, blob, str, str}},
+    /* 0x21 AssemblyProcessor */    {1, {u32}},
+    /* 0x22 AssemblyOS      */  {3, {u32, u32, u32}},
+    /* 0x23 AssemblyRef     */  {9, {u16, u16, u16, u16, u32, blob, str, str, blob}},
+    /* 0x24 AssemblyRefProcessor */ {2, {u32, table_index(PeCliMetadataTableId::AssemblyRef)}},
+    /* 0x25 AssemblyRefOS   */  {4, {u32, u32, u32, table_index(PeCliMetadataTableId::AssemblyRef)}},
+    /* 0x26 File            */  {3, {u32, str, blob}},
+    /* 0x27 ExportedType    */  {5, {u32, u32, str, str, coded(PeCliEncodedIndexType::Implementation)}},
+    /* 0x28 ManifestResource */ {4, {u32, u32, str, coded(PeCliEncodedIndexType::Implementation)}},
+    /* 0x29 NestedClass     */  {2, {table_index(PeCliMetadataTableId::TypeDef), table_index(PeCliMetadataTableId::TypeDef)}},
+    /* 0x2A GenericParam    */  {4, {u16, u16, coded(PeCliEncodedIndexType::TypeOrMethodDef), str}},
+    /* 0x2B MethodSpec      */  {2, {coded(PeCliEncodedIndexType::MethodDefOrRef), blob}},
+    /* 0x2C GenericParamConstraint */   {2, {table_index(PeCliMetadataTableId::GenericParam), coded(PeCliEncodedIndexType::TypeDefOrRef)}},
+    /* 0x2D                 */  {},
+    /* 0x2E                 */  {},
+    /* 0x2F                 */  {},
+    /* 0x30 Document        */  {4, {blob, guid, blob, guid}},
+    /* 0x31 MethodDebugInformation */   {2, {table_index(PeCliMetadataTableId::Document), blob}},
+    /* 0x32 LocalScope      */  {6, {table_index(PeCliMetadataTableId::MethodDef), table_index(PeCliMetadataTableId::ImportScope),
+                                     list(PeCliMetadataTableId::LocalVariable), list(PeCliMetadataTableId::LocalConstant), u32, u32}},
+    /* 0x33 LocalVariable   */  {3, {u16, u16, str}},
+    /* 0x34 LocalConstant   */  {2, {str, blob}},
+    /* 0x35 ImportScope     */  {2, {table_index(PeCliMetadataTableId::ImportScope), blob}},
+    /* 0x36 StateMachineMethod */   {2, {table_index(PeCliMetadataTableId::MethodDef), table_index(PeCliMetadataTableId::MethodDef)}},
+    /* 0x37 CustomDebugInformation */   {3, {coded(PeCliEncodedIndexType::HasCustomDebugInformation), guid, blob}}
+};
+
+
 }   // end of anonymous namespace
 
 
+PeCliMetadata::PeCliMetadata() = default;
+
+// Defined here, where PeCliTypeNameIndex is a complete type.
+PeCliMetadata::~PeCliMetadata() = default;
+
 void PeCliMetadata::load(std::istream &stream, LoadOptions::Options options)
 {
     auto    metadata_header_pos{stream.tellg()};
@@ -146,8 +291,9 @@ void PeCliMetadata::load(std::istream &stream, LoadOptions::Options options)
 
         _stream_headers.push_back(header);
     }
+    resolve_streams();
 
-    if (options | LoadOptions::LoadCliMetadataStreams)
+    if ((options & LoadOptions::LoadCliMetadataStreams) == LoadOptions::LoadCliMetadataStreams)
     {
         // Load the metadata streams.
         // There are member functions to interpret the #Strings, #US, #GUID, and #~ streams.
@@ -159,11 +305,13 @@ void PeCliMetadata::load(std::istream &stream, LoadOptions::Options options)
             stream.seekg(metadata_header_pos + static_cast<std::streamoff>(_stream_headers[i].offset));
             stream.read(reinterpret_cast<char *>(&stream_bytes[0]), _stream_headers[i].size);
 
-            _streams.push_back(std::move(stream_bytes));
+            _streams.emplace_back(std::move(stream_bytes));
         }
 
-        if (options | LoadOptions::LoadCliMetadataTables)
-            load_metadata_tables();
+        update_stream_views();
+        load_pdb_stream();
+        load_metadata_tables((options & LoadOptions::LoadCliMetadataTables) == LoadOptions::LoadCliMetadataTables,
+                             (options & LoadOptions::LoadCliTablesConcurrently) == LoadOptions::LoadCliTablesConcurrently);
     }
 }
 
@@ -171,11 +319,10 @@ void PeCliMetadata::load(std::istream &stream, LoadOptions::Options options)
 std::vector<std::string> PeCliMetadata::get_strings_heap_strings() const
 {
     std::vector<std::string>    rv;
-    const auto                 *pstream{get_stream("#Strings")};
+    const auto                  bytes{stream(PeCliStreamId::Strings)};
 
-    if (pstream && pstream->size())
+    if (bytes.size())
     {
-        const auto &bytes{*pstream};
         size_t  bytes_read{0};
 
         std::string str;
@@ -200,27 +347,26 @@ std::vector<std::string> PeCliMetadata::get_strings_heap_strings() const
 
 std::string PeCliMetadata::get_string(uint32_t index) const
 {
-    const auto *pstream{get_stream("#Strings")};
-
-    if (pstream)
-    {
-        const auto &bytes{*pstream};
+    return get_string_view(index).str();
+}
 
-        return {reinterpret_cast<const char *>(&bytes[index])};
-    }
+StringView PeCliMetadata::get_string_view(uint32_t index) const
+{
+    if (_strings_heap.empty())
+        return {};
 
-    return {};
+    return _strings_heap.entry_at(index).value;
 }
 
 
 Guid PeCliMetadata::get_guid(uint32_t index) const
 {
     Guid        guid{};
-    const auto *pstream{get_stream("#GUID")};
+    const auto  heap{stream(PeCliStreamId::Guid)};
 
-    if (pstream)
+    if (heap.size())
     {
-        BytesReader reader{*pstream};
+        BytesReader reader{heap};
 
         reader.seek((index - 1) * sizeof(Guid));
 
@@ -235,73 +381,25 @@ Guid PeCliMetadata::get_guid(uint32_t index) const
 
 const std::vector<uint8_t> PeCliMetadata::get_blob(uint32_t index) const
 {
-    const auto  *pstream{get_stream("#Blob")};
+    auto    view{get_blob_view(index)};
 
-    if (pstream && pstream->size())
-    {
-        if (index >= pstream->size())
-            throw std::out_of_range("get_blob: index out of range.");
-
-        auto    pair{get_blob_length(pstream->data() + index)};
-        auto    len{pair.first};
-        auto    begin{pair.second};
-        auto    end{begin + len};
+    return {view.begin(), view.end()};
+}
 
-        return {begin, end};
-    }
+BytesView PeCliMetadata::get_blob_view(uint32_t index) const
+{
+    if (_blob_heap.empty())
+        return {};
 
-    return {};
+    return _blob_heap.entry_at(index).value;
 }
 
 std::vector<std::u16string> PeCliMetadata::get_us_heap_strings() const
 {
     std::vector<std::u16string> rv;
-    const auto                 *pstream{get_stream("#US")};
-
-    if (pstream && pstream->size())
-    {
-        const auto     &bytes{*pstream};
-        size_t          bytes_read{0};
-        std::u16string  str;
-
-        while (bytes_read < bytes.size())
-        {
-            uint32_t    len{get_blob_length(bytes, bytes_read)};
-            char16_t    ch;
-
-            // read len bytes
-            for (uint32_t i = 0; i < len; ++i)
-            {
-                if ((i & 0x01) == 0)    // either the start of a UTF-16 character, or the ending byte
-                {
-                    if (i == len-1)
-                    {
-                        // at the last byte, ignore it
-                        ++bytes_read;
-                        //TODO: This byte should not be ignored. It has meaning, but I haven't decided what to do about it yet.
-                        //      From ECMA-335, 6th edition:
-                        //          This final byte holds the value 1 if and only if any UTF16 character within the string
-                        //          has any bit set in its top byte, or its low byte is any of the following: 0x01–0x08,
-                        //          0x0E–0x1F, 0x27, 0x2D, 0x7F. Otherwise, it holds 0. The 1 signifies Unicode characters
-                        //          that require handling beyond that normally provided for 8-bit encoding sets.
-                    }
-                    else
-                    {
-                        // read the first byte of the character
-                        ch = static_cast<char16_t>(bytes[bytes_read++]);
-                    }
-                }
-                else
-                {
-                    // read the second byte of the character
-                    ch |= (static_cast<char16_t>(bytes[bytes_read++])) << 8;
-                    str.push_back(ch);
-                }
-            }
 
-            rv.push_back(std::move(str));
-        }
-    }
+    for (const auto &entry : _user_strings_heap)
+        rv.push_back(entry.str());
 
     return rv;
 }
@@ -309,30 +407,9 @@ std::vector<std::u16string> PeCliMetadata::get_us_heap_strings() const
 std::vector<std::vector<uint8_t>> PeCliMetadata::get_blob_heap_blobs() const
 {
     std::vector<std::vector<uint8_t>>   rv;
-    const auto                         *pstream{get_stream("#Blob")};
 
-    if (pstream && pstream->size())
-    {
-        const auto             &bytes{*pstream};
-        size_t                  bytes_read{0};
-        std::vector<uint8_t>    vec;
-
-        while (bytes_read < bytes.size())
-        {
-            uint32_t    len{get_blob_length(bytes, bytes_read)};
-
-            vec.reserve(len);
-
-            // read len bytes
-            for (uint32_t i = 0; i < len; ++i)
-            {
-                // read and store the byte
-                vec.push_back(bytes[bytes_read++]);
-            }
-
-            rv.push_back(std::move(vec));
-        }
-    }
+    for (const auto &entry : _blob_heap)
+        rv.emplace_back(entry.value.begin(), entry.value.end());
 
     return rv;
 }
@@ -340,11 +417,11 @@ std::vector<std::vector<uint8_t>> PeCliMetadata::get_blob_heap_blobs() const
 std::vector<Guid> PeCliMetadata::get_guid_heap_guids() const
 {
     std::vector<Guid>   rv;
-    const auto         *pstream{get_stream("#GUID")};
+    const auto          heap{stream(PeCliStreamId::Guid)};
 
-    if (pstream)
+    if (heap.size())
     {
-        BytesReader reader{*pstream};
+        BytesReader reader{heap};
         size_t      num_guids{reader.size() / sizeof(Guid)};
 
         rv.reserve(num_guids);
@@ -364,889 +441,645 @@ std::vector<Guid> PeCliMetadata::get_guid_heap_guids() const
     return rv;
 }
 
-void PeCliMetadata::load_metadata_tables()
+void PeCliMetadata::resolve_streams()
 {
-    if (!_tables)
+    static const struct
+    {
+        PeCliStreamId   id;
+        const char     *name;
+    } names[] =
     {
-        const auto *pstream{get_stream("#~")};
+        {PeCliStreamId::Tables,         "#~"},
+        {PeCliStreamId::Tables,         "#-"},
+        {PeCliStreamId::Strings,        "#Strings"},
+        {PeCliStreamId::UserStrings,    "#US"},
+        {PeCliStreamId::Guid,           "#GUID"},
+        {PeCliStreamId::Blob,           "#Blob"},
+        {PeCliStreamId::Pdb,            "#Pdb"}
+    };
+
+    for (auto &index : _stream_indexes)
+        index = -1;
 
-        if (pstream)
+    // If a name appears more than once, the first stream with that name is used.
+    for (size_t i = 0; i < _stream_headers.size(); ++i)
+    {
+        for (const auto &entry : names)
         {
-            BytesReader reader{*pstream};
+            auto   &index{_stream_indexes[static_cast<size_t>(entry.id)]};
 
-            if (reader.size())
-            {
-                _tables = std::make_unique<PeCliMetadataTables>();
-                _tables->load(reader);
-            }
+            if (index < 0 && _stream_headers[i].name == entry.name)
+                index = static_cast<int>(i);
         }
     }
 }
 
-PeCliMetadataTableIndex PeCliMetadata::decode_index(PeCliEncodedIndexType type, uint32_t index) const
+void PeCliMetadata::update_stream_views()
 {
-    PeCliMetadataTableIndex rv{};
-
-    switch (type)
+    for (size_t i = 0; i < stream_id_count; ++i)
     {
-        case PeCliEncodedIndexType::TypeDefOrRef:           // 2 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::TypeDef,
-                                                            PeCliMetadataTableId::TypeRef,
-                                                            PeCliMetadataTableId::TypeSpec
-                                                        };
-
-                if ((index & 0b11) > 2)
-                    throw std::runtime_error("Invalid table type value encoded into 'TypeDefOrRef' index.");
-                rv.table_id = ids[index & 0b11];
-                rv.index = index >> 2;
-            }
-            break;
-        case PeCliEncodedIndexType::HasConstant:            // 2 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::Field,
-                                                            PeCliMetadataTableId::Param,
-                                                            PeCliMetadataTableId::Property
-                                                        };
-                if ((index & 0b11) > 2)
-                    throw std::runtime_error("Invalid table type value encoded into 'HasConstant' index.");
-                rv.table_id = ids[index & 0b11];
-                rv.index = index >> 2;
-            }
-            break;
-        case PeCliEncodedIndexType::HasCustomAttribute:     // 5 bits to decode tag
-            {
-                uint32_t    ndx = (index & 0b11111);
-
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::MethodDef,
-                                                            PeCliMetadataTableId::Field,
-                                                            PeCliMetadataTableId::TypeRef,
-                                                            PeCliMetadataTableId::TypeDef,
-                                                            PeCliMetadataTableId::Param,
-                                                            PeCliMetadataTableId::InterfaceImpl,
-                                                            PeCliMetadataTableId::MemberRef,
-                                                            PeCliMetadataTableId::Module,
-                                                            PeCliMetadataTableId::Module,   //!!! Just a placeholder! We will never index this element of the array!
-                                                            PeCliMetadataTableId::Property,
-                                                            PeCliMetadataTableId::Event,
-                                                            PeCliMetadataTableId::StandAloneSig,
-                                                            PeCliMetadataTableId::ModuleRef,
-                                                            PeCliMetadataTableId::TypeSpec,
-                                                            PeCliMetadataTableId::Assembly,
-                                                            PeCliMetadataTableId::AssemblyRef,
-                                                            PeCliMetadataTableId::File,
-                                                            PeCliMetadataTableId::ExportedType,
-                                                            PeCliMetadataTableId::ManifestResource,
-                                                            PeCliMetadataTableId::GenericParam,
-                                                            PeCliMetadataTableId::GenericParamConstraint,
-                                                            PeCliMetadataTableId::MethodSpec
-                                                        };
-                // ECMA-335 specifies 22 tables encoded into this type of index.
-                // However it includes number 8 as a "Permission" table, which
-                // does not exist anywhere else in the spec. For now it is an error.
-                if (ndx > 21 || ndx == 8)
-                    throw std::runtime_error("Invalid table type value encoded into 'HasCustomAttribute' index.");
-                rv.table_id = ids[ndx];
-                rv.index = index >> 5;
-            }
-            break;
-        case PeCliEncodedIndexType::HasFieldMarshall:       // 1 bit to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::Field,
-                                                            PeCliMetadataTableId::Param
-                                                        };
-                rv.table_id = ids[index & 0b1];
-                rv.index = index >> 1;
-            }
-            break;
-        case PeCliEncodedIndexType::HasDeclSecurity:        // 2 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::TypeDef,
-                                                            PeCliMetadataTableId::MethodDef,
-                                                            PeCliMetadataTableId::Assembly
-                                                        };
-                if ((index & 0b11) > 2)
-                    throw std::runtime_error("Invalid table type value encoded into 'HasDeclSecurity' index.");
-                rv.table_id = ids[index & 0b11];
-                rv.index = index >> 2;
-            }
-            break;
-        case PeCliEncodedIndexType::MemberRefParent:        // 3 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::TypeDef,
-                                                            PeCliMetadataTableId::TypeRef,
-                                                            PeCliMetadataTableId::ModuleRef,
-                                                            PeCliMetadataTableId::MethodDef,
-                                                            PeCliMetadataTableId::TypeSpec
-                                                        };
-                if ((index & 0b111) > 4)
-                    throw std::runtime_error("Invalid table type value encoded into 'MemberRefParent' index.");
-                rv.table_id = ids[index & 0b111];
-                rv.index = index >> 3;
-            }
-            break;
-        case PeCliEncodedIndexType::HasSemantics:           // 1 bit to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::Event,
-                                                            PeCliMetadataTableId::Property
-                                                        };
-                rv.table_id = ids[index & 0b1];
-                rv.index = index >> 1;
-            }
-            break;
-        case PeCliEncodedIndexType::MethodDefOrRef:         // 1 bit to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::MethodDef,
-                                                            PeCliMetadataTableId::MemberRef
-                                                        };
-                rv.table_id = ids[index & 0b1];
-                rv.index = index >> 1;
-            }
-            break;
-        case PeCliEncodedIndexType::MemberForwarded:        // 1 bit to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::Field,
-                                                            PeCliMetadataTableId::MethodDef
-                                                        };
-                rv.table_id = ids[index & 0b1];
-                rv.index = index >> 1;
-            }
-            break;
-        case PeCliEncodedIndexType::Implementation:         // 2 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::File,
-                                                            PeCliMetadataTableId::AssemblyRef,
-                                                            PeCliMetadataTableId::ExportedType
-                                                        };
-                if ((index & 0b11) > 2)
-                    throw std::runtime_error("Invalid table type value encoded into 'Implementation' index.");
-                rv.table_id = ids[index & 0b11];
-                rv.index = index >> 2;
-            }
-            break;
-        case PeCliEncodedIndexType::CustomAttributeType:    // 3 bits to decode tag
-            {
-                switch (index & 0b111)
-                {
-                    case 0:     // In the spec as unused
-                    case 1:     // In the spec as unused
-                    case 4:     // In the spec as unused
-                    default:
-                        throw std::runtime_error("Invalid table type value encoded into 'CustomAttributeType' index.");
-                        break;
-                    case 2:
-                        rv.table_id = PeCliMetadataTableId::MethodDef;
-                        break;
-                    case 3:
-                        rv.table_id = PeCliMetadataTableId::MemberRef;
-                        break;
-                };
-                rv.index = index >> 3;
-            }
-            break;
-        case PeCliEncodedIndexType::ResolutionScope:        // 2 bits to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::Module,
-                                                            PeCliMetadataTableId::ModuleRef,
-                                                            PeCliMetadataTableId::AssemblyRef,
-                                                            PeCliMetadataTableId::TypeRef
-                                                        };
-                rv.table_id = ids[index & 0b11];
-                rv.index = index >> 2;
-            }
-            break;
-        case PeCliEncodedIndexType::TypeOrMethodDef:        // 1 bit to decode tag
-            {
-                constexpr PeCliMetadataTableId ids[] =  {
-                                                            PeCliMetadataTableId::TypeDef,
-                                                            PeCliMetadataTableId::MethodDef
-                                                        };
-                rv.table_id = ids[index & 0b1];
-                rv.index = index >> 1;
-            }
-            break;
-        default:
-            throw std::runtime_error("Unrecognized encoded index type");    // This should never happen
-    };
+        const auto  index{_stream_indexes[i]};
 
-    return rv;
+        _stream_views[i] = index >= 0 && static_cast<size_t>(index) < _streams.size()
+                         ? BytesView{_streams[index]}
+                         : BytesView{};
+    }
+
+    _strings_heap._bytes = stream(PeCliStreamId::Strings);
+    _user_strings_heap._bytes = stream(PeCliStreamId::UserStrings);
+    _blob_heap._bytes = stream(PeCliStreamId::Blob);
 }
 
-bool PeCliMetadataTables::needs_wide_index(PeCliMetadataTableId id, uint32_t threshold /* = 65535 */)
+void PeCliMetadata::load_pdb_stream()
 {
-    for (size_t i = 0; i < _valid_table_types.size(); ++i)
-        if (_valid_table_types[i] == id)
-            if (_header.row_counts[i] > threshold)
-                return true;
+    const auto  bytes{stream(PeCliStreamId::Pdb)};
 
-    return false;
-}
+    if (!_pdb && bytes.size())
+    {
+        BytesReader reader{bytes};
+        auto        pdb{std::make_unique<PeCliPdbStream>()};
 
-bool PeCliMetadataTables::needs_wide_index(const std::vector<PeCliMetadataTableId> &ids, uint32_t threshold)
-{
-    for (auto id : ids)
-        if (needs_wide_index(id, threshold))
-            return true;
+        reader.read(pdb->pdb_id, sizeof(pdb->pdb_id));
+        reader.read(pdb->entry_point);
+        reader.read(pdb->referenced_type_system_tables);
 
-    return false;
-}
+        const unsigned  count{count_set_bits(pdb->referenced_type_system_tables)};
 
-bool PeCliMetadataTables::needs_wide_index(PeCliEncodedIndexType index_type)
-{
-    constexpr uint32_t  threshold{65536};
+        pdb->type_system_table_rows.reserve(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            uint32_t    rows;
 
-    switch (index_type)
-    {
-        case PeCliEncodedIndexType::TypeDefOrRef:
-            return needs_wide_index({PeCliMetadataTableId::TypeDef, PeCliMetadataTableId::TypeRef, PeCliMetadataTableId::TypeSpec}, threshold >> 2);
-        case PeCliEncodedIndexType::HasConstant:
-            return needs_wide_index({PeCliMetadataTableId::Field, PeCliMetadataTableId::Param, PeCliMetadataTableId::Property}, threshold >> 2);
-        case PeCliEncodedIndexType::HasCustomAttribute:
-            return needs_wide_index({PeCliMetadataTableId::MethodDef,
-                                     PeCliMetadataTableId::Field,
-                                     PeCliMetadataTableId::TypeRef,
-                                     PeCliMetadataTableId::TypeDef,
-                                     PeCliMetadataTableId::Param,
-                                     PeCliMetadataTableId::InterfaceImpl,
-                                     PeCliMetadataTableId::MemberRef,
-                                     PeCliMetadataTableId::Module,
-                                     //PeCliMetadataTableId::Permission,    // page 274 of the ECMA-355 document *appears* to say that this is a table, but there is no other reference to it as a table.
-                                     PeCliMetadataTableId::Property,
-                                     PeCliMetadataTableId::Event,
-                                     PeCliMetadataTableId::StandAloneSig,
-                                     PeCliMetadataTableId::ModuleRef,
-                                     PeCliMetadataTableId::TypeSpec,
-                                     PeCliMetadataTableId::Assembly,
-                                     PeCliMetadataTableId::AssemblyRef,
-                                     PeCliMetadataTableId::File,
-                                     PeCliMetadataTableId::ExportedType,
-                                     PeCliMetadataTableId::ManifestResource,
-                                     PeCliMetadataTableId::GenericParam,
-                                     PeCliMetadataTableId::GenericParamConstraint,
-                                     PeCliMetadataTableId::MethodSpec
-                                    }, threshold >> 5);
-        case PeCliEncodedIndexType::HasFieldMarshall:
-            return needs_wide_index({PeCliMetadataTableId::Field, PeCliMetadataTableId::Param}, threshold >> 1);
-        case PeCliEncodedIndexType::HasDeclSecurity:
-            return needs_wide_index({PeCliMetadataTableId::TypeDef, PeCliMetadataTableId::MethodDef, PeCliMetadataTableId::Assembly}, threshold >> 2);
-        case PeCliEncodedIndexType::MemberRefParent:
-            return needs_wide_index({PeCliMetadataTableId::TypeDef,
-                                     PeCliMetadataTableId::TypeRef,
-                                     PeCliMetadataTableId::ModuleRef,
-                                     PeCliMetadataTableId::MethodDef,
-                                     PeCliMetadataTableId::TypeSpec
-                                    }, threshold >> 3);
-        case PeCliEncodedIndexType::HasSemantics:
-            return needs_wide_index({PeCliMetadataTableId::Event, PeCliMetadataTableId::Property}, threshold >> 1);
-        case PeCliEncodedIndexType::MethodDefOrRef:
-            return needs_wide_index({PeCliMetadataTableId::MethodDef, PeCliMetadataTableId::MemberRef}, threshold >> 1);
-        case PeCliEncodedIndexType::MemberForwarded:
-            return needs_wide_index({PeCliMetadataTableId::Field, PeCliMetadataTableId::MethodDef}, threshold >> 1);
-        case PeCliEncodedIndexType::Implementation:
-            return needs_wide_index({PeCliMetadataTableId::File, PeCliMetadataTableId::AssemblyRef, PeCliMetadataTableId::ExportedType}, threshold >> 2);
-        case PeCliEncodedIndexType::CustomAttributeType:
-            return needs_wide_index({PeCliMetadataTableId::MethodDef, PeCliMetadataTableId::MemberRef}, threshold >> 3);
-        case PeCliEncodedIndexType::ResolutionScope:
-            return needs_wide_index({PeCliMetadataTableId::Module, PeCliMetadataTableId::ModuleRef, PeCliMetadataTableId::AssemblyRef, PeCliMetadataTableId::TypeRef}, threshold >> 2);
-        case PeCliEncodedIndexType::TypeOrMethodDef:
-            return needs_wide_index({PeCliMetadataTableId::TypeDef, PeCliMetadataTableId::MethodDef}, threshold >> 1);
-    }
+            reader.read(rows);
+            pdb->type_system_table_rows.push_back(rows);
+        }
 
-    return false;
+        _pdb = std::move(pdb);
+    }
 }
 
-void PeCliMetadataTables::load(BytesReader &reader)
+void PeCliMetadata::load_metadata_tables(bool load_rows, bool concurrently)
 {
-    reader.read(_header.reserved0);
-    reader.read(_header.major_version);
-    reader.read(_header.minor_version);
-    reader.read(_header.heap_sizes);
-    reader.read(_header.reserved1);
-    reader.read(_header.valid_tables);
-    reader.read(_header.sorted_tables);
-
-    unsigned nValid{count_set_bits(_header.valid_tables)};
-
-    _valid_table_types.reserve(nValid);
-    for (int i = 0; i < 64; ++i)
-        if (is_bit_set(_header.valid_tables, i))
-            _valid_table_types.push_back(static_cast<PeCliMetadataTableId>(i));
-
-    _header.row_counts.reserve(nValid);
-    for (unsigned i = 0; i < nValid; ++i)
+    if (!_tables && stream(PeCliStreamId::Tables).size())
     {
-        uint32_t    row;
-        reader.read(row);
-        _header.row_counts.push_back(row);
+        _tables = std::make_unique<PeCliMetadataTables>();
+        _tables->load(_streams[stream_index(PeCliStreamId::Tables)], _pdb.get());
+        if (load_rows)
+            _tables->load_rows(concurrently ? std::thread::hardware_concurrency() : 1);
     }
+}
 
+PeCliMetadataTableIndex PeCliMetadata::decode_index(PeCliEncodedIndexType type, uint32_t index) const
+{
+    return PeCliMetadataSchema::decode_index(type, index);
+}
 
-    // Following the header and the row counts are the tables themselves.
-    for (size_t i = 0; i < _valid_table_types.size(); ++i)
-    {
-        uint32_t    row_count{_header.row_counts[i]};
-
-        switch (_valid_table_types[i])
-        {
-            case PeCliMetadataTableId::Assembly:
-                _assembly_table = std::make_unique<std::vector<PeCliMetadataRowAssembly>>();
-                _assembly_table->reserve(row_count);
+PeCliMetadataStatistics PeCliMetadata::statistics() const
+{
+    PeCliMetadataStatistics rv;
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssembly    row{};
-                    reader.read(row.hash_alg_id);
-                    reader.read(row.major_version);
-                    reader.read(row.minor_version);
-                    reader.read(row.build_number);
-                    reader.read(row.revision_number);
-                    reader.read(row.flags);
-                    read_blob_heap_index(reader, row.public_key);
-                    read_strings_heap_index(reader, row.name);
-                    read_strings_heap_index(reader, row.culture);
-
-                    _assembly_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::AssemblyOS:
-                _assembly_os_table = std::make_unique<std::vector<PeCliMetadataRowAssemblyOS>>();
-                _assembly_os_table->reserve(row_count);
+    const auto  size_of{[this](PeCliStreamId id) {
+                    const auto  index{stream_index(id)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssemblyOS  row{};
-                    reader.read(row.os_platformID);
-                    reader.read(row.os_major_version);
-                    reader.read(row.os_minor_version);
+                    return index >= 0 ? _stream_headers[index].size : 0;
+                }};
 
-                    _assembly_os_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::AssemblyProcessor:
-                _assembly_processor_table = std::make_unique<std::vector<PeCliMetadataRowAssemblyProcessor>>();
-                _assembly_processor_table->reserve(row_count);
+    for (const auto &header : _stream_headers)
+        rv.streams_size += header.size;
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssemblyProcessor   row{};
-                    reader.read(row.processor);
+    rv.tables_stream_size = size_of(PeCliStreamId::Tables);
+    rv.strings_size = size_of(PeCliStreamId::Strings);
+    rv.user_strings_size = size_of(PeCliStreamId::UserStrings);
+    rv.guid_size = size_of(PeCliStreamId::Guid);
+    rv.blob_size = size_of(PeCliStreamId::Blob);
+    rv.pdb_size = size_of(PeCliStreamId::Pdb);
 
-                    _assembly_processor_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::AssemblyRef:
-                _assembly_ref_table = std::make_unique<std::vector<PeCliMetadataRowAssemblyRef>>();
-                _assembly_ref_table->reserve(row_count);
+    if (_tables)
+        rv.tables = _tables->statistics();
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssemblyRef row{};
-                    reader.read(row.major_version);
-                    reader.read(row.minor_version);
-                    reader.read(row.build_number);
-                    reader.read(row.revision_number);
-                    reader.read(row.flags);
-                    read_blob_heap_index(reader, row.public_key_or_token);
-                    read_strings_heap_index(reader, row.name);
-                    read_strings_heap_index(reader, row.culture);
-                    read_blob_heap_index(reader, row.hash_value);
-
-                    _assembly_ref_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::AssemblyRefOS:
-                _assembly_ref_os_table = std::make_unique<std::vector<PeCliMetadataRowAssemblyRefOS>>();
-                _assembly_ref_os_table->reserve(row_count);
+    return rv;
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssemblyRefOS   row{};
-                    reader.read(row.os_platformID);
-                    reader.read(row.os_major_version);
-                    reader.read(row.os_minor_version);
-                    read_index(reader, row.assembly_ref, needs_wide_index(PeCliMetadataTableId::AssemblyRef));
+const PeCliTypeNameIndex &PeCliMetadata::type_names() const
+{
+    std::call_once(_type_names_once, [this]() { _type_names = std::make_unique<PeCliTypeNameIndex>(*this); });
 
-                    _assembly_ref_os_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::AssemblyRefProcessor:
-                _assembly_ref_processor_table = std::make_unique<std::vector<PeCliMetadataRowAssemblyRefProcessor>>();
-                _assembly_ref_processor_table->reserve(row_count);
+    return *_type_names;
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowAssemblyRefProcessor    row{};
-                    reader.read(row.processor);
-                    read_index(reader, row.assembly_ref, needs_wide_index(PeCliMetadataTableId::AssemblyRef));
 
-                    _assembly_ref_processor_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::ClassLayout:
-                _class_layout_table = std::make_unique<std::vector<PeCliMetadataRowClassLayout>>();
-                _class_layout_table->reserve(row_count);
+const PeCliColumn *PeCliMetadataSchema::table_columns(PeCliMetadataTableId id, size_t &count) noexcept
+{
+    const auto  ndx{static_cast<size_t>(id)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowClassLayout row{};
-                    reader.read(row.packing_size);
-                    reader.read(row.class_size);
-                    read_index(reader, row.parent, needs_wide_index(PeCliMetadataTableId::TypeDef));
+    if (ndx >= sizeof(table_definitions) / sizeof(table_definitions[0]) || table_definitions[ndx].column_count == 0)
+    {
+        count = 0;
+        return nullptr;
+    }
 
-                    _class_layout_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Constant:
-                _constant_table = std::make_unique<std::vector<PeCliMetadataRowConstant>>();
-                _constant_table->reserve(row_count);
+    count = table_definitions[ndx].column_count;
+    return table_definitions[ndx].columns;
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowConstant    row{};
-                    reader.read(row.type);
-                    reader.read(row.padding);
+PeCliMetadataTableId PeCliMetadataSchema::pointer_table(PeCliMetadataTableId id) noexcept
+{
+    switch (id)
+    {
+        case PeCliMetadataTableId::Field:
+            return PeCliMetadataTableId::FieldPtr;
+        case PeCliMetadataTableId::MethodDef:
+            return PeCliMetadataTableId::MethodPtr;
+        case PeCliMetadataTableId::Param:
+            return PeCliMetadataTableId::ParamPtr;
+        case PeCliMetadataTableId::Event:
+            return PeCliMetadataTableId::EventPtr;
+        case PeCliMetadataTableId::Property:
+            return PeCliMetadataTableId::PropertyPtr;
+        default:
+            return id;
+    }
+}
 
-                    read_index(reader, row.parent, needs_wide_index(PeCliEncodedIndexType::HasConstant));
-                    read_blob_heap_index(reader, row.value);
+PeCliMetadataTableIndex PeCliMetadataSchema::decode_index(PeCliEncodedIndexType type, uint32_t index)
+{
+    const auto  ndx{static_cast<size_t>(type)};
 
-                    _constant_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::CustomAttribute:
-                _custom_attribute_table = std::make_unique<std::vector<PeCliMetadataRowCustomAttribute>>();
-                _custom_attribute_table->reserve(row_count);
+    if (ndx >= sizeof(coded_index_definitions) / sizeof(coded_index_definitions[0]))
+        throw std::runtime_error("Unrecognized encoded index type");    // This should never happen
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowCustomAttribute row{};
-                    read_index(reader, row.parent, needs_wide_index(PeCliEncodedIndexType::HasCustomAttribute));
-                    read_index(reader, row.type, needs_wide_index(PeCliEncodedIndexType::CustomAttributeType));
-                    read_blob_heap_index(reader, row.value);
+    const auto &definition{coded_index_definitions[ndx]};
+    const auto  tag{index & ((1u << definition.tag_bits) - 1)};
 
-                    _custom_attribute_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::DeclSecurity:
-                _decl_security_table = std::make_unique<std::vector<PeCliMetadataRowDeclSecurity>>();
-                _decl_security_table->reserve(row_count);
+    // Some tags are unused. ECMA-335 lists a "Permission" table as tag 8 of
+    // HasCustomAttribute, but it does not exist anywhere else in the spec.
+    if (tag >= definition.table_count || definition.tables[tag] == no_table)
+        throw std::runtime_error(std::string("Invalid table type value encoded into '") + definition.name + "' index.");
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowDeclSecurity    row{};
-                    reader.read(row.action);
-                    read_index(reader, row.parent, needs_wide_index(PeCliEncodedIndexType::HasDeclSecurity));
-                    read_blob_heap_index(reader, row.permission_set);
+    return {static_cast<PeCliMetadataTableId>(definition.tables[tag]), index >> definition.tag_bits};
+}
 
-                    _decl_security_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Event:
-                _event_table = std::make_unique<std::vector<PeCliMetadataRowEvent>>();
-                _event_table->reserve(row_count);
+uint32_t PeCliMetadataSchema::encode_index(PeCliEncodedIndexType type, PeCliMetadataTableIndex index)
+{
+    const auto  ndx{static_cast<size_t>(type)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowEvent   row{};
-                    reader.read(row.event_flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_index(reader, row.event_type, needs_wide_index(PeCliEncodedIndexType::TypeDefOrRef));
+    if (ndx >= sizeof(coded_index_definitions) / sizeof(coded_index_definitions[0]))
+        throw std::runtime_error("Unrecognized encoded index type");    // This should never happen
 
-                    _event_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::EventMap:
-                _event_map_table = std::make_unique<std::vector<PeCliMetadataRowEventMap>>();
-                _event_map_table->reserve(row_count);
+    const auto &definition{coded_index_definitions[ndx]};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowEventMap  row{};
-                    read_index(reader, row.parent, needs_wide_index(PeCliMetadataTableId::TypeDef));
-                    read_index(reader, row.event_list, needs_wide_index(PeCliMetadataTableId::Event));
+    for (uint32_t tag = 0; tag < definition.table_count; ++tag)
+        if (definition.tables[tag] == table_id(index.table_id))
+            return index.index << definition.tag_bits | tag;
 
-                    _event_map_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::ExportedType:
-                _exported_type_table = std::make_unique<std::vector<PeCliMetadataRowExportedType>>();
-                _exported_type_table->reserve(row_count);
+    throw std::runtime_error(std::string("Table cannot be referenced by a '") + definition.name + "' index.");
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowExportedType    row{};
-                    reader.read(row.flags);
-                    reader.read(row.typedef_id);    // This is an index, but it is always 4 bytes in size.
-                    read_strings_heap_index(reader, row.type_name);
-                    read_strings_heap_index(reader, row.type_namespace);
-                    read_index(reader, row.implementation, needs_wide_index(PeCliEncodedIndexType::Implementation));
-
-                    _exported_type_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Field:
-                _field_table = std::make_unique<std::vector<PeCliMetadataRowField>>();
-                _field_table->reserve(row_count);
+void PeCliMetadataSchema::compute(uint8_t heap_sizes, uint64_t valid_tables, const std::vector<uint32_t> &row_counts, uint32_t tables_offset,
+                                  const uint32_t *referenced_row_counts)
+{
+    static_assert(sizeof(coded_index_definitions) / sizeof(coded_index_definitions[0]) == coded_index_type_count,
+                  "Every PeCliEncodedIndexType must have a definition");
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowField   row{};
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_blob_heap_index(reader, row.signature);
+    size_t  valid_index{0};
 
-                    _field_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::FieldLayout:
-                _field_layout_table = std::make_unique<std::vector<PeCliMetadataRowFieldLayout>>();
-                _field_layout_table->reserve(row_count);
+    for (size_t i = 0; i < table_count; ++i)
+    {
+        _layouts[i] = PeCliMetadataTableLayout{};
+        if (is_bit_set(valid_tables, static_cast<int>(i)))
+            _layouts[i].row_count = row_counts.at(valid_index++);
+
+        // A Portable PDB refers to the tables of its assembly, which it does not contain.
+        _index_row_counts[i] = _layouts[i].row_count;
+        if (referenced_row_counts && _index_row_counts[i] == 0)
+            _index_row_counts[i] = referenced_row_counts[i];
+    }
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowFieldLayout row{};
-                    reader.read(row.offset);
-                    read_index(reader, row.field, needs_wide_index(PeCliMetadataTableId::Field));
+    _string_index_width = (heap_sizes & 0x01) ? 4 : 2;
+    _guid_index_width = (heap_sizes & 0x02) ? 4 : 2;
+    _blob_index_width = (heap_sizes & 0x04) ? 4 : 2;
 
-                    _field_layout_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::FieldMarshal:
-                _field_marshal_table = std::make_unique<std::vector<PeCliMetadataRowFieldMarshal>>();
-                _field_marshal_table->reserve(row_count);
+    // A coded index is two bytes wide if the largest of the tables it can
+    // reference has fewer than 2^(16 - tag_bits) rows.
+    for (size_t i = 0; i < coded_index_type_count; ++i)
+    {
+        const auto &definition{coded_index_definitions[i]};
+        uint32_t    max_rows{0};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowFieldMarshal    row{};
-                    read_index(reader, row.parent, needs_wide_index(PeCliEncodedIndexType::HasFieldMarshall));
-                    read_blob_heap_index(reader, row.native_type);
+        for (size_t t = 0; t < definition.table_count; ++t)
+            if (definition.tables[t] != no_table)
+                max_rows = std::max(max_rows, _index_row_counts[definition.tables[t]]);
 
-                    _field_marshal_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::FieldRVA:
-                _field_rva_table = std::make_unique<std::vector<PeCliMetadataRowFieldRVA>>();
-                _field_rva_table->reserve(row_count);
+        _coded_index_widths[i] = max_rows < (1u << (16 - definition.tag_bits)) ? 2 : 4;
+    }
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowFieldRVA    row{};
-                    reader.read(row.rva);
-                    read_index(reader, row.field, needs_wide_index(PeCliMetadataTableId::Field));
+    // The tables are stored one after another, in table identifier order.
+    uint64_t    offset{tables_offset};
 
-                    _field_rva_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::File:
-                _file_table = std::make_unique<std::vector<PeCliMetadataRowFile>>();
-                _file_table->reserve(row_count);
+    _complete = true;
+    for (size_t i = 0; i < table_count; ++i)
+    {
+        auto   &layout{_layouts[i]};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowFile    row{};
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_blob_heap_index(reader, row.hash_value);
+        if (!is_bit_set(valid_tables, static_cast<int>(i)))
+            continue;
 
-                    _file_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::GenericParam:
-                _generic_param_table = std::make_unique<std::vector<PeCliMetadataRowGenericParam>>();
-                _generic_param_table->reserve(row_count);
+        size_t              column_count;
+        const PeCliColumn  *columns{table_columns(static_cast<PeCliMetadataTableId>(i), column_count)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowGenericParam    row{};
-                    reader.read(row.number);
-                    reader.read(row.flags);
-                    read_index(reader, row.owner, needs_wide_index(PeCliEncodedIndexType::TypeOrMethodDef));
-                    read_strings_heap_index(reader, row.name);
+        // Neither this table nor any after it can be located.
+        if (columns == nullptr || !_complete)
+        {
+            _complete = false;
+            layout.row_count = 0;
+            continue;
+        }
 
-                    _generic_param_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::GenericParamConstraint:
-                _generic_param_constraint_table = std::make_unique<std::vector<PeCliMetadataRowGenericParamConstraint>>();
-                _generic_param_constraint_table->reserve(row_count);
+        layout.column_count = static_cast<uint8_t>(column_count);
+        for (size_t c = 0; c < column_count; ++c)
+        {
+            uint8_t width{0};
 
-                for (uint32_t j = 0; j < row_count; ++j)
+            switch (columns[c].kind)
+            {
+                case PeCliColumnKind::UInt8:
+                    width = 1;
+                    break;
+                case PeCliColumnKind::UInt16:
+                    width = 2;
+                    break;
+                case PeCliColumnKind::UInt32:
+                    width = 4;
+                    break;
+                case PeCliColumnKind::StringIndex:
+                    width = _string_index_width;
+                    break;
+                case PeCliColumnKind::GuidIndex:
+                    width = _guid_index_width;
+                    break;
+                case PeCliColumnKind::BlobIndex:
+                    width = _blob_index_width;
+                    break;
+                case PeCliColumnKind::TableIndex:
+                    width = index_width(static_cast<PeCliMetadataTableId>(columns[c].target));
+                    break;
+                case PeCliColumnKind::CodedIndex:
+                    width = index_width(static_cast<PeCliEncodedIndexType>(columns[c].target));
+                    break;
+                case PeCliColumnKind::ListIndex:
                 {
-                    PeCliMetadataRowGenericParamConstraint  row{};
-                    read_index(reader, row.owner, needs_wide_index(PeCliMetadataTableId::GenericParam));
-                    read_index(reader, row.constraint, needs_wide_index(PeCliEncodedIndexType::TypeDefOrRef));
+                    const auto  target{static_cast<PeCliMetadataTableId>(columns[c].target)};
 
-                    _generic_param_constraint_table->push_back(row);
+                    width = std::max(index_width(target), index_width(pointer_table(target)));
+                    break;
                 }
-                break;
-            case PeCliMetadataTableId::ImplMap:
-                _impl_map_table = std::make_unique<std::vector<PeCliMetadataRowImplMap>>();
-                _impl_map_table->reserve(row_count);
-
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowImplMap row{};
-                    reader.read(row.mapping_flags);
-                    read_index(reader, row.member_forwarded, needs_wide_index(PeCliEncodedIndexType::MemberForwarded));
-                    read_strings_heap_index(reader, row.import_name);
-                    read_index(reader, row.import_scope, needs_wide_index(PeCliMetadataTableId::ModuleRef));
-
+            }
 
-                    _impl_map_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::InterfaceImpl:
-                _interface_impl_table = std::make_unique<std::vector<PeCliMetadataRowInterfaceImpl>>();
-                _interface_impl_table->reserve(row_count);
+            layout.column_offsets[c] = static_cast<uint8_t>(layout.row_size);
+            layout.column_widths[c] = width;
+            layout.row_size += width;
+        }
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowInterfaceImpl   row{};
-                    read_index(reader, row.class_, needs_wide_index(PeCliMetadataTableId::TypeDef));
-                    read_index(reader, row.interface_, needs_wide_index(PeCliEncodedIndexType::TypeDefOrRef));
+        layout.offset = static_cast<uint32_t>(offset);
+        offset += static_cast<uint64_t>(layout.row_size) * layout.row_count;
+        if (offset > UINT32_MAX)
+            throw std::runtime_error("CLI metadata tables are too large");
+    }
 
-                    _interface_impl_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::ManifestResource:
-                _manifest_resource_table = std::make_unique<std::vector<PeCliMetadataRowManifestResource>>();
-                _manifest_resource_table->reserve(row_count);
+    _tables_end = static_cast<uint32_t>(offset);
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowManifestResource  row{};
-                    reader.read(row.offset);
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_index(reader, row.implementation, needs_wide_index(PeCliEncodedIndexType::Implementation));
 
-                    _manifest_resource_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::MemberRef:
-                _member_ref_table = std::make_unique<std::vector<PeCliMetadataRowMemberRef>>();
-                _member_ref_table->reserve(row_count);
+PeCliMetadataTables::PeCliMetadataTables()
+  : _relations{std::make_unique<PeCliMetadataRelations>(*this)}
+{}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowMemberRef   row{};
-                    read_index(reader, row.class_, needs_wide_index(PeCliEncodedIndexType::MemberRefParent));
-                    read_strings_heap_index(reader, row.name);
-                    read_blob_heap_index(reader, row.signature);
+// Defined here, where PeCliMetadataRelations is a complete type.
+PeCliMetadataTables::~PeCliMetadataTables() = default;
 
-                    _member_ref_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::MethodDef:
-                _method_def_table = std::make_unique<std::vector<PeCliMetadataRowMethodDef>>();
-                _method_def_table->reserve(row_count);
+template<typename Row>
+void PeCliMetadataTables::decode_rows(std::vector<Row> &table, uint32_t first, uint32_t last) const noexcept
+{
+    const auto     &layout{_schema.layout(PeCliMetadataRowTraits<Row>::id)};
+    const uint8_t  *ptr{_stream.data() + layout.offset + static_cast<size_t>(first) * layout.row_size};
+    uint32_t        values[PeCliMetadataTableLayout::max_columns];
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowMethodDef   row{};
-                    reader.read(row.rva);
-                    reader.read(row.impl_flags);
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_blob_heap_index(reader, row.signature);
-                    read_index(reader, row.param_list, needs_wide_index(PeCliMetadataTableId::Param));
-
-                    _method_def_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::MethodImpl:
-                _method_impl_table = std::make_unique<std::vector<PeCliMetadataRowMethodImpl>>();
-                _method_impl_table->reserve(row_count);
+    for (uint32_t i = first; i < last; ++i, ptr += layout.row_size)
+    {
+        PeCliMetadataSchema::read_row(ptr, layout, values);
+        PeCliMetadataRowTraits<Row>::assign(values, table[i]);
+    }
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowMethodImpl  row{};
-                    read_index(reader, row.class_, needs_wide_index(PeCliMetadataTableId::TypeDef));
-                    read_index(reader, row.method_body, needs_wide_index(PeCliEncodedIndexType::MethodDefOrRef));
-                    read_index(reader, row.method_declaration, needs_wide_index(PeCliEncodedIndexType::MethodDefOrRef));
+void PeCliMetadataTables::load(const SharedBytes &stream, const PeCliPdbStream *pdb)
+{
+    BytesReader reader{stream};
 
-                    _method_impl_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::MethodSemantics:
-                _method_semantics_table = std::make_unique<std::vector<PeCliMetadataRowMethodSemantics>>();
-                _method_semantics_table->reserve(row_count);
+    _stream = stream;
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowMethodSemantics row{};
-                    reader.read(row.semantics);
-                    read_index(reader, row.method, needs_wide_index(PeCliMetadataTableId::MethodDef));
-                    read_index(reader, row.association, needs_wide_index(PeCliEncodedIndexType::HasSemantics));
+    reader.read(_header.reserved0);
+    reader.read(_header.major_version);
+    reader.read(_header.minor_version);
+    reader.read(_header.heap_sizes);
+    reader.read(_header.reserved1);
+    reader.read(_header.valid_tables);
+    reader.read(_header.sorted_tables);
 
-                    _method_semantics_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::MethodSpec:
-                _method_spec_table = std::make_unique<std::vector<PeCliMetadataRowMethodSpec>>();
-                _method_spec_table->reserve(row_count);
+    unsigned nValid{count_set_bits(_header.valid_tables)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowMethodSpec  row{};
-                    read_index(reader, row.method, needs_wide_index(PeCliEncodedIndexType::MethodDefOrRef));
-                    read_blob_heap_index(reader, row.instantiation);
+    _valid_table_types.reserve(nValid);
+    for (int i = 0; i < 64; ++i)
+        if (is_bit_set(_header.valid_tables, i))
+            _valid_table_types.push_back(static_cast<PeCliMetadataTableId>(i));
 
-                    _method_spec_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Module:
-                _module_table = std::make_unique<std::vector<PeCliMetadataRowModule>>();
-                _module_table->reserve(row_count);
+    _header.row_counts.reserve(nValid);
+    for (unsigned i = 0; i < nValid; ++i)
+    {
+        uint32_t    row;
+        reader.read(row);
+        _header.row_counts.push_back(row);
+    }
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowModule  row{};
-                    reader.read(row.generation);
-                    read_strings_heap_index(reader, row.name);
-                    read_guid_heap_index(reader, row.mv_id);
-                    read_guid_heap_index(reader, row.enc_id);
-                    read_guid_heap_index(reader, row.enc_base_id);
-
-                    _module_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::ModuleRef:
-                _module_ref_table = std::make_unique<std::vector<PeCliMetadataRowModuleRef>>();
-                _module_ref_table->reserve(row_count);
+    // Uncompressed streams may have four bytes of extra data after the row counts.
+    if (_header.heap_sizes & heap_sizes_extra_data)
+        reader.seek(reader.tell() + sizeof(uint32_t));
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowModuleRef   row{};
-                    read_strings_heap_index(reader, row.name);
+    uint32_t    referenced_row_counts[PeCliMetadataSchema::table_count]{};
 
-                    _module_ref_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::NestedClass:
-                _nested_class_table = std::make_unique<std::vector<PeCliMetadataRowNestedClass>>();
-                _nested_class_table->reserve(row_count);
+    if (pdb)
+    {
+        size_t  valid_index{0};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowNestedClass row{};
-                    bool                        use_wide = needs_wide_index(PeCliMetadataTableId::TypeDef);
-                    read_index(reader, row.nested_class, use_wide);
-                    read_index(reader, row.enclosing_class, use_wide);
+        for (size_t i = 0; i < PeCliMetadataSchema::table_count; ++i)
+            if (is_bit_set(pdb->referenced_type_system_tables, static_cast<int>(i)))
+                referenced_row_counts[i] = pdb->type_system_table_rows.at(valid_index++);
+    }
 
-                    _nested_class_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Param:
-                _param_table = std::make_unique<std::vector<PeCliMetadataRowParam>>();
-                _param_table->reserve(row_count);
+    // Following the header and the row counts are the tables themselves.
+    _schema.compute(_header.heap_sizes, _header.valid_tables, _header.row_counts, static_cast<uint32_t>(reader.tell()),
+                    pdb ? referenced_row_counts : nullptr);
+    if (_schema.tables_end() > _stream.size())
+        throw std::runtime_error("CLI metadata tables extend beyond the end of the #~ stream");
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowParam   row{};
-                    reader.read(row.flags);
-                    reader.read(row.sequence);
-                    read_strings_heap_index(reader, row.name);
+PeCliMetadataTablesStatistics PeCliMetadataTables::statistics() const
+{
+    PeCliMetadataTablesStatistics   rv;
+
+    rv.stream_size = static_cast<uint32_t>(_stream.size());
+    // The fixed part of the header is 24 bytes, followed by the row counts.
+    rv.header_size = static_cast<uint32_t>(24 + _header.row_counts.size() * sizeof(uint32_t)
+                                           + (_header.heap_sizes & heap_sizes_extra_data ? sizeof(uint32_t) : 0));
+    rv.string_index_width = _schema.string_index_width();
+    rv.guid_index_width = _schema.guid_index_width();
+    rv.blob_index_width = _schema.blob_index_width();
+    rv.is_complete = _schema.is_complete();
+
+    for (size_t i = 0; i < PeCliMetadataSchema::table_count; ++i)
+        if (_schema.index_width(static_cast<PeCliMetadataTableId>(i)) == 4)
+            rv.wide_table_indexes |= uint64_t{1} << i;
+
+    for (auto type = static_cast<int>(PeCliEncodedIndexType::TypeDefOrRef);
+         type <= static_cast<int>(PeCliEncodedIndexType::HasCustomDebugInformation); ++type)
+    {
+        if (_schema.index_width(static_cast<PeCliEncodedIndexType>(type)) == 4)
+            rv.wide_coded_indexes |= uint32_t{1} << type;
+    }
 
-                    _param_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::Property:
-                _property_table = std::make_unique<std::vector<PeCliMetadataRowProperty>>();
-                _property_table->reserve(row_count);
+    rv.tables.reserve(_valid_table_types.size());
+    for (size_t i = 0; i < _valid_table_types.size(); ++i)
+    {
+        const auto  id{_valid_table_types[i]};
+        const auto &layout{_schema.layout(id)};
+        const auto  rows{_header.row_counts[i]};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowProperty    row{};
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.name);
-                    read_blob_heap_index(reader, row.type);
+        rv.tables.push_back({id, rows, layout.row_size, static_cast<uint64_t>(rows) * layout.row_size});
+        rv.tables_size += rv.tables.back().size;
+        rv.row_count += rows;
+    }
 
-                    _property_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::PropertyMap:
-                _property_map_table = std::make_unique<std::vector<PeCliMetadataRowPropertyMap>>();
-                _property_map_table->reserve(row_count);
+    return rv;
+}
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowPropertyMap row{};
-                    read_index(reader, row.parent, needs_wide_index(PeCliMetadataTableId::TypeDef));
-                    read_index(reader, row.property_list, needs_wide_index(PeCliMetadataTableId::Property));
+template<typename Fn>
+void PeCliMetadataTables::visit_table(PeCliMetadataTableId id, Fn &&fn)
+{
+    switch (id)
+    {
+        case PeCliMetadataTableId::Assembly:
+            fn(_assembly_table);
+            break;
+        case PeCliMetadataTableId::AssemblyOS:
+            fn(_assembly_os_table);
+            break;
+        case PeCliMetadataTableId::AssemblyProcessor:
+            fn(_assembly_processor_table);
+            break;
+        case PeCliMetadataTableId::AssemblyRef:
+            fn(_assembly_ref_table);
+            break;
+        case PeCliMetadataTableId::AssemblyRefOS:
+            fn(_assembly_ref_os_table);
+            break;
+        case PeCliMetadataTableId::AssemblyRefProcessor:
+            fn(_assembly_ref_processor_table);
+            break;
+        case PeCliMetadataTableId::ClassLayout:
+            fn(_class_layout_table);
+            break;
+        case PeCliMetadataTableId::Constant:
+            fn(_constant_table);
+            break;
+        case PeCliMetadataTableId::CustomAttribute:
+            fn(_custom_attribute_table);
+            break;
+        case PeCliMetadataTableId::DeclSecurity:
+            fn(_decl_security_table);
+            break;
+        case PeCliMetadataTableId::Event:
+            fn(_event_table);
+            break;
+        case PeCliMetadataTableId::EventMap:
+            fn(_event_map_table);
+            break;
+        case PeCliMetadataTableId::ExportedType:
+            fn(_exported_type_table);
+            break;
+        case PeCliMetadataTableId::Field:
+            fn(_field_table);
+            break;
+        case PeCliMetadataTableId::FieldLayout:
+            fn(_field_layout_table);
+            break;
+        case PeCliMetadataTableId::FieldMarshal:
+            fn(_field_marshal_table);
+            break;
+        case PeCliMetadataTableId::FieldRVA:
+            fn(_field_rva_table);
+            break;
+        case PeCliMetadataTableId::File:
+            fn(_file_table);
+            break;
+        case PeCliMetadataTableId::GenericParam:
+            fn(_generic_param_table);
+            break;
+        case PeCliMetadataTableId::GenericParamConstraint:
+            fn(_generic_param_constraint_table);
+            break;
+        case PeCliMetadataTableId::ImplMap:
+            fn(_impl_map_table);
+            break;
+        case PeCliMetadataTableId::InterfaceImpl:
+            fn(_interface_impl_table);
+            break;
+        case PeCliMetadataTableId::ManifestResource:
+            fn(_manifest_resource_table);
+            break;
+        case PeCliMetadataTableId::MemberRef:
+            fn(_member_ref_table);
+            break;
+        case PeCliMetadataTableId::MethodDef:
+            fn(_method_def_table);
+            break;
+        case PeCliMetadataTableId::MethodImpl:
+            fn(_method_impl_table);
+            break;
+        case PeCliMetadataTableId::MethodSemantics:
+            fn(_method_semantics_table);
+            break;
+        case PeCliMetadataTableId::MethodSpec:
+            fn(_method_spec_table);
+            break;
+        case PeCliMetadataTableId::Module:
+            fn(_module_table);
+            break;
+        case PeCliMetadataTableId::ModuleRef:
+            fn(_module_ref_table);
+            break;
+        case PeCliMetadataTableId::NestedClass:
+            fn(_nested_class_table);
+            break;
+        case PeCliMetadataTableId::Param:
+            fn(_param_table);
+            break;
+        case PeCliMetadataTableId::Property:
+            fn(_property_table);
+            break;
+        case PeCliMetadataTableId::PropertyMap:
+            fn(_property_map_table);
+            break;
+        case PeCliMetadataTableId::StandAloneSig:
+            fn(_standalone_sig_table);
+            break;
+        case PeCliMetadataTableId::TypeDef:
+            fn(_type_def_table);
+            break;
+        case PeCliMetadataTableId::TypeRef:
+            fn(_type_ref_table);
+            break;
+        case PeCliMetadataTableId::TypeSpec:
+            fn(_type_spec_table);
+            break;
+        case PeCliMetadataTableId::FieldPtr:
+            fn(_field_ptr_table);
+            break;
+        case PeCliMetadataTableId::MethodPtr:
+            fn(_method_ptr_table);
+            break;
+        case PeCliMetadataTableId::ParamPtr:
+            fn(_param_ptr_table);
+            break;
+        case PeCliMetadataTableId::EventPtr:
+            fn(_event_ptr_table);
+            break;
+        case PeCliMetadataTableId::PropertyPtr:
+            fn(_property_ptr_table);
+            break;
+        case PeCliMetadataTableId::ENCLog:
+            fn(_enc_log_table);
+            break;
+        case PeCliMetadataTableId::ENCMap:
+            fn(_enc_map_table);
+            break;
+        case PeCliMetadataTableId::Document:
+            fn(_document_table);
+            break;
+        case PeCliMetadataTableId::MethodDebugInformation:
+            fn(_method_debug_information_table);
+            break;
+        case PeCliMetadataTableId::LocalScope:
+            fn(_local_scope_table);
+            break;
+        case PeCliMetadataTableId::LocalVariable:
+            fn(_local_variable_table);
+            break;
+        case PeCliMetadataTableId::LocalConstant:
+            fn(_local_constant_table);
+            break;
+        case PeCliMetadataTableId::ImportScope:
+            fn(_import_scope_table);
+            break;
+        case PeCliMetadataTableId::StateMachineMethod:
+            fn(_state_machine_method_table);
+            break;
+        case PeCliMetadataTableId::CustomDebugInformation:
+            fn(_custom_debug_information_table);
+            break;
+        default:
+            break;
+    }
+}
 
-                    _property_map_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::StandAloneSig:
-                _standalone_sig_table = std::make_unique<std::vector<PeCliMetadataRowStandAloneSig>>();
-                _standalone_sig_table->reserve(row_count);
+void PeCliMetadataTables::load_rows(unsigned thread_count)
+{
+    std::vector<std::function<void()>>  jobs;   // each decodes a block of rows of one table
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowStandAloneSig   row{};
-                    read_blob_heap_index(reader, row.signature);
+    // Size every table first, so that each row has a fixed place to be decoded into.
+    for (auto id : _valid_table_types)
+    {
+        visit_table(id,
+                    [&](auto &table) {
+                        using Rows = typename std::remove_reference_t<decltype(table)>::element_type;
 
-                    _standalone_sig_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::TypeDef:
-                _type_def_table = std::make_unique<std::vector<PeCliMetadataRowTypeDef>>();
-                _type_def_table->reserve(row_count);
+                        const uint32_t  row_count{_schema.row_count(id)};
+                        const uint32_t  block_size{thread_count > 1 ? rows_per_job : row_count};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowTypeDef row{};
-                    reader.read(row.flags);
-                    read_strings_heap_index(reader, row.type_name);
-                    read_strings_heap_index(reader, row.type_namespace);
-                    read_index(reader, row.extends, needs_wide_index(PeCliEncodedIndexType::TypeDefOrRef));
-                    read_index(reader, row.field_list, needs_wide_index(PeCliMetadataTableId::Field));
-                    read_index(reader, row.method_list, needs_wide_index(PeCliMetadataTableId::MethodDef));
-
-                    _type_def_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::TypeRef:
-                _type_ref_table = std::make_unique<std::vector<PeCliMetadataRowTypeRef>>();
-                _type_ref_table->reserve(row_count);
+                        table = std::make_unique<Rows>(row_count);
+                        for (uint32_t first = 0; first < row_count; first += block_size)
+                        {
+                            const uint32_t  last{std::min(row_count, first + block_size)};
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowTypeRef row{};
-                    read_index(reader, row.resolution_scope, needs_wide_index(PeCliEncodedIndexType::ResolutionScope));
-                    read_strings_heap_index(reader, row.type_name);
-                    read_strings_heap_index(reader, row.type_namespace);
+                            jobs.emplace_back([this, rows = table.get(), first, last]() { decode_rows(*rows, first, last); });
+                        }
+                    });
+    }
 
-                    _type_ref_table->push_back(row);
-                }
-                break;
-            case PeCliMetadataTableId::TypeSpec:
-                _type_spec_table = std::make_unique<std::vector<PeCliMetadataRowTypeSpec>>();
-                _type_spec_table->reserve(row_count);
+    // Each thread takes the next job until none remain. Jobs write to
+    // disjoint rows, so they need no further synchronization.
+    std::atomic<size_t>         next_job{0};
+    std::vector<std::thread>    workers;
+    const auto                  work{[&]() {
+                                         for (size_t job = next_job++; job < jobs.size(); job = next_job++)
+                                             jobs[job]();
+                                     }};
+
+    thread_count = static_cast<unsigned>(std::min<size_t>(thread_count, jobs.size()));
+    for (unsigned i = 1; i < thread_count; ++i)
+    {
+        try
+        {
+            workers.emplace_back(work);
+        }
+        catch (const std::system_error &)
+        {
+            break;  // carry on with the threads already running
+        }
+    }
 
-                for (uint32_t j = 0; j < row_count; ++j)
-                {
-                    PeCliMetadataRowTypeSpec    row{};
-                    read_blob_heap_index(reader, row.signature);
+    work();     // the calling thread takes part, and does all the work if there are no others
 
-                    _type_spec_table->push_back(row);
-                }
-                break;
-            default:    // unknown table type. not much we can do since we would have to know the size of each row of the unknown table.
-                throw std::runtime_error("Unknown CLI metadata table type");
-        };
-    }
+    for (auto &worker : workers)
+        worker.join();
 }
 
 void PeCli::load(std::istream &stream, const std::vector<PeSection> &sections, LoadOptions::Options options)
@@ -1264,7 +1097,7 @@ void PeCli::load(std::istream &stream, const std::vector<PeSection> &sections, L
     read_data_directory_entry(stream, _cli_header.export_address_table_jumps);
     read_data_directory_entry(stream, _cli_header.managed_native_header);
 
-    if (options | LoadOptions::LoadCliMetadata)
+    if ((options & LoadOptions::LoadCliMetadata) == LoadOptions::LoadCliMetadata)
     {
         auto    rva{_cli_header.metadata.virtual_address};
         auto    section{find_section_by_rva(rva, sections)};
@@ -1278,5 +1111,8 @@ void PeCli::load(std::istream &stream, const std::vector<PeSection> &sections, L
             _metadata->load(stream, options);
         }
     }
-    //TODO: Load any other CLI information!!!
+
+    // The remaining CLI data, such as managed resources, method bodies, and
+    // ReadyToRun code, is read on request from the loaded sections; see
+    // get_managed_resources(), get_method_body(), and PeReadyToRun.
 }
@@ -0,0 +1,333 @@
+/// \file   CliAssemblyIdentity.cpp
+/// Implementation of CLI assembly identities and public key tokens.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "CliAssemblyIdentity.h"
+
+namespace {
+
+// SHA-1, FIPS 180-4, which is all that is needed to compute public key tokens.
+class Sha1
+{
+public:
+    void update(const uint8_t *data, size_t size) noexcept
+    {
+        _length += size;
+        while (size > 0)
+        {
+            const size_t    count{std::min(size, sizeof(_block) - _used)};
+
+            std::memcpy(_block + _used, data, count);
+            _used += count;
+            data += count;
+            size -= count;
+            if (_used == sizeof(_block))
+            {
+                transform();
+                _used = 0;
+            }
+        }
+    }
+
+    std::array<uint8_t, 20> finish() noexcept
+    {
+        const uint64_t  bits{_length * 8};
+        const uint8_t   pad{0x80};
+        const uint8_t   zero{0};
+
+        update(&pad, 1);
+        while (_used != 56)
+            update(&zero, 1);
+        for (int i = 7; i >= 0; --i)
+        {
+            const auto  byte{static_cast<uint8_t>(bits >> (i * 8))};
+
+            update(&byte, 1);
+        }
+
+        std::array<uint8_t, 20> rv;
+
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                rv[i * 4 + j] = static_cast<uint8_t>(_state[i] >> (24 - j * 8));
+
+        return rv;
+    }
+
+private:
+    static uint32_t rotate(uint32_t value, unsigned count) noexcept
+    {
+        return (value << count) | (value >> (32 - count));
+    }
+
+    void transform() noexcept
+    {
+        uint32_t    w[80];
+
+        for (size_t i = 0; i < 16; ++i)
+            w[i] = static_cast<uint32_t>(_block[i * 4]) << 24 | static_cast<uint32_t>(_block[i * 4 + 1]) << 16
+                 | static_cast<uint32_t>(_block[i * 4 + 2]) << 8 | _block[i * 4 + 3];
+        for (size_t i = 16; i < 80; ++i)
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t    a{_state[0]};
+        uint32_t    b{_state[1]};
+        uint32_t    c{_state[2]};
+        uint32_t    d{_state[3]};
+        uint32_t    e{_state[4]};
+
+        for (size_t i = 0; i < 80; ++i)
+        {
+            uint32_t    f;
+            uint32_t    k;
+
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            const uint32_t  temp{rotate(a, 5) + f + e + k + w[i]};
+
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        _state[0] += a;
+        _state[1] += b;
+        _state[2] += c;
+        _state[3] += d;
+        _state[4] += e;
+    }
+
+    uint32_t    _state[5]{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t     _block[64];
+    size_t      _used{0};
+    uint64_t    _length{0};
+};
+
+bool equal_ignoring_case(const std::string &a, const std::string &b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+
+    return true;
+}
+
+// Append a name to a display name, escaping the characters that would
+// otherwise separate or quote its parts.
+void append_escaped(std::string &out, const std::string &name)
+{
+    for (auto ch : name)
+    {
+        if (ch == ',' || ch == '=' || ch == '"' || ch == '\'' || ch == '\\')
+            out.push_back('\\');
+        out.push_back(ch);
+    }
+}
+
+void set_key(PeCliAssemblyIdentity &identity, BytesView blob, bool is_full_key)
+{
+    if (blob.empty())
+        return;
+
+    if (is_full_key)
+    {
+        const auto  token{compute_public_key_token(blob)};
+
+        identity.public_key.assign(blob.begin(), blob.end());
+        identity.public_key_token.assign(token.begin(), token.end());
+    }
+    else
+    {
+        identity.public_key_token.assign(blob.begin(), blob.end());
+    }
+}
+
+}   // anonymous namespace
+
+
+PeCliPublicKeyToken compute_public_key_token(BytesView public_key)
+{
+    static std::mutex                                           mutex;
+    static std::unordered_map<std::string, PeCliPublicKeyToken> cache;
+
+    std::string key{reinterpret_cast<const char *>(public_key.data()), public_key.size()};
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        const auto                  it{cache.find(key)};
+
+        if (it != cache.end())
+            return it->second;
+    }
+
+    Sha1    sha1;
+
+    sha1.update(public_key.data(), public_key.size());
+
+    const auto          hash{sha1.finish()};
+    PeCliPublicKeyToken rv;
+
+    for (size_t i = 0; i < rv.size(); ++i)
+        rv[i] = hash[hash.size() - 1 - i];
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    cache.emplace(std::move(key), rv);
+    return rv;
+}
+
+PeCliAssemblyIdentity PeCliAssemblyIdentity::from_assembly(const PeCliMetadata &metadata)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr || tables->table<PeCliMetadataRowAssembly>().empty())
+        throw std::runtime_error("CLI metadata has no Assembly row");
+
+    const auto              row{tables->table<PeCliMetadataRowAssembly>().row(0)};
+    PeCliAssemblyIdentity   rv;
+
+    rv.name = metadata.get_string_view(row.name).str();
+    rv.major_version = row.major_version;
+    rv.minor_version = row.minor_version;
+    rv.build_number = row.build_number;
+    rv.revision_number = row.revision_number;
+    rv.culture = metadata.get_string_view(row.culture).str();
+    rv.flags = row.flags;
+
+    // The Assembly row always holds the full key, whatever its flags say.
+    set_key(rv, metadata.get_blob_view(row.public_key), true);
+
+    if (equal_ignoring_case(rv.culture, "neutral"))
+        rv.culture.clear();
+
+    return rv;
+}
+
+PeCliAssemblyIdentity PeCliAssemblyIdentity::from_assembly_ref(const PeCliMetadata &metadata, uint32_t row)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr || row == 0 || row > tables->table<PeCliMetadataRowAssemblyRef>().size())
+        throw std::out_of_range("AssemblyRef row out of range");
+
+    const auto              ref{tables->table<PeCliMetadataRowAssemblyRef>().row(row - 1)};
+    PeCliAssemblyIdentity   rv;
+
+    rv.name = metadata.get_string_view(ref.name).str();
+    rv.major_version = ref.major_version;
+    rv.minor_version = ref.minor_version;
+    rv.build_number = ref.build_number;
+    rv.revision_number = ref.revision_number;
+    rv.culture = metadata.get_string_view(ref.culture).str();
+    rv.flags = ref.flags;
+
+    set_key(rv, metadata.get_blob_view(ref.public_key_or_token), (ref.flags & static_cast<uint32_t>(PeCliAssemblyFlags::PublicKey)) != 0);
+
+    if (equal_ignoring_case(rv.culture, "neutral"))
+        rv.culture.clear();
+
+    return rv;
+}
+
+std::string PeCliAssemblyIdentity::display_name() const
+{
+    static const char   hex[]{"0123456789abcdef"};
+    std::string         rv;
+
+    append_escaped(rv, name);
+    rv += ", Version=" + std::to_string(major_version) + '.' + std::to_string(minor_version)
+        + '.' + std::to_string(build_number) + '.' + std::to_string(revision_number);
+
+    rv += ", Culture=";
+    if (culture.empty())
+        rv += "neutral";
+    else
+        append_escaped(rv, culture);
+
+    rv += ", PublicKeyToken=";
+    if (public_key_token.empty())
+        rv += "null";
+    for (auto byte : public_key_token)
+    {
+        rv.push_back(hex[byte >> 4]);
+        rv.push_back(hex[byte & 0x0F]);
+    }
+
+    if (flags & static_cast<uint32_t>(PeCliAssemblyFlags::Retargetable))
+        rv += ", Retargetable=Yes";
+    if ((flags & static_cast<uint32_t>(PeCliAssemblyFlags::ContentTypeMask)) == static_cast<uint32_t>(PeCliAssemblyFlags::WindowsRuntime))
+        rv += ", ContentType=WindowsRuntime";
+
+    return rv;
+}
+
+bool PeCliAssemblyIdentity::satisfies(const PeCliAssemblyIdentity &reference) const noexcept
+{
+    const uint16_t  version[]{major_version, minor_version, build_number, revision_number};
+    const uint16_t  wanted[]{reference.major_version, reference.minor_version, reference.build_number, reference.revision_number};
+
+    return equal_ignoring_case(name, reference.name)
+        && equal_ignoring_case(culture, reference.culture)
+        && (reference.public_key_token.empty() || public_key_token == reference.public_key_token)
+        && !std::lexicographical_compare(std::begin(version), std::end(version), std::begin(wanted), std::end(wanted));
+}
+
+bool operator==(const PeCliAssemblyIdentity &a, const PeCliAssemblyIdentity &b) noexcept
+{
+    return a.major_version == b.major_version
+        && a.minor_version == b.minor_version
+        && a.build_number == b.build_number
+        && a.revision_number == b.revision_number
+        && a.public_key_token == b.public_key_token
+        && equal_ignoring_case(a.name, b.name)
+        && equal_ignoring_case(a.culture, b.culture);
+}
+
+size_t PeCliAssemblyIdentityHash::operator()(const PeCliAssemblyIdentity &identity) const noexcept
+{
+    // FNV-1a over the name, folded to lower case, and the version.
+    uint32_t    hash{2166136261u};
+
+    for (auto ch : identity.name)
+        hash = (hash ^ static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(ch)))) * 16777619u;
+    for (auto part : {identity.major_version, identity.minor_version, identity.build_number, identity.revision_number})
+        hash = (hash ^ part) * 16777619u;
+
+    return hash;
+}
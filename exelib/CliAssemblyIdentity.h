@@ -0,0 +1,101 @@
+/// \file   CliAssemblyIdentity.h
+/// Provides the identity of a CLI assembly, as defined by its Assembly row
+/// or referred to by an AssemblyRef row, together with the computation of
+/// public key tokens and the formatting of display names.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIASSEMBLYIDENTITY_H_
+#define _EXELIB_CLIASSEMBLYIDENTITY_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Flags of an Assembly or AssemblyRef row. ECMA-335, section II.23.1.2.
+enum class PeCliAssemblyFlags : uint32_t
+{
+    PublicKey                   = 0x0001,   ///< The public_key_or_token column holds a full public key rather than a token
+    Retargetable                = 0x0100,   ///< The assembly may be bound to one from another publisher
+    WindowsRuntime              = 0x0200,   ///< The assembly holds Windows Runtime types
+    ContentTypeMask             = 0x0E00,
+    DisableJitCompileOptimizer  = 0x4000,
+    EnableJitCompileTracking    = 0x8000
+};
+
+/// \brief  A public key token: the last eight bytes of the SHA-1 hash of a public key, in reverse order.
+using PeCliPublicKeyToken = std::array<uint8_t, 8>;
+
+/// \brief  Return the public key token of a public key.
+///
+/// Tokens are kept in a cache shared by the whole process, so each distinct
+/// key is hashed only once however many assemblies and references carry
+/// it. The function may be called concurrently from several threads.
+PeCliPublicKeyToken compute_public_key_token(BytesView public_key);
+
+/// \brief  The identity of an assembly: its name, version, culture, and
+///         public key token.
+///
+/// The token is computed when the identity is made from a row holding a
+/// full public key, so identities can be compared and hashed cheaply.
+struct PeCliAssemblyIdentity
+{
+    std::string             name;
+    uint16_t                major_version{0};
+    uint16_t                minor_version{0};
+    uint16_t                build_number{0};
+    uint16_t                revision_number{0};
+    std::string             culture;            ///< Empty for a culture-neutral assembly
+    uint32_t                flags{0};           ///< Combination of PeCliAssemblyFlags values
+    std::vector<uint8_t>    public_key;         ///< The full public key, if known; empty otherwise
+    std::vector<uint8_t>    public_key_token;   ///< The eight-byte token, or empty if the assembly is not strong-named
+
+    /// \brief  Return the identity of the assembly defined by \p metadata.
+    ///
+    /// A \c std::runtime_error exception is thrown if the metadata has no Assembly row.
+    static PeCliAssemblyIdentity from_assembly(const PeCliMetadata &metadata);
+
+    /// \brief  Return the identity of the assembly referred to by an AssemblyRef row.
+    /// \param metadata The metadata holding the reference.
+    /// \param row      The one-based AssemblyRef row number.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p row is not a row of the AssemblyRef table.
+    static PeCliAssemblyIdentity from_assembly_ref(const PeCliMetadata &metadata, uint32_t row);
+
+    /// \brief  Return the display name, as in
+    ///         <tt>System.Runtime, Version=8.0.0.0, Culture=neutral, PublicKeyToken=b03f5f7f11d50a3a</tt>.
+    ///
+    /// Retargetable and ContentType are appended when their flags are set.
+    std::string display_name() const;
+
+    /// \brief  Return \c true if this identity satisfies a reference to \p reference:
+    ///         the names and cultures are equal without regard to case, the
+    ///         tokens are equal if the reference has one, and this version is
+    ///         no lower than the one referred to.
+    bool satisfies(const PeCliAssemblyIdentity &reference) const noexcept;
+
+    /// \brief  Identities are equal if their names and cultures are equal
+    ///         without regard to case, and their versions and tokens are equal.
+    friend bool operator==(const PeCliAssemblyIdentity &a, const PeCliAssemblyIdentity &b) noexcept;
+
+    friend bool operator!=(const PeCliAssemblyIdentity &a, const PeCliAssemblyIdentity &b) noexcept
+    {
+        return !(a == b);
+    }
+};
+
+/// \brief  Hashes a PeCliAssemblyIdentity consistently with its equality,
+///         for use in unordered containers.
+struct PeCliAssemblyIdentityHash
+{
+    size_t operator()(const PeCliAssemblyIdentity &identity) const noexcept;
+};
+
+#endif  //_EXELIB_CLIASSEMBLYIDENTITY_H_
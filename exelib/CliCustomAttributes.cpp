@@ -0,0 +1,699 @@
+/// \file   CliCustomAttributes.cpp
+/// Implementation of the CLI custom attribute decoder and queries.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "CliCustomAttributes.h"
+#include "CliRelations.h"
+#include "CliResolver.h"
+#include "CliSignature.h"
+#include "CliTypeNames.h"
+
+namespace {
+
+using ElementType = PeCliMetadataElementType;
+
+constexpr uint16_t  prolog{0x0001};
+constexpr uint32_t  null_array{0xFFFFFFFF};
+constexpr uint8_t   null_string{0xFF};
+constexpr uint16_t  field_static{0x0010};   // FieldAttributes.Static, ECMA-335, section II.23.1.5
+
+constexpr uint8_t element(ElementType type)
+{
+    return static_cast<uint8_t>(type);
+}
+
+// Return true if an element type may be the underlying type of an enum.
+bool is_enum_underlying_type(ElementType type) noexcept
+{
+    return type >= ElementType::Boolean && type <= ElementType::U8;
+}
+
+// Return the TypeDef or TypeRef declaring the constructor of a custom
+// attribute, given the encoded type column of its row. The table
+// identifier is zero if the constructor belongs to something else.
+PeCliMetadataTableIndex constructor_type(const PeCliMetadata &metadata, uint32_t constructor)
+{
+    const auto  ctor{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::CustomAttributeType, constructor)};
+    const auto *tables{metadata.metadata_tables()};
+
+    if (ctor.table_id == PeCliMetadataTableId::MethodDef)
+        return {PeCliMetadataTableId::TypeDef, tables->relations().method_owner(ctor.index)};
+
+    if (ctor.table_id == PeCliMetadataTableId::MemberRef)
+    {
+        const auto  member_refs{tables->table<PeCliMetadataRowMemberRef>()};
+
+        if (ctor.index != 0 && ctor.index <= member_refs.size())
+        {
+            const auto  parent{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::MemberRefParent,
+                                                                 member_refs.row(ctor.index - 1).class_)};
+
+            if (parent.table_id == PeCliMetadataTableId::TypeDef || parent.table_id == PeCliMetadataTableId::TypeRef)
+                return parent;
+        }
+    }
+
+    return {PeCliMetadataTableId::Module, 0};
+}
+
+// Return true if a TypeDef or TypeRef row has the given namespace and name.
+bool type_has_name(const PeCliMetadata &metadata, PeCliMetadataTableIndex type, StringView name_space, StringView name)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (type.index == 0)
+        return false;
+
+    if (type.table_id == PeCliMetadataTableId::TypeDef)
+    {
+        const auto  type_defs{tables->table<PeCliMetadataRowTypeDef>()};
+
+        if (type.index > type_defs.size())
+            return false;
+
+        const auto  row{type_defs.row(type.index - 1)};
+
+        return metadata.get_string_view(row.type_name) == name && metadata.get_string_view(row.type_namespace) == name_space;
+    }
+
+    if (type.table_id == PeCliMetadataTableId::TypeRef)
+    {
+        const auto  type_refs{tables->table<PeCliMetadataRowTypeRef>()};
+
+        if (type.index > type_refs.size())
+            return false;
+
+        const auto  row{type_refs.row(type.index - 1)};
+
+        return metadata.get_string_view(row.type_name) == name && metadata.get_string_view(row.type_namespace) == name_space;
+    }
+
+    return false;
+}
+
+// The type of an argument: a primitive, String, TypeArg, or CustomAttrBoxed,
+// or a single-dimension array of one of those.
+struct ArgumentType
+{
+    uint8_t     type;
+    bool        is_array;
+    StringView  enum_type;
+};
+
+class AttributeDecoder
+{
+public:
+    AttributeDecoder(const PeCliMetadata &metadata, BytesView value, PeCliCustomAttributeVisitor &visitor) noexcept
+      : _metadata{metadata},
+        _value{value},
+        _visitor{visitor}
+    {}
+
+    size_t decode(BytesView constructor_signature)
+    {
+        PeCliSignatureReader    signature{constructor_signature};
+
+        if (read_le(2) != prolog)
+            throw std::runtime_error("Malformed custom attribute: missing prolog");
+
+        const uint8_t   calling_convention{signature.read_byte()};
+
+        if (calling_convention & static_cast<uint8_t>(PeCliCallingConvention::Generic))
+            signature.read_compressed_unsigned();
+
+        const uint32_t  parameter_count{signature.read_compressed_unsigned()};
+
+        if (signature.read_byte() != element(ElementType::Void))
+            throw std::runtime_error("Malformed custom attribute: constructor does not return void");
+
+        for (uint32_t i = 0; i < parameter_count; ++i)
+        {
+            std::string enum_name;
+            const auto  type{parameter_type(signature, enum_name)};
+
+            _visitor.fixed_argument(i);
+            decode_argument(type);
+        }
+
+        // Attributes written by some compilers end without a count of named arguments.
+        if (_pos == _value.size())
+            return _pos;
+
+        const auto  named_count{static_cast<uint16_t>(read_le(2))};
+
+        for (uint32_t i = 0; i < named_count; ++i)
+        {
+            const uint8_t   kind{read_byte()};
+
+            if (kind != element(ElementType::CustomAttrField) && kind != element(ElementType::CustomAttrProp))
+                throw std::runtime_error("Malformed custom attribute: named argument is neither field nor property");
+
+            const auto  type{field_or_property_type()};
+            bool        is_null;
+            const auto  name{read_ser_string(is_null)};
+
+            _visitor.named_argument(kind == element(ElementType::CustomAttrProp), name);
+            decode_argument(type);
+        }
+
+        return _pos;
+    }
+
+private:
+    uint8_t read_byte()
+    {
+        if (_pos >= _value.size())
+            throw std::runtime_error("Malformed custom attribute: value is truncated");
+
+        return _value[_pos++];
+    }
+
+    uint64_t read_le(size_t size)
+    {
+        if (_value.size() - _pos < size)
+            throw std::runtime_error("Malformed custom attribute: value is truncated");
+
+        uint64_t    rv{0};
+
+        for (size_t i = 0; i < size; ++i)
+            rv |= static_cast<uint64_t>(_value[_pos + i]) << (8 * i);
+
+        _pos += size;
+        return rv;
+    }
+
+    // A SerString: a compressed length and UTF-8 characters, or 0xFF for null.
+    StringView read_ser_string(bool &is_null)
+    {
+        if (_pos < _value.size() && _value[_pos] == null_string)
+        {
+            ++_pos;
+            is_null = true;
+            return {};
+        }
+
+        PeCliSignatureReader    reader{_value.subview(_pos)};
+        const uint32_t          length{reader.read_compressed_unsigned()};
+
+        _pos += reader.position();
+        if (_value.size() - _pos < length)
+            throw std::runtime_error("Malformed custom attribute: string is truncated");
+
+        is_null = false;
+        _pos += length;
+        return {reinterpret_cast<const char *>(_value.data() + _pos - length), length};
+    }
+
+    // Read the type of a constructor parameter from its signature.
+    ArgumentType parameter_type(PeCliSignatureReader &signature, std::string &enum_name, bool in_array = false)
+    {
+        uint8_t byte{signature.read_byte()};
+
+        while (byte == element(ElementType::CModReq) || byte == element(ElementType::CModOpt))
+        {
+            signature.read_type_def_or_ref();
+            byte = signature.read_byte();
+        }
+
+        if (byte >= element(ElementType::Boolean) && byte <= element(ElementType::String))
+            return {byte, false, {}};
+
+        switch (static_cast<ElementType>(byte))
+        {
+            case ElementType::Object:
+                return {element(ElementType::CustomAttrBoxed), false, {}};
+
+            case ElementType::SzArray:
+                if (!in_array)
+                {
+                    auto    rv{parameter_type(signature, enum_name, true)};
+
+                    rv.is_array = true;
+                    return rv;
+                }
+                break;
+
+            case ElementType::Class:
+            {
+                const auto  type{signature.read_type_def_or_ref()};
+
+                if (type_has_name(_metadata, type, "System", "Type"))
+                    return {element(ElementType::TypeArg), false, {}};
+                if (type_has_name(_metadata, type, "System", "Object"))
+                    return {element(ElementType::CustomAttrBoxed), false, {}};
+                break;
+            }
+
+            case ElementType::ValueType:
+            {
+                // A value type parameter of an attribute constructor must be an enum.
+                const auto  type{signature.read_type_def_or_ref()};
+
+                enum_name = _metadata.type_names().name(type.token()).str();
+                return {enum_type(type, enum_name), false, enum_name};
+            }
+
+            default:
+                break;
+        }
+
+        throw std::runtime_error("Malformed custom attribute: constructor has a parameter of a type not allowed in attributes");
+    }
+
+    // Read a FieldOrPropType from the value. ECMA-335, section II.23.3.
+    ArgumentType field_or_property_type(bool in_array = false)
+    {
+        const uint8_t   byte{read_byte()};
+
+        if ((byte >= element(ElementType::Boolean) && byte <= element(ElementType::String))
+            || byte == element(ElementType::TypeArg) || byte == element(ElementType::CustomAttrBoxed))
+        {
+            return {byte, false, {}};
+        }
+
+        if (byte == element(ElementType::SzArray) && !in_array)
+        {
+            auto    rv{field_or_property_type(true)};
+
+            rv.is_array = true;
+            return rv;
+        }
+
+        if (byte == element(ElementType::CustomAttrEnum))
+        {
+            bool        is_null;
+            const auto  name{read_ser_string(is_null)};
+
+            return {enum_type(name), false, name};
+        }
+
+        throw std::runtime_error("Malformed custom attribute: invalid argument type");
+    }
+
+    void decode_argument(const ArgumentType &type)
+    {
+        if (!type.is_array)
+        {
+            decode_element(type.type, type.enum_type);
+            return;
+        }
+
+        const auto  count{static_cast<uint32_t>(read_le(4))};
+
+        if (count == null_array)
+        {
+            PeCliCustomAttributeValue   value{};
+
+            value.type = ElementType::SzArray;
+            value.is_null = true;
+            _visitor.value(value);
+            return;
+        }
+
+        // Each element takes at least one byte, which bounds a hostile count.
+        if (count > _value.size() - _pos)
+            throw std::runtime_error("Malformed custom attribute: array is truncated");
+
+        _visitor.begin_array(count);
+        for (uint32_t i = 0; i < count; ++i)
+            decode_element(type.type, type.enum_type);
+        _visitor.end_array();
+    }
+
+    void decode_element(uint8_t type, StringView enum_type)
+    {
+        PeCliCustomAttributeValue   value{};
+
+        value.type = static_cast<ElementType>(type);
+        value.enum_type = enum_type;
+
+        switch (value.type)
+        {
+            case ElementType::CustomAttrBoxed:
+                // The value is preceded by its own type.
+                decode_argument(field_or_property_type());
+                return;
+
+            case ElementType::String:
+            case ElementType::TypeArg:
+                value.string = read_ser_string(value.is_null);
+                break;
+
+            case ElementType::Boolean:
+            case ElementType::U1:
+                value.integer = static_cast<int64_t>(read_le(1));
+                break;
+            case ElementType::I1:
+                value.integer = static_cast<int8_t>(read_le(1));
+                break;
+            case ElementType::Char:
+            case ElementType::U2:
+                value.integer = static_cast<int64_t>(read_le(2));
+                break;
+            case ElementType::I2:
+                value.integer = static_cast<int16_t>(read_le(2));
+                break;
+            case ElementType::U4:
+                value.integer = static_cast<int64_t>(read_le(4));
+                break;
+            case ElementType::I4:
+                value.integer = static_cast<int32_t>(read_le(4));
+                break;
+            case ElementType::I8:
+            case ElementType::U8:
+                value.integer = static_cast<int64_t>(read_le(8));
+                break;
+
+            case ElementType::R4:
+            {
+                const auto  bits{static_cast<uint32_t>(read_le(4))};
+                float       real;
+
+                std::memcpy(&real, &bits, sizeof(real));
+                value.real = real;
+                break;
+            }
+            case ElementType::R8:
+            {
+                const auto  bits{read_le(8)};
+
+                std::memcpy(&value.real, &bits, sizeof(value.real));
+                break;
+            }
+
+            default:
+                throw std::runtime_error("Malformed custom attribute: invalid argument type");
+        }
+
+        _visitor.value(value);
+    }
+
+    uint8_t enum_type(PeCliMetadataTableIndex type, StringView name)
+    {
+        const auto  local{type.table_id == PeCliMetadataTableId::TypeDef ? get_enum_underlying_type(_metadata, type.index) : ElementType::End};
+
+        return local != ElementType::End ? element(local) : visitor_enum_type(name);
+    }
+
+    uint8_t enum_type(StringView name)
+    {
+        // An enum named without an assembly, or with one, may still be defined here.
+        size_t  length{0};
+
+        while (length < name.size() && name[length] != ',')
+            ++length;
+
+        const auto  type_def{_metadata.type_names().find_type_def({name.data(), length})};
+
+        if (type_def != 0)
+        {
+            const auto  local{get_enum_underlying_type(_metadata, PeCliMetadataTableIndex::from_token(type_def).index)};
+
+            if (local != ElementType::End)
+                return element(local);
+        }
+
+        return visitor_enum_type(name);
+    }
+
+    // Ask the visitor for the underlying type of an enum defined elsewhere.
+    // Reading on with a guessed size would lose the place in the blob and
+    // report the wrong fault, so an unknown type stops the decoding.
+    uint8_t visitor_enum_type(StringView name)
+    {
+        const auto  type{_visitor.enum_underlying_type(name)};
+
+        if (!is_enum_underlying_type(type))
+            throw PeCliUnresolvedEnumError{name.str()};
+
+        return element(type);
+    }
+
+    const PeCliMetadata            &_metadata;
+    BytesView                       _value;
+    size_t                          _pos{0};
+    PeCliCustomAttributeVisitor    &_visitor;
+};
+
+// Return true if two assembly names are equal. Assembly names are compared
+// without regard to the case of ASCII letters.
+bool same_assembly_name(StringView a, StringView b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+
+    return true;
+}
+
+StringView trim(StringView str) noexcept
+{
+    size_t  begin{0};
+    size_t  end{str.size()};
+
+    while (begin < end && str[begin] == ' ')
+        ++begin;
+    while (end > begin && str[end - 1] == ' ')
+        --end;
+
+    return {str.data() + begin, end - begin};
+}
+
+}   // anonymous namespace
+
+
+PeCliMetadataElementType get_enum_underlying_type(const PeCliMetadata &metadata, uint32_t type_def)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr || type_def == 0 || type_def > tables->table<PeCliMetadataRowTypeDef>().size())
+        return ElementType::End;
+
+    const auto  fields{tables->table<PeCliMetadataRowField>()};
+
+    for (auto field : tables->relations().fields(type_def))
+    {
+        if (field == 0 || field > fields.size())
+            continue;
+
+        const auto  row{fields.row(field - 1)};
+
+        if (row.flags & field_static)
+            continue;
+
+        const auto  signature{metadata.get_blob_view(row.signature)};
+
+        if (signature.size() >= 2 && signature[0] == static_cast<uint8_t>(PeCliCallingConvention::FieldSig)
+            && is_enum_underlying_type(static_cast<ElementType>(signature[1])))
+        {
+            return static_cast<ElementType>(signature[1]);
+        }
+
+        return ElementType::End;
+    }
+
+    return ElementType::End;
+}
+
+
+PeCliMetadataElementType PeCliResolvingAttributeVisitor::enum_underlying_type(StringView type_name)
+{
+    auto    it{_enum_types.find(type_name.str())};
+
+    if (it != _enum_types.end())
+        return it->second;
+
+    // The name may be followed by the display name of its assembly.
+    size_t  comma{0};
+
+    while (comma < type_name.size() && type_name[comma] != ',')
+        ++comma;
+
+    StringView  assembly_name;
+
+    if (comma < type_name.size())
+    {
+        const StringView    rest{type_name.data() + comma + 1, type_name.size() - comma - 1};
+        size_t              end{0};
+
+        while (end < rest.size() && rest[end] != ',')
+            ++end;
+        assembly_name = trim({rest.data(), end});
+    }
+
+    PeCliMetadataElementType    rv{ElementType::End};
+
+    try
+    {
+        rv = resolve_enum(trim({type_name.data(), comma}), assembly_name);
+    }
+    catch (const std::exception &)
+    {
+        // An assembly that cannot be loaded leaves the type unknown.
+    }
+
+    _enum_types.emplace(type_name.str(), rv);
+    return rv;
+}
+
+PeCliMetadataElementType PeCliResolvingAttributeVisitor::resolve_enum(StringView type_name, StringView assembly_name)
+{
+    const auto &metadata{_assembly.metadata()};
+
+    // A TypeRef says exactly where the type is defined.
+    const auto  type_ref{_assembly.type_names().find_type_ref(type_name)};
+
+    if (type_ref != 0)
+    {
+        const auto  type{_resolver.resolve_type(_assembly, type_ref)};
+
+        if (type)
+            return get_enum_underlying_type(type.assembly->metadata(), PeCliMetadataTableIndex::from_token(type.type_def).index);
+    }
+
+    // Otherwise look in the assembly named, or, if none is, in the core
+    // library, which is where ECMA-335 says such a type is found.
+    const auto  assembly_refs{metadata.metadata_tables()->table<PeCliMetadataRowAssemblyRef>()};
+
+    for (uint32_t row = 1; row <= assembly_refs.size(); ++row)
+    {
+        const auto  name{metadata.get_string_view(assembly_refs.row(row - 1).name)};
+        bool        candidate{false};
+
+        if (!assembly_name.empty())
+        {
+            candidate = same_assembly_name(name, assembly_name);
+        }
+        else
+        {
+            for (const auto *core_library : {"mscorlib", "System.Private.CoreLib", "System.Runtime", "netstandard"})
+                candidate = candidate || same_assembly_name(name, StringView{core_library});
+        }
+
+        if (!candidate)
+            continue;
+
+        const auto  type{_resolver.find_type(_resolver.resolve_assembly(_assembly, row), type_name)};
+
+        if (type)
+            return get_enum_underlying_type(type.assembly->metadata(), PeCliMetadataTableIndex::from_token(type.type_def).index);
+    }
+
+    return ElementType::End;
+}
+
+
+size_t decode_custom_attribute(const PeCliMetadata &metadata, uint32_t row, PeCliCustomAttributeVisitor &visitor)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr)
+        throw std::runtime_error("CLI metadata tables are not loaded");
+
+    const auto  attributes{tables->table<PeCliMetadataRowCustomAttribute>()};
+
+    if (row == 0 || row > attributes.size())
+        throw std::out_of_range("CustomAttribute row out of range");
+
+    const auto  attribute{attributes.row(row - 1)};
+    const auto  ctor{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::CustomAttributeType, attribute.type)};
+    uint32_t    signature{0};
+
+    if (ctor.table_id == PeCliMetadataTableId::MethodDef && ctor.index != 0
+        && ctor.index <= tables->table<PeCliMetadataRowMethodDef>().size())
+    {
+        signature = tables->table<PeCliMetadataRowMethodDef>().row(ctor.index - 1).signature;
+    }
+    else if (ctor.table_id == PeCliMetadataTableId::MemberRef && ctor.index != 0
+             && ctor.index <= tables->table<PeCliMetadataRowMemberRef>().size())
+    {
+        signature = tables->table<PeCliMetadataRowMemberRef>().row(ctor.index - 1).signature;
+    }
+    else
+    {
+        throw std::runtime_error("Malformed custom attribute: constructor is not a MethodDef or MemberRef");
+    }
+
+    return AttributeDecoder{metadata, metadata.get_blob_view(attribute.value), visitor}.decode(metadata.get_blob_view(signature));
+}
+
+uint32_t find_custom_attribute(const PeCliMetadata &metadata, PeCliMetadataTableIndex parent, StringView type_name)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr)
+        return 0;
+
+    const auto  attributes{tables->table<PeCliMetadataRowCustomAttribute>()};
+    const auto &type_names{metadata.type_names()};
+
+    for (auto row : tables->relations().custom_attributes(parent))
+    {
+        const auto  type{constructor_type(metadata, attributes.row(row - 1).type)};
+
+        if (type.index != 0 && type_names.name(type.token()) == type_name)
+            return row;
+    }
+
+    return 0;
+}
+
+std::vector<uint32_t> find_custom_attributes(const PeCliMetadata &metadata, StringView type_name)
+{
+    std::vector<uint32_t>   rv;
+    const auto             *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr)
+        return rv;
+
+    const auto &relations{tables->relations()};
+    const auto &type_names{metadata.type_names()};
+    const auto  method_defs{tables->table<PeCliMetadataRowMethodDef>()};
+    const auto  member_refs{tables->table<PeCliMetadataRowMemberRef>()};
+
+    auto    add_uses = [&](PeCliMetadataTableIndex ctor) {
+                           const auto   key{PeCliMetadataSchema::encode_index(PeCliEncodedIndexType::CustomAttributeType, ctor)};
+
+                           for (auto row : relations.find_rows(PeCliMetadataTableId::CustomAttribute, 1, key))
+                               rv.push_back(row);
+                       };
+    auto    add_constructors = [&](PeCliMetadataTableIndex type) {
+                                   const auto   key{PeCliMetadataSchema::encode_index(PeCliEncodedIndexType::MemberRefParent, type)};
+
+                                   for (auto row : relations.find_rows(PeCliMetadataTableId::MemberRef, 0, key))
+                                       if (metadata.get_string_view(member_refs.row(row - 1).name) == ".ctor")
+                                           add_uses({PeCliMetadataTableId::MemberRef, row});
+                               };
+
+    const auto  type_def{PeCliMetadataTableIndex::from_token(type_names.find_type_def(type_name))};
+
+    if (type_def.index != 0)
+    {
+        for (auto method : relations.methods(type_def.index))
+            if (method != 0 && method <= method_defs.size()
+                && metadata.get_string_view(method_defs.row(method - 1).name) == ".ctor")
+            {
+                add_uses({PeCliMetadataTableId::MethodDef, method});
+            }
+        add_constructors(type_def);
+    }
+
+    for (auto type_ref : type_names.find_type_refs(type_name))
+        add_constructors(PeCliMetadataTableIndex::from_token(type_ref));
+
+    std::sort(rv.begin(), rv.end());
+    rv.erase(std::unique(rv.begin(), rv.end()), rv.end());
+
+    return rv;
+}
@@ -0,0 +1,199 @@
+/// \file   CliCustomAttributes.h
+/// Provides a decoder for the values of custom attributes, stored in the
+/// \#Blob heap of CLI metadata as described in ECMA-335, section II.23.3,
+/// and lookup of custom attributes by the type of their constructor.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLICUSTOMATTRIBUTES_H_
+#define _EXELIB_CLICUSTOMATTRIBUTES_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+class PeCliAssembly;
+class PeCliAssemblyResolver;
+
+/// \brief  A single value of a custom attribute argument.
+struct PeCliCustomAttributeValue
+{
+    /// The type of the value: Boolean through R8, String, or TypeArg for a
+    /// System.Type, which is given by its name. For an enum, this is the
+    /// underlying type of the enum. For a null array it is SzArray.
+    PeCliMetadataElementType    type;
+    StringView                  enum_type;  ///< The fully-qualified name of the enum type, if the value is an enum
+    bool                        is_null;    ///< \c true for a null string, type, or array
+    int64_t                     integer;    ///< The value of a Boolean, Char, or integer, sign-extended if the type is signed
+    double                      real;       ///< The value of an R4 or R8
+    StringView                  string;     ///< The UTF-8 content of a String, or the name of a type
+};
+
+/// \brief  Receives the arguments of a decoded custom attribute.
+///
+/// The fixed arguments, those passed to the constructor, are reported
+/// first, in order, and then the named arguments, which set fields and
+/// properties. Each argument is announced by fixed_argument() or
+/// named_argument() and is followed either by a single call to value(), or
+/// by begin_array(), a call to value() for each element, and end_array().
+///
+/// The default implementations do nothing, so a visitor needs to override
+/// only the functions it is interested in.
+class PeCliCustomAttributeVisitor
+{
+public:
+    virtual ~PeCliCustomAttributeVisitor() = default;
+
+    /// \brief  The next value is the constructor argument with the given zero-based index.
+    virtual void fixed_argument(uint32_t /*index*/)
+    {}
+
+    /// \brief  The next value is assigned to a field or property.
+    /// \param is_property  \c true for a property, \c false for a field.
+    /// \param name         The name of the field or property.
+    virtual void named_argument(bool /*is_property*/, StringView /*name*/)
+    {}
+
+    /// \brief  A value, or an element of an array.
+    virtual void value(const PeCliCustomAttributeValue & /*value*/)
+    {}
+
+    /// \brief  Start of an array of \p count elements.
+    virtual void begin_array(uint32_t /*count*/)
+    {}
+
+    /// \brief  End of an array.
+    virtual void end_array()
+    {}
+
+    /// \brief  Return the underlying type of an enum that is not defined in
+    ///         the metadata being decoded, which is needed to know the size
+    ///         of its values.
+    /// \param type_name    The fully-qualified name of the enum, possibly
+    ///                     followed by a comma and the name of its assembly.
+    /// \return The underlying type, Boolean, Char, or I1 through U8, or
+    ///         PeCliMetadataElementType::End if it is not known.
+    ///
+    /// The default implementation returns PeCliMetadataElementType::End,
+    /// since only the assembly defining the enum can say how large its
+    /// values are. PeCliResolvingAttributeVisitor finds that assembly
+    /// through a PeCliAssemblyResolver.
+    virtual PeCliMetadataElementType enum_underlying_type(StringView /*type_name*/)
+    {
+        return PeCliMetadataElementType::End;
+    }
+};
+
+/// \brief  A visitor that finds the underlying types of enums defined in
+///         other assemblies through a PeCliAssemblyResolver.
+///
+/// An enum is looked for, in order, through a TypeRef with its name in the
+/// assembly whose attributes are decoded; in the assembly named with it,
+/// if it is one the assembly refers to; and, if no assembly is named, in
+/// the core library the assembly refers to. Type forwarders are followed.
+/// The answer for each name is remembered, so a visitor used for many
+/// attributes of the same assembly resolves each enum only once.
+///
+/// Derive from this class, rather than from PeCliCustomAttributeVisitor,
+/// to receive the decoded values.
+class PeCliResolvingAttributeVisitor : public PeCliCustomAttributeVisitor
+{
+public:
+    /// \brief  Construct a visitor.
+    /// \param resolver The resolver through which to load other assemblies.
+    /// \param assembly The assembly whose custom attributes are decoded.
+    ///                 Both must outlive the visitor.
+    PeCliResolvingAttributeVisitor(PeCliAssemblyResolver &resolver, const PeCliAssembly &assembly) noexcept
+      : _resolver{resolver},
+        _assembly{assembly}
+    {}
+
+    PeCliMetadataElementType enum_underlying_type(StringView type_name) override;
+
+private:
+    PeCliMetadataElementType resolve_enum(StringView type_name, StringView assembly_name);
+
+    PeCliAssemblyResolver                                       &_resolver;
+    const PeCliAssembly                                         &_assembly;
+    std::unordered_map<std::string, PeCliMetadataElementType>   _enum_types;
+};
+
+/// \brief  The exception thrown when a custom attribute cannot be decoded
+///         because the underlying type of an enum it uses is not known.
+///
+/// The value blob itself may be well formed; it just cannot be read without
+/// knowing how large the enum's values are.
+class PeCliUnresolvedEnumError : public std::runtime_error
+{
+public:
+    explicit PeCliUnresolvedEnumError(const std::string &type_name)
+      : std::runtime_error{"Cannot decode custom attribute: the underlying type of enum '" + type_name + "' is not known"},
+        _type_name{type_name}
+    {}
+
+    /// \brief  Return the name of the enum, as the attribute gives it.
+    const std::string &type_name() const noexcept
+    {
+        return _type_name;
+    }
+
+private:
+    std::string _type_name;
+};
+
+/// \brief  Return the underlying type of an enum defined in \p metadata,
+///         which is the type of its one instance field, \c value__.
+/// \param metadata The metadata, with its tables and heaps loaded.
+/// \param type_def The one-based TypeDef row number of the enum.
+/// \return Boolean, Char, or I1 through U8, or PeCliMetadataElementType::End
+///         if the type is not an enum.
+PeCliMetadataElementType get_enum_underlying_type(const PeCliMetadata &metadata, uint32_t type_def);
+
+/// \brief  Decode the value of a custom attribute.
+/// \param metadata     The metadata holding the CustomAttribute table, with its tables and heaps loaded.
+/// \param row          The one-based CustomAttribute row number.
+/// \param visitor      Receives the arguments of the attribute.
+/// \return The number of bytes of the value blob decoded.
+///
+/// The constructor's signature gives the types of the fixed arguments.
+/// The underlying type of an enum defined in \p metadata is found from its
+/// value__ field; for any other enum, \p visitor is asked.
+///
+/// A PeCliUnresolvedEnumError exception is thrown if \p visitor does not
+/// know the underlying type of an enum; the arguments before it have been
+/// reported by then. A \c std::runtime_error exception is thrown if the
+/// value or the constructor's signature is malformed, and a
+/// \c std::out_of_range exception if \p row is not a row of the
+/// CustomAttribute table.
+size_t decode_custom_attribute(const PeCliMetadata &metadata, uint32_t row, PeCliCustomAttributeVisitor &visitor);
+
+/// \brief  Return the first CustomAttribute row attached to \p parent whose
+///         constructor belongs to the type with the given fully-qualified
+///         name, such as \c System.ObsoleteAttribute, or zero if there is none.
+///
+/// The attributes of \p parent are found through
+/// PeCliMetadataRelations::custom_attributes, and the names of their types
+/// through PeCliMetadata::type_names(), in which a nested type's name has
+/// the form \c Outer+Inner. Generic attribute instantiations are not matched.
+uint32_t find_custom_attribute(const PeCliMetadata &metadata, PeCliMetadataTableIndex parent, StringView type_name);
+
+/// \brief  Return, in table order, every CustomAttribute row whose constructor
+///         belongs to the type with the given fully-qualified name.
+///
+/// The TypeDef and TypeRef rows with the name are found in
+/// PeCliMetadata::type_names(), in which a nested type's name has the form
+/// \c Outer+Inner, and then the constructors of each and the attributes
+/// using each constructor through PeCliMetadataRelations::find_rows. The
+/// orderings of the MemberRef and CustomAttribute tables that it builds,
+/// if they are not sorted, are built on the first call and reused by later
+/// ones. Generic attribute instantiations are not matched.
+std::vector<uint32_t> find_custom_attributes(const PeCliMetadata &metadata, StringView type_name);
+
+#endif  //_EXELIB_CLICUSTOMATTRIBUTES_H_
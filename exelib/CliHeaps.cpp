@@ -0,0 +1,97 @@
+/// \file   CliHeaps.cpp
+/// Implementation of the decoding of CLI metadata heap entries.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "CliHeaps.h"
+
+namespace {
+
+// Return a view of the content of an entry in a #US or #Blob CLI metadata
+// stream, whose compressed length begins at the given offset, and set next
+// to the offset of the entry that follows it. ECMA-335, section II.24.2.4.
+BytesView read_length_prefixed(BytesView heap, uint32_t offset, uint32_t &next)
+{
+    const size_t    available{heap.size() - offset};
+    const uint8_t   b1{heap[offset]};
+    size_t          header_size;
+    uint32_t        len;
+
+    if ((b1 & 0b10000000) == 0b00000000)
+    {
+        header_size = 1;
+        len = b1;
+    }
+    else if ((b1 & 0b11000000) == 0b10000000)
+    {
+        header_size = 2;
+        if (available < header_size)
+            throw std::out_of_range("Length in #US or #Blob stream is truncated.");
+        len = ((static_cast<uint32_t>(b1) & 0b00111111) << 8) | heap[offset + 1];
+    }
+    else if ((b1 & 0b11100000) == 0b11000000)
+    {
+        header_size = 4;
+        if (available < header_size)
+            throw std::out_of_range("Length in #US or #Blob stream is truncated.");
+        len =    ((static_cast<uint32_t>(b1) & 0b00011111) << 24)
+                | (static_cast<uint32_t>(heap[offset + 1]) << 16)
+                | (static_cast<uint32_t>(heap[offset + 2]) << 8)
+                | (static_cast<uint32_t>(heap[offset + 3]));
+    }
+    else
+    {
+        throw std::runtime_error("Length in #US or #Blob stream is invalid.");
+    }
+
+    if (len > available - header_size)
+        throw std::out_of_range("Entry in #US or #Blob stream extends beyond the stream.");
+
+    next = static_cast<uint32_t>(offset + header_size + len);
+    return heap.subview(offset + header_size, len);
+}
+
+}   // anonymous namespace
+
+
+std::u16string PeCliUserStringsHeapEntry::str() const
+{
+    std::u16string  rv;
+
+    // The final odd byte, if any, is the flag byte, not part of a character.
+    rv.reserve(value.size() / 2);
+    for (size_t i = 0; i + 1 < value.size(); i += 2)
+        rv.push_back(static_cast<char16_t>(value[i] | (value[i + 1] << 8)));
+
+    return rv;
+}
+
+template<>
+PeCliStringsHeapEntry PeCliHeap<PeCliStringsHeapEntry>::read(uint32_t offset, uint32_t &next) const
+{
+    const auto *begin{reinterpret_cast<const char *>(_bytes.data()) + offset};
+    const auto *end{static_cast<const char *>(std::memchr(begin, 0, _bytes.size() - offset))};
+
+    if (end == nullptr)
+        throw std::out_of_range("String is not terminated within the #Strings stream.");
+
+    next = static_cast<uint32_t>(offset + (end - begin) + 1);
+    return {offset, StringView{begin, static_cast<size_t>(end - begin)}};
+}
+
+template<>
+PeCliUserStringsHeapEntry PeCliHeap<PeCliUserStringsHeapEntry>::read(uint32_t offset, uint32_t &next) const
+{
+    return {offset, read_length_prefixed(_bytes, offset, next)};
+}
+
+template<>
+PeCliBlobHeapEntry PeCliHeap<PeCliBlobHeapEntry>::read(uint32_t offset, uint32_t &next) const
+{
+    return {offset, read_length_prefixed(_bytes, offset, next)};
+}
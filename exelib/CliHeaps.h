@@ -0,0 +1,261 @@
+/// \file   CliHeaps.h
+/// Provides enumeration of, and indexed access to, the entries in the
+/// \#Strings, \#US, and \#Blob CLI metadata heaps, working in place over
+/// the heap data.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIHEAPS_H_
+#define _EXELIB_CLIHEAPS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "views.h"
+
+
+/// \brief  An entry in the \#Strings heap: a nul-terminated UTF-8 string.
+struct PeCliStringsHeapEntry
+{
+    uint32_t    offset;     ///< Offset of the entry within the heap, which is how metadata refers to it
+    StringView  value;      ///< The string, without its terminator
+};
+
+/// \brief  An entry in the \#US heap: a UTF-16 string.
+struct PeCliUserStringsHeapEntry
+{
+    uint32_t    offset;     ///< Offset of the entry's length prefix within the heap
+    BytesView   value;      ///< The UTF-16LE characters followed by a final flag byte
+
+    /// \brief  Return the string, without the final flag byte.
+    std::u16string str() const;
+
+    /// \brief  Return \c true if the final flag byte is set, indicating that the
+    ///         string contains characters that require special handling.
+    ///         ECMA-335, section II.24.2.4.
+    bool has_special_characters() const noexcept
+    {
+        return (value.size() & 1) != 0 && value[value.size() - 1] != 0;
+    }
+};
+
+/// \brief  An entry in the \#Blob heap.
+struct PeCliBlobHeapEntry
+{
+    uint32_t    offset;     ///< Offset of the entry's length prefix within the heap, which is how metadata refers to it
+    BytesView   value;      ///< The content of the blob
+};
+
+/// \brief  A view of a CLI metadata heap, whose entries are of type \p Entry.
+///
+/// Entries are enumerated by iterating from begin() to end(), which decodes
+/// each entry in turn directly from the heap data. Entries may also be
+/// looked up by their offset, with entry_at(), or by their position, with
+/// operator[]. The first lookup by position builds an index of the offsets
+/// of the entries, which takes one pass over the heap; that may be done
+/// concurrently from several threads. If the heap is malformed, the
+/// exception raised by that pass is raised again by every later lookup by
+/// position, without another pass.
+///
+/// A heap is owned by the PeCliMetadata object whose stream it views, and
+/// is valid only as long as that object.
+template<typename Entry>
+class PeCliHeap
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry *;
+        using reference = const Entry &;
+
+        const_iterator() = default;
+
+        const Entry &operator*() const noexcept
+        {
+            return _entry;
+        }
+
+        const Entry *operator->() const noexcept
+        {
+            return &_entry;
+        }
+
+        const_iterator &operator++()
+        {
+            decode(_next);
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto    rv{*this};
+
+            ++*this;
+            return rv;
+        }
+
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return _entry.offset == other._entry.offset && _heap == other._heap;
+        }
+
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class PeCliHeap;
+
+        const_iterator(const PeCliHeap *heap, uint32_t offset)
+          : _heap{heap}
+        {
+            decode(offset);
+        }
+
+        void decode(uint32_t offset)
+        {
+            if (offset < _heap->_bytes.size())
+                _entry = _heap->read(offset, _next);
+            else
+                _entry.offset = static_cast<uint32_t>(_heap->_bytes.size());
+        }
+
+        const PeCliHeap    *_heap{nullptr};
+        Entry               _entry{};
+        uint32_t            _next{0};
+    };
+
+    PeCliHeap() = default;
+    PeCliHeap(const PeCliHeap &) = delete;
+    PeCliHeap &operator=(const PeCliHeap &) = delete;
+
+    /// \brief  Return the raw content of the heap.
+    BytesView bytes() const noexcept
+    {
+        return _bytes;
+    }
+
+    bool empty() const noexcept
+    {
+        return _bytes.empty();
+    }
+
+    /// \brief  Return an iterator to the first entry.
+    ///
+    /// Iteration throws a \c std::out_of_range exception on reaching an
+    /// entry that extends beyond the end of the heap, or a
+    /// \c std::runtime_error exception if a length prefix is invalid.
+    const_iterator begin() const
+    {
+        return {this, 0};
+    }
+
+    const_iterator end() const
+    {
+        return {this, static_cast<uint32_t>(_bytes.size())};
+    }
+
+    /// \brief  Return the entry at \p offset within the heap.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p offset is outside
+    /// the heap or the entry extends beyond it.
+    Entry entry_at(uint32_t offset) const
+    {
+        uint32_t    next;
+
+        if (offset >= _bytes.size())
+            throw std::out_of_range("Offset into CLI metadata heap is out of range.");
+
+        return read(offset, next);
+    }
+
+    /// \brief  Return the number of entries in the heap, building the offset index if necessary.
+    size_t size() const
+    {
+        return offsets().size();
+    }
+
+    /// \brief  Return the entry at position \p index, counting from zero,
+    ///         building the offset index if necessary. No bounds checking is performed.
+    Entry operator[](size_t index) const
+    {
+        uint32_t    next;
+
+        return read(offsets()[index], next);
+    }
+
+    /// \brief  Return the entry at position \p index, counting from zero,
+    ///         building the offset index if necessary.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p index is not less than size().
+    Entry at(size_t index) const
+    {
+        if (index >= size())
+            throw std::out_of_range("Index of CLI metadata heap entry is out of range.");
+
+        return (*this)[index];
+    }
+
+private:
+    friend class PeCliMetadata;
+
+    // Decode the entry at offset, which is within the heap, and set next to the offset of the entry following it.
+    Entry read(uint32_t offset, uint32_t &next) const;
+
+    const std::vector<uint32_t> &offsets() const
+    {
+        // The index is built aside and kept only if the whole heap decodes;
+        // otherwise the failure is kept, so call_once still completes.
+        std::call_once(_offsets_once,
+                       [this]() {
+                           try
+                           {
+                               std::vector<uint32_t>   offsets;
+
+                               for (auto it = begin(); it != end(); ++it)
+                                   offsets.push_back(it->offset);
+                               _offsets = std::move(offsets);
+                           }
+                           catch (...)
+                           {
+                               _offsets_error = std::current_exception();
+                           }
+                       });
+
+        if (_offsets_error)
+            std::rethrow_exception(_offsets_error);
+
+        return _offsets;
+    }
+
+    BytesView                       _bytes;     // set by PeCliMetadata
+    mutable std::once_flag          _offsets_once;
+    mutable std::vector<uint32_t>   _offsets;   // built on first use
+    mutable std::exception_ptr      _offsets_error;     // set if the heap could not be indexed
+};
+
+template<>
+PeCliStringsHeapEntry PeCliHeap<PeCliStringsHeapEntry>::read(uint32_t offset, uint32_t &next) const;
+template<>
+PeCliUserStringsHeapEntry PeCliHeap<PeCliUserStringsHeapEntry>::read(uint32_t offset, uint32_t &next) const;
+template<>
+PeCliBlobHeapEntry PeCliHeap<PeCliBlobHeapEntry>::read(uint32_t offset, uint32_t &next) const;
+
+using PeCliStringsHeap = PeCliHeap<PeCliStringsHeapEntry>;          ///< The \#Strings heap
+using PeCliUserStringsHeap = PeCliHeap<PeCliUserStringsHeapEntry>;  ///< The \#US heap
+using PeCliBlobHeap = PeCliHeap<PeCliBlobHeapEntry>;                ///< The \#Blob heap
+
+#endif  //_EXELIB_CLIHEAPS_H_
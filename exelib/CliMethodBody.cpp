@@ -0,0 +1,611 @@
+/// \file   CliMethodBody.cpp
+/// Implementation of the CLI method body readers.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <cstring>
+#include <stdexcept>
+
+#include "CliMethodBody.h"
+
+namespace {
+
+using OT = PeCliOperandType;
+
+struct OpcodeDefinition
+{
+    const char *name;           // nullptr if the opcode is not defined
+    OT          operand_type;
+};
+
+// One-byte opcodes, indexed by opcode. ECMA-335, section III.
+constexpr OpcodeDefinition one_byte_opcodes[] =
+{
+    /* 0x00 */  {"nop", OT::InlineNone},
+    /* 0x01 */  {"break", OT::InlineNone},
+    /* 0x02 */  {"ldarg.0", OT::InlineNone},
+    /* 0x03 */  {"ldarg.1", OT::InlineNone},
+    /* 0x04 */  {"ldarg.2", OT::InlineNone},
+    /* 0x05 */  {"ldarg.3", OT::InlineNone},
+    /* 0x06 */  {"ldloc.0", OT::InlineNone},
+    /* 0x07 */  {"ldloc.1", OT::InlineNone},
+    /* 0x08 */  {"ldloc.2", OT::InlineNone},
+    /* 0x09 */  {"ldloc.3", OT::InlineNone},
+    /* 0x0A */  {"stloc.0", OT::InlineNone},
+    /* 0x0B */  {"stloc.1", OT::InlineNone},
+    /* 0x0C */  {"stloc.2", OT::InlineNone},
+    /* 0x0D */  {"stloc.3", OT::InlineNone},
+    /* 0x0E */  {"ldarg.s", OT::ShortInlineVar},
+    /* 0x0F */  {"ldarga.s", OT::ShortInlineVar},
+    /* 0x10 */  {"starg.s", OT::ShortInlineVar},
+    /* 0x11 */  {"ldloc.s", OT::ShortInlineVar},
+    /* 0x12 */  {"ldloca.s", OT::ShortInlineVar},
+    /* 0x13 */  {"stloc.s", OT::ShortInlineVar},
+    /* 0x14 */  {"ldnull", OT::InlineNone},
+    /* 0x15 */  {"ldc.i4.m1", OT::InlineNone},
+    /* 0x16 */  {"ldc.i4.0", OT::InlineNone},
+    /* 0x17 */  {"ldc.i4.1", OT::InlineNone},
+    /* 0x18 */  {"ldc.i4.2", OT::InlineNone},
+    /* 0x19 */  {"ldc.i4.3", OT::InlineNone},
+    /* 0x1A */  {"ldc.i4.4", OT::InlineNone},
+    /* 0x1B */  {"ldc.i4.5", OT::InlineNone},
+    /* 0x1C */  {"ldc.i4.6", OT::InlineNone},
+    /* 0x1D */  {"ldc.i4.7", OT::InlineNone},
+    /* 0x1E */  {"ldc.i4.8", OT::InlineNone},
+    /* 0x1F */  {"ldc.i4.s", OT::ShortInlineI},
+    /* 0x20 */  {"ldc.i4", OT::InlineI},
+    /* 0x21 */  {"ldc.i8", OT::InlineI8},
+    /* 0x22 */  {"ldc.r4", OT::ShortInlineR},
+    /* 0x23 */  {"ldc.r8", OT::InlineR},
+    /* 0x24 */  {nullptr, OT::InlineNone},
+    /* 0x25 */  {"dup", OT::InlineNone},
+    /* 0x26 */  {"pop", OT::InlineNone},
+    /* 0x27 */  {"jmp", OT::InlineMethod},
+    /* 0x28 */  {"call", OT::InlineMethod},
+    /* 0x29 */  {"calli", OT::InlineSig},
+    /* 0x2A */  {"ret", OT::InlineNone},
+    /* 0x2B */  {"br.s", OT::ShortInlineBrTarget},
+    /* 0x2C */  {"brfalse.s", OT::ShortInlineBrTarget},
+    /* 0x2D */  {"brtrue.s", OT::ShortInlineBrTarget},
+    /* 0x2E */  {"beq.s", OT::ShortInlineBrTarget},
+    /* 0x2F */  {"bge.s", OT::ShortInlineBrTarget},
+    /* 0x30 */  {"bgt.s", OT::ShortInlineBrTarget},
+    /* 0x31 */  {"ble.s", OT::ShortInlineBrTarget},
+    /* 0x32 */  {"blt.s", OT::ShortInlineBrTarget},
+    /* 0x33 */  {"bne.un.s", OT::ShortInlineBrTarget},
+    /* 0x34 */  {"bge.un.s", OT::ShortInlineBrTarget},
+    /* 0x35 */  {"bgt.un.s", OT::ShortInlineBrTarget},
+    /* 0x36 */  {"ble.un.s", OT::ShortInlineBrTarget},
+    /* 0x37 */  {"blt.un.s", OT::ShortInlineBrTarget},
+    /* 0x38 */  {"br", OT::InlineBrTarget},
+    /* 0x39 */  {"brfalse", OT::InlineBrTarget},
+    /* 0x3A */  {"brtrue", OT::InlineBrTarget},
+    /* 0x3B */  {"beq", OT::InlineBrTarget},
+    /* 0x3C */  {"bge", OT::InlineBrTarget},
+    /* 0x3D */  {"bgt", OT::InlineBrTarget},
+    /* 0x3E */  {"ble", OT::InlineBrTarget},
+    /* 0x3F */  {"blt", OT::InlineBrTarget},
+    /* 0x40 */  {"bne.un", OT::InlineBrTarget},
+    /* 0x41 */  {"bge.un", OT::InlineBrTarget},
+    /* 0x42 */  {"bgt.un", OT::InlineBrTarget},
+    /* 0x43 */  {"ble.un", OT::InlineBrTarget},
+    /* 0x44 */  {"blt.un", OT::InlineBrTarget},
+    /* 0x45 */  {"switch", OT::InlineSwitch},
+    /* 0x46 */  {"ldind.i1", OT::InlineNone},
+    /* 0x47 */  {"ldind.u1", OT::InlineNone},
+    /* 0x48 */  {"ldind.i2", OT::InlineNone},
+    /* 0x49 */  {"ldind.u2", OT::InlineNone},
+    /* 0x4A */  {"ldind.i4", OT::InlineNone},
+    /* 0x4B */  {"ldind.u4", OT::InlineNone},
+    /* 0x4C */  {"ldind.i8", OT::InlineNone},
+    /* 0x4D */  {"ldind.i", OT::InlineNone},
+    /* 0x4E */  {"ldind.r4", OT::InlineNone},
+    /* 0x4F */  {"ldind.r8", OT::InlineNone},
+    /* 0x50 */  {"ldind.ref", OT::InlineNone},
+    /* 0x51 */  {"stind.ref", OT::InlineNone},
+    /* 0x52 */  {"stind.i1", OT::InlineNone},
+    /* 0x53 */  {"stind.i2", OT::InlineNone},
+    /* 0x54 */  {"stind.i4", OT::InlineNone},
+    /* 0x55 */  {"stind.i8", OT::InlineNone},
+    /* 0x56 */  {"stind.r4", OT::InlineNone},
+    /* 0x57 */  {"stind.r8", OT::InlineNone},
+    /* 0x58 */  {"add", OT::InlineNone},
+    /* 0x59 */  {"sub", OT::InlineNone},
+    /* 0x5A */  {"mul", OT::InlineNone},
+    /* 0x5B */  {"div", OT::InlineNone},
+    /* 0x5C */  {"div.un", OT::InlineNone},
+    /* 0x5D */  {"rem", OT::InlineNone},
+    /* 0x5E */  {"rem.un", OT::InlineNone},
+    /* 0x5F */  {"and", OT::InlineNone},
+    /* 0x60 */  {"or", OT::InlineNone},
+    /* 0x61 */  {"xor", OT::InlineNone},
+    /* 0x62 */  {"shl", OT::InlineNone},
+    /* 0x63 */  {"shr", OT::InlineNone},
+    /* 0x64 */  {"shr.un", OT::InlineNone},
+    /* 0x65 */  {"neg", OT::InlineNone},
+    /* 0x66 */  {"not", OT::InlineNone},
+    /* 0x67 */  {"conv.i1", OT::InlineNone},
+    /* 0x68 */  {"conv.i2", OT::InlineNone},
+    /* 0x69 */  {"conv.i4", OT::InlineNone},
+    /* 0x6A */  {"conv.i8", OT::InlineNone},
+    /* 0x6B */  {"conv.r4", OT::InlineNone},
+    /* 0x6C */  {"conv.r8", OT::InlineNone},
+    /* 0x6D */  {"conv.u4", OT::InlineNone},
+    /* 0x6E */  {"conv.u8", OT::InlineNone},
+    /* 0x6F */  {"callvirt", OT::InlineMethod},
+    /* 0x70 */  {"cpobj", OT::InlineType},
+    /* 0x71 */  {"ldobj", OT::InlineType},
+    /* 0x72 */  {"ldstr", OT::InlineString},
+    /* 0x73 */  {"newobj", OT::InlineMethod},
+    /* 0x74 */  {"castclass", OT::InlineType},
+    /* 0x75 */  {"isinst", OT::InlineType},
+    /* 0x76 */  {"conv.r.un", OT::InlineNone},
+    /* 0x77 */  {nullptr, OT::InlineNone},
+    /* 0x78 */  {nullptr, OT::InlineNone},
+    /* 0x79 */  {"unbox", OT::InlineType},
+    /* 0x7A */  {"throw", OT::InlineNone},
+    /* 0x7B */  {"ldfld", OT::InlineField},
+    /* 0x7C */  {"ldflda", OT::InlineField},
+    /* 0x7D */  {"stfld", OT::InlineField},
+    /* 0x7E */  {"ldsfld", OT::InlineField},
+    /* 0x7F */  {"ldsflda", OT::InlineField},
+    /* 0x80 */  {"stsfld", OT::InlineField},
+    /* 0x81 */  {"stobj", OT::InlineType},
+    /* 0x82 */  {"conv.ovf.i1.un", OT::InlineNone},
+    /* 0x83 */  {"conv.ovf.i2.un", OT::InlineNone},
+    /* 0x84 */  {"conv.ovf.i4.un", OT::InlineNone},
+    /* 0x85 */  {"conv.ovf.i8.un", OT::InlineNone},
+    /* 0x86 */  {"conv.ovf.u1.un", OT::InlineNone},
+    /* 0x87 */  {"conv.ovf.u2.un", OT::InlineNone},
+    /* 0x88 */  {"conv.ovf.u4.un", OT::InlineNone},
+    /* 0x89 */  {"conv.ovf.u8.un", OT::InlineNone},
+    /* 0x8A */  {"conv.ovf.i.un", OT::InlineNone},
+    /* 0x8B */  {"conv.ovf.u.un", OT::InlineNone},
+    /* 0x8C */  {"box", OT::InlineType},
+    /* 0x8D */  {"newarr", OT::InlineType},
+    /* 0x8E */  {"ldlen", OT::InlineNone},
+    /* 0x8F */  {"ldelema", OT::InlineType},
+    /* 0x90 */  {"ldelem.i1", OT::InlineNone},
+    /* 0x91 */  {"ldelem.u1", OT::InlineNone},
+    /* 0x92 */  {"ldelem.i2", OT::InlineNone},
+    /* 0x93 */  {"ldelem.u2", OT::InlineNone},
+    /* 0x94 */  {"ldelem.i4", OT::InlineNone},
+    /* 0x95 */  {"ldelem.u4", OT::InlineNone},
+    /* 0x96 */  {"ldelem.i8", OT::InlineNone},
+    /* 0x97 */  {"ldelem.i", OT::InlineNone},
+    /* 0x98 */  {"ldelem.r4", OT::InlineNone},
+    /* 0x99 */  {"ldelem.r8", OT::InlineNone},
+    /* 0x9A */  {"ldelem.ref", OT::InlineNone},
+    /* 0x9B */  {"stelem.i", OT::InlineNone},
+    /* 0x9C */  {"stelem.i1", OT::InlineNone},
+    /* 0x9D */  {"stelem.i2", OT::InlineNone},
+    /* 0x9E */  {"stelem.i4", OT::InlineNone},
+    /* 0x9F */  {"stelem.i8", OT::InlineNone},
+    /* 0xA0 */  {"stelem.r4", OT::InlineNone},
+    /* 0xA1 */  {"stelem.r8", OT::InlineNone},
+    /* 0xA2 */  {"stelem.ref", OT::InlineNone},
+    /* 0xA3 */  {"ldelem", OT::InlineType},
+    /* 0xA4 */  {"stelem", OT::InlineType},
+    /* 0xA5 */  {"unbox.any", OT::InlineType},
+    /* 0xA6 */  {nullptr, OT::InlineNone},
+    /* 0xA7 */  {nullptr, OT::InlineNone},
+    /* 0xA8 */  {nullptr, OT::InlineNone},
+    /* 0xA9 */  {nullptr, OT::InlineNone},
+    /* 0xAA */  {nullptr, OT::InlineNone},
+    /* 0xAB */  {nullptr, OT::InlineNone},
+    /* 0xAC */  {nullptr, OT::InlineNone},
+    /* 0xAD */  {nullptr, OT::InlineNone},
+    /* 0xAE */  {nullptr, OT::InlineNone},
+    /* 0xAF */  {nullptr, OT::InlineNone},
+    /* 0xB0 */  {nullptr, OT::InlineNone},
+    /* 0xB1 */  {nullptr, OT::InlineNone},
+    /* 0xB2 */  {nullptr, OT::InlineNone},
+    /* 0xB3 */  {"conv.ovf.i1", OT::InlineNone},
+    /* 0xB4 */  {"conv.ovf.u1", OT::InlineNone},
+    /* 0xB5 */  {"conv.ovf.i2", OT::InlineNone},
+    /* 0xB6 */  {"conv.ovf.u2", OT::InlineNone},
+    /* 0xB7 */  {"conv.ovf.i4", OT::InlineNone},
+    /* 0xB8 */  {"conv.ovf.u4", OT::InlineNone},
+    /* 0xB9 */  {"conv.ovf.i8", OT::InlineNone},
+    /* 0xBA */  {"conv.ovf.u8", OT::InlineNone},
+    /* 0xBB */  {nullptr, OT::InlineNone},
+    /* 0xBC */  {nullptr, OT::InlineNone},
+    /* 0xBD */  {nullptr, OT::InlineNone},
+    /* 0xBE */  {nullptr, OT::InlineNone},
+    /* 0xBF */  {nullptr, OT::InlineNone},
+    /* 0xC0 */  {nullptr, OT::InlineNone},
+    /* 0xC1 */  {nullptr, OT::InlineNone},
+    /* 0xC2 */  {"refanyval", OT::InlineType},
+    /* 0xC3 */  {"ckfinite", OT::InlineNone},
+    /* 0xC4 */  {nullptr, OT::InlineNone},
+    /* 0xC5 */  {nullptr, OT::InlineNone},
+    /* 0xC6 */  {"mkrefany", OT::InlineType},
+    /* 0xC7 */  {nullptr, OT::InlineNone},
+    /* 0xC8 */  {nullptr, OT::InlineNone},
+    /* 0xC9 */  {nullptr, OT::InlineNone},
+    /* 0xCA */  {nullptr, OT::InlineNone},
+    /* 0xCB */  {nullptr, OT::InlineNone},
+    /* 0xCC */  {nullptr, OT::InlineNone},
+    /* 0xCD */  {nullptr, OT::InlineNone},
+    /* 0xCE */  {nullptr, OT::InlineNone},
+    /* 0xCF */  {nullptr, OT::InlineNone},
+    /* 0xD0 */  {"ldtoken", OT::InlineTok},
+    /* 0xD1 */  {"conv.u2", OT::InlineNone},
+    /* 0xD2 */  {"conv.u1", OT::InlineNone},
+    /* 0xD3 */  {"conv.i", OT::InlineNone},
+    /* 0xD4 */  {"conv.ovf.i", OT::InlineNone},
+    /* 0xD5 */  {"conv.ovf.u", OT::InlineNone},
+    /* 0xD6 */  {"add.ovf", OT::InlineNone},
+    /* 0xD7 */  {"add.ovf.un", OT::InlineNone},
+    /* 0xD8 */  {"mul.ovf", OT::InlineNone},
+    /* 0xD9 */  {"mul.ovf.un", OT::InlineNone},
+    /* 0xDA */  {"sub.ovf", OT::InlineNone},
+    /* 0xDB */  {"sub.ovf.un", OT::InlineNone},
+    /* 0xDC */  {"endfinally", OT::InlineNone},
+    /* 0xDD */  {"leave", OT::InlineBrTarget},
+    /* 0xDE */  {"leave.s", OT::ShortInlineBrTarget},
+    /* 0xDF */  {"stind.i", OT::InlineNone},
+    /* 0xE0 */  {"conv.u", OT::InlineNone}
+};
+
+// Two-byte opcodes, indexed by the second byte. The first byte is 0xFE.
+constexpr OpcodeDefinition two_byte_opcodes[] =
+{
+    /* 0x00 */  {"arglist", OT::InlineNone},
+    /* 0x01 */  {"ceq", OT::InlineNone},
+    /* 0x02 */  {"cgt", OT::InlineNone},
+    /* 0x03 */  {"cgt.un", OT::InlineNone},
+    /* 0x04 */  {"clt", OT::InlineNone},
+    /* 0x05 */  {"clt.un", OT::InlineNone},
+    /* 0x06 */  {"ldftn", OT::InlineMethod},
+    /* 0x07 */  {"ldvirtftn", OT::InlineMethod},
+    /* 0x08 */  {nullptr, OT::InlineNone},
+    /* 0x09 */  {"ldarg", OT::InlineVar},
+    /* 0x0A */  {"ldarga", OT::InlineVar},
+    /* 0x0B */  {"starg", OT::InlineVar},
+    /* 0x0C */  {"ldloc", OT::InlineVar},
+    /* 0x0D */  {"ldloca", OT::InlineVar},
+    /* 0x0E */  {"stloc", OT::InlineVar},
+    /* 0x0F */  {"localloc", OT::InlineNone},
+    /* 0x10 */  {nullptr, OT::InlineNone},
+    /* 0x11 */  {"endfilter", OT::InlineNone},
+    /* 0x12 */  {"unaligned.", OT::ShortInlineI},
+    /* 0x13 */  {"volatile.", OT::InlineNone},
+    /* 0x14 */  {"tail.", OT::InlineNone},
+    /* 0x15 */  {"initobj", OT::InlineType},
+    /* 0x16 */  {"constrained.", OT::InlineType},
+    /* 0x17 */  {"cpblk", OT::InlineNone},
+    /* 0x18 */  {"initblk", OT::InlineNone},
+    /* 0x19 */  {"no.", OT::ShortInlineI},
+    /* 0x1A */  {"rethrow", OT::InlineNone},
+    /* 0x1B */  {nullptr, OT::InlineNone},
+    /* 0x1C */  {"sizeof", OT::InlineType},
+    /* 0x1D */  {"refanytype", OT::InlineNone},
+    /* 0x1E */  {"readonly.", OT::InlineNone}
+};
+
+constexpr uint8_t two_byte_prefix{0xFE};
+
+constexpr size_t one_byte_opcode_count{sizeof(one_byte_opcodes) / sizeof(one_byte_opcodes[0])};
+constexpr size_t two_byte_opcode_count{sizeof(two_byte_opcodes) / sizeof(two_byte_opcodes[0])};
+
+const OpcodeDefinition *find_opcode(uint16_t opcode) noexcept
+{
+    if (opcode < one_byte_opcode_count)
+        return &one_byte_opcodes[opcode];
+
+    if ((opcode >> 8) == two_byte_prefix && (opcode & 0xFF) < two_byte_opcode_count)
+        return &two_byte_opcodes[opcode & 0xFF];
+
+    return nullptr;
+}
+
+// The size of an operand, other than that of a switch, which varies.
+uint32_t operand_size(PeCliOperandType type) noexcept
+{
+    switch (type)
+    {
+        case OT::InlineNone:
+            return 0;
+        case OT::ShortInlineVar:
+        case OT::ShortInlineI:
+        case OT::ShortInlineBrTarget:
+            return 1;
+        case OT::InlineVar:
+            return 2;
+        case OT::InlineR:
+        case OT::InlineI8:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+uint64_t read_le(const uint8_t *ptr, size_t size) noexcept
+{
+    uint64_t    rv{0};
+
+    for (size_t i = size; i-- > 0; )
+        rv = rv << 8 | ptr[i];
+
+    return rv;
+}
+
+// Method body header and data section flags. ECMA-335, sections II.25.4.4 and II.25.4.5.
+constexpr uint8_t   section_eh_table{0x01};
+constexpr uint8_t   section_fat_format{0x40};
+constexpr uint8_t   section_more_sects{0x80};
+
+constexpr uint32_t  tiny_header_size{1};
+constexpr uint32_t  fat_header_size_dwords{3};
+constexpr uint32_t  small_clause_size{12};
+constexpr uint32_t  fat_clause_size{24};
+
+uint32_t align4(uint32_t value) noexcept
+{
+    return (value + 3) & ~3u;
+}
+
+// A data section following the code of a method.
+struct DataSection
+{
+    uint32_t    offset;         // offset of the section header from the start of the body
+    uint32_t    size;           // including the header
+    uint8_t     kind;
+};
+
+DataSection read_data_section(BytesView body, uint32_t offset)
+{
+    if (offset + 4 > body.size())
+        throw std::runtime_error("Method body data section extends beyond the end of the section");
+
+    DataSection rv{offset, 0, body[offset]};
+
+    if (rv.kind & section_fat_format)
+        rv.size = static_cast<uint32_t>(read_le(body.data() + offset + 1, 3));
+    else
+        rv.size = body[offset + 1];
+
+    if (rv.size < 4 || rv.size > body.size() - offset)
+        throw std::runtime_error("Method body data section extends beyond the end of the section");
+
+    return rv;
+}
+
+uint32_t clause_count(const DataSection &section) noexcept
+{
+    if ((section.kind & section_eh_table) == 0)
+        return 0;
+
+    return (section.size - 4) / ((section.kind & section_fat_format) ? fat_clause_size : small_clause_size);
+}
+
+}   // anonymous namespace
+
+
+const char *PeCliInstruction::name() const noexcept
+{
+    const auto *definition{find_opcode(opcode)};
+
+    return definition && definition->name ? definition->name : "";
+}
+
+int64_t PeCliInstruction::integer() const noexcept
+{
+    switch (operand_type)
+    {
+        case OT::InlineNone:
+        case OT::ShortInlineR:
+        case OT::InlineR:
+            return 0;
+        case OT::ShortInlineVar:
+            return operand[0];
+        case OT::ShortInlineI:
+        case OT::ShortInlineBrTarget:
+            return static_cast<int8_t>(operand[0]);
+        case OT::InlineVar:
+            return static_cast<uint16_t>(read_le(operand.data(), 2));
+        case OT::InlineI:
+        case OT::InlineBrTarget:
+            return static_cast<int32_t>(read_le(operand.data(), 4));
+        case OT::InlineI8:
+            return static_cast<int64_t>(read_le(operand.data(), 8));
+        default:    // tokens and the switch count
+            return static_cast<uint32_t>(read_le(operand.data(), 4));
+    }
+}
+
+double PeCliInstruction::real() const noexcept
+{
+    if (operand_type == OT::ShortInlineR)
+    {
+        const auto  bits{static_cast<uint32_t>(read_le(operand.data(), 4))};
+        float       rv;
+
+        std::memcpy(&rv, &bits, sizeof(rv));
+        return rv;
+    }
+
+    if (operand_type == OT::InlineR)
+    {
+        const auto  bits{read_le(operand.data(), 8)};
+        double      rv;
+
+        std::memcpy(&rv, &bits, sizeof(rv));
+        return rv;
+    }
+
+    return static_cast<double>(integer());
+}
+
+uint32_t PeCliInstruction::switch_count() const noexcept
+{
+    return operand_type == OT::InlineSwitch ? static_cast<uint32_t>(read_le(operand.data(), 4)) : 0;
+}
+
+uint32_t PeCliInstruction::switch_target(uint32_t index) const noexcept
+{
+    const auto  displacement{static_cast<int32_t>(read_le(operand.data() + 4 + static_cast<size_t>(index) * 4, 4))};
+
+    return static_cast<uint32_t>(offset + size + displacement);
+}
+
+void PeCliInstructions::const_iterator::decode(uint32_t offset)
+{
+    _instruction = PeCliInstruction{};
+    _instruction.offset = offset;
+
+    if (offset >= _code.size())
+    {
+        _instruction.offset = static_cast<uint32_t>(_code.size());
+        return;
+    }
+
+    const auto  remaining{_code.size() - offset};
+    uint16_t    opcode{_code[offset]};
+    uint32_t    opcode_size{1};
+
+    if (opcode == two_byte_prefix)
+    {
+        if (remaining < 2)
+            throw std::runtime_error("IL instruction extends beyond the end of the code");
+        opcode = static_cast<uint16_t>(opcode << 8 | _code[offset + 1]);
+        opcode_size = 2;
+    }
+
+    const auto *definition{find_opcode(opcode)};
+
+    if (definition == nullptr || definition->name == nullptr)
+        throw std::runtime_error("Undefined IL opcode");
+
+    uint64_t    size{opcode_size + operand_size(definition->operand_type)};
+
+    if (size <= remaining && definition->operand_type == OT::InlineSwitch)
+        size += read_le(_code.data() + offset + opcode_size, 4) * 4;
+    if (size > remaining)
+        throw std::runtime_error("IL instruction extends beyond the end of the code");
+
+    _instruction.size = static_cast<uint32_t>(size);
+    _instruction.opcode = opcode;
+    _instruction.operand_type = definition->operand_type;
+    _instruction.operand = _code.subview(offset + opcode_size, static_cast<size_t>(size - opcode_size));
+}
+
+PeCliMethodBody::PeCliMethodBody(BytesView bytes)
+{
+    if (bytes.empty())
+        throw std::runtime_error("Method body extends beyond the end of the section");
+
+    uint32_t    code_size;
+
+    if ((bytes[0] & static_cast<uint8_t>(PeCliMethodBodyFlags::FormatMask)) == static_cast<uint8_t>(PeCliMethodBodyFlags::TinyFormat))
+    {
+        _flags = static_cast<uint16_t>(PeCliMethodBodyFlags::TinyFormat);
+        _header_size = tiny_header_size;
+        _max_stack = 8;
+        code_size = bytes[0] >> 2;
+    }
+    else if ((bytes[0] & static_cast<uint8_t>(PeCliMethodBodyFlags::FormatMask)) == static_cast<uint8_t>(PeCliMethodBodyFlags::FatFormat))
+    {
+        if (bytes.size() < fat_header_size_dwords * 4)
+            throw std::runtime_error("Method body extends beyond the end of the section");
+
+        const auto  flags_and_size{static_cast<uint16_t>(read_le(bytes.data(), 2))};
+
+        if ((flags_and_size >> 12) < fat_header_size_dwords)
+            throw std::runtime_error("Invalid method body header size");
+
+        _flags = flags_and_size & 0x0FFF;
+        _header_size = (flags_and_size >> 12) * 4u;
+        _max_stack = static_cast<uint16_t>(read_le(bytes.data() + 2, 2));
+        code_size = static_cast<uint32_t>(read_le(bytes.data() + 4, 4));
+        _local_var_sig_token = static_cast<uint32_t>(read_le(bytes.data() + 8, 4));
+    }
+    else
+    {
+        throw std::runtime_error("Invalid method body header format");
+    }
+
+    if (static_cast<uint64_t>(_header_size) + code_size > bytes.size())
+        throw std::runtime_error("Method body extends beyond the end of the section");
+
+    _code = bytes.subview(_header_size, code_size);
+    _size = _header_size + code_size;
+
+    // Data sections follow the code, each aligned on a four-byte boundary.
+    if (is_fat() && (_flags & static_cast<uint16_t>(PeCliMethodBodyFlags::MoreSects)))
+    {
+        _sections_offset = align4(_size);
+
+        DataSection section{0, 0, section_more_sects};
+
+        for (auto offset = _sections_offset; section.kind & section_more_sects; offset = align4(offset + section.size))
+        {
+            section = read_data_section(bytes, offset);
+            _clause_count += clause_count(section);
+            _size = offset + section.size;
+        }
+    }
+
+    _bytes = bytes.subview(0, _size);
+}
+
+PeCliExceptionClause PeCliMethodBody::exception_clause(uint32_t index) const
+{
+    if (index >= _clause_count)
+        throw std::out_of_range("Exception clause index out of range");
+
+    DataSection section{0, 0, section_more_sects};
+
+    for (auto offset = _sections_offset; ; offset = align4(offset + section.size))
+    {
+        section = read_data_section(_bytes, offset);
+
+        const auto  count{clause_count(section)};
+
+        if (index < count)
+            break;
+        index -= count;
+    }
+
+    PeCliExceptionClause    rv{};
+
+    if (section.kind & section_fat_format)
+    {
+        const auto *ptr{_bytes.data() + section.offset + 4 + static_cast<size_t>(index) * fat_clause_size};
+
+        rv.flags = static_cast<uint32_t>(read_le(ptr, 4));
+        rv.try_offset = static_cast<uint32_t>(read_le(ptr + 4, 4));
+        rv.try_length = static_cast<uint32_t>(read_le(ptr + 8, 4));
+        rv.handler_offset = static_cast<uint32_t>(read_le(ptr + 12, 4));
+        rv.handler_length = static_cast<uint32_t>(read_le(ptr + 16, 4));
+        rv.class_token_or_filter_offset = static_cast<uint32_t>(read_le(ptr + 20, 4));
+    }
+    else
+    {
+        const auto *ptr{_bytes.data() + section.offset + 4 + static_cast<size_t>(index) * small_clause_size};
+
+        rv.flags = static_cast<uint32_t>(read_le(ptr, 2));
+        rv.try_offset = static_cast<uint32_t>(read_le(ptr + 2, 2));
+        rv.try_length = ptr[4];
+        rv.handler_offset = static_cast<uint32_t>(read_le(ptr + 5, 2));
+        rv.handler_length = ptr[7];
+        rv.class_token_or_filter_offset = static_cast<uint32_t>(read_le(ptr + 8, 4));
+    }
+
+    return rv;
+}
+
+PeCliMethodBody get_method_body(uint32_t rva, const std::vector<PeSection> &sections)
+{
+    if (rva == 0)
+        throw std::runtime_error("Method has no body");
+
+    const auto *section{find_section_by_rva(rva, sections)};
+
+    if (section == nullptr || !section->data_loaded() || rva - section->virtual_address() >= section->data().size())
+        throw std::runtime_error("Method body is not within a loaded section");
+
+    return PeCliMethodBody{BytesView{section->data()}.subview(rva - section->virtual_address())};
+}
@@ -0,0 +1,302 @@
+/// \file   CliMethodBody.h
+/// Provides readers for the bodies of CLI methods: the method header, the
+/// exception handling clauses, and the IL instructions, as described in
+/// ECMA-335, sections II.25.4 and III.1.
+///
+/// The readers work in place over the raw data of the section containing a
+/// method body, which must have been loaded with LoadOptions::LoadSectionData.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIMETHODBODY_H_
+#define _EXELIB_CLIMETHODBODY_H_
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Flags in the header of a method body. ECMA-335, section II.25.4.4.
+enum class PeCliMethodBodyFlags : uint16_t
+{
+    TinyFormat  = 0x0002,   ///< The method has a tiny header
+    FatFormat   = 0x0003,   ///< The method has a fat header
+    FormatMask  = 0x0003,   ///< Mask of the bits holding the header format
+    MoreSects   = 0x0008,   ///< Data sections follow the code
+    InitLocals  = 0x0010    ///< Local variables are initialized to zero
+};
+
+/// \brief  Kinds of exception handling clause. ECMA-335, section II.25.4.6.
+enum class PeCliExceptionClauseKind : uint32_t
+{
+    Exception   = 0x0000,   ///< A typed exception clause
+    Filter      = 0x0001,   ///< An exception filter and handler clause
+    Finally     = 0x0002,   ///< A finally clause
+    Fault       = 0x0004    ///< A fault clause
+};
+
+/// \brief  An exception handling clause. Offsets are relative to the start of the code.
+struct PeCliExceptionClause
+{
+    uint32_t    flags;              ///< One of the PeCliExceptionClauseKind values
+    uint32_t    try_offset;
+    uint32_t    try_length;
+    uint32_t    handler_offset;
+    uint32_t    handler_length;
+    uint32_t    class_token_or_filter_offset;   ///< The exception type token for an Exception clause,
+                                                ///< or the offset of the filter code for a Filter clause.
+};
+
+/// \brief  Kinds of operand following an IL opcode. ECMA-335, section VI.C.2.
+enum class PeCliOperandType : uint8_t
+{
+    InlineNone,             ///< No operand
+    ShortInlineVar,         ///< 8-bit local variable or argument number
+    ShortInlineI,           ///< 8-bit signed integer
+    ShortInlineBrTarget,    ///< 8-bit signed branch displacement
+    InlineVar,              ///< 16-bit local variable or argument number
+    InlineI,                ///< 32-bit signed integer
+    InlineBrTarget,         ///< 32-bit signed branch displacement
+    InlineField,            ///< Field token
+    InlineMethod,           ///< Method token
+    InlineType,             ///< Type token
+    InlineString,           ///< User string token
+    InlineSig,              ///< StandAloneSig token
+    InlineTok,              ///< Field, method or type token
+    ShortInlineR,           ///< 32-bit floating point number
+    InlineR,                ///< 64-bit floating point number
+    InlineI8,               ///< 64-bit signed integer
+    InlineSwitch            ///< 32-bit count followed by that many 32-bit signed branch displacements
+};
+
+/// \brief  A decoded IL instruction. The operand refers to the method's code bytes.
+struct PeCliInstruction
+{
+    uint32_t            offset;         ///< Offset of the instruction from the start of the code
+    uint32_t            size;           ///< Size of the instruction, including the opcode
+    uint16_t            opcode;         ///< The opcode; two-byte opcodes have 0xFE in the high byte
+    PeCliOperandType    operand_type;   ///< The kind of operand
+    BytesView           operand;        ///< The undecoded operand bytes
+
+    /// \brief  Return the mnemonic of the opcode, such as "ldarg.0".
+    const char *name() const noexcept;
+
+    /// \brief  Return the operand as a signed integer. This is meaningful for
+    ///         the integer, variable number, and branch displacement operands.
+    int64_t integer() const noexcept;
+
+    /// \brief  Return the operand as a floating point number.
+    double real() const noexcept;
+
+    /// \brief  Return the metadata token of an InlineField, InlineMethod,
+    ///         InlineType, InlineString, InlineSig, or InlineTok operand.
+    uint32_t token() const noexcept
+    {
+        return static_cast<uint32_t>(integer());
+    }
+
+    /// \brief  Return the offset of the target of a branch instruction.
+    uint32_t branch_target() const noexcept
+    {
+        return static_cast<uint32_t>(offset + size + integer());
+    }
+
+    /// \brief  Return the number of targets of a switch instruction.
+    uint32_t switch_count() const noexcept;
+
+    /// \brief  Return the offset of one target of a switch instruction.
+    ///         No bounds checking is performed.
+    uint32_t switch_target(uint32_t index) const noexcept;
+};
+
+/// \brief  Decodes the IL instructions in a method's code, one at a time,
+///         directly from the code bytes.
+///
+/// Iteration throws a \c std::runtime_error exception if the code contains
+/// an undefined opcode or an instruction extends past the end of the code.
+class PeCliInstructions
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = PeCliInstruction;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const PeCliInstruction *;
+        using reference = const PeCliInstruction &;
+
+        const_iterator(BytesView code, uint32_t offset)
+          : _code{code}
+        {
+            decode(offset);
+        }
+
+        const PeCliInstruction &operator*() const noexcept
+        {
+            return _instruction;
+        }
+
+        const PeCliInstruction *operator->() const noexcept
+        {
+            return &_instruction;
+        }
+
+        const_iterator &operator++()
+        {
+            decode(_instruction.offset + _instruction.size);
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto    rv{*this};
+
+            ++*this;
+            return rv;
+        }
+
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return _instruction.offset == other._instruction.offset && _code.data() == other._code.data();
+        }
+
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        void decode(uint32_t offset);
+
+        BytesView           _code;
+        PeCliInstruction    _instruction{};
+    };
+
+    /// \brief  Construct an object to decode the instructions in \p code.
+    explicit PeCliInstructions(BytesView code) noexcept
+      : _code{code}
+    {}
+
+    const_iterator begin() const
+    {
+        return {_code, 0};
+    }
+
+    const_iterator end() const
+    {
+        return {_code, static_cast<uint32_t>(_code.size())};
+    }
+
+private:
+    BytesView   _code;
+};
+
+/// \brief  A method body: its header, code, and exception handling clauses.
+///
+/// The body refers to the section data it was read from and is valid only
+/// as long as that data.
+class PeCliMethodBody
+{
+public:
+    /// \brief  Parse the method body beginning at the start of \p bytes.
+    /// \param bytes    The section data from the start of the body to,
+    ///                 at most, the end of the section.
+    ///
+    /// A \c std::runtime_error exception is thrown if the header is not
+    /// valid or the body extends past the end of \p bytes.
+    explicit PeCliMethodBody(BytesView bytes);
+
+    /// \brief  Return \c true if the body has a fat header.
+    bool is_fat() const noexcept
+    {
+        return (_flags & static_cast<uint16_t>(PeCliMethodBodyFlags::FormatMask))
+                == static_cast<uint16_t>(PeCliMethodBodyFlags::FatFormat);
+    }
+
+    /// \brief  Return the header flags. A tiny header has only the format flags.
+    uint16_t flags() const noexcept
+    {
+        return _flags;
+    }
+
+    /// \brief  Return \c true if local variables are to be initialized to zero.
+    bool init_locals() const noexcept
+    {
+        return (_flags & static_cast<uint16_t>(PeCliMethodBodyFlags::InitLocals)) != 0;
+    }
+
+    /// \brief  Return the size of the header, in bytes.
+    uint32_t header_size() const noexcept
+    {
+        return _header_size;
+    }
+
+    /// \brief  Return the maximum number of items on the evaluation stack.
+    uint16_t max_stack() const noexcept
+    {
+        return _max_stack;
+    }
+
+    /// \brief  Return the StandAloneSig token of the local variable signature,
+    ///         or zero if the method has no local variables.
+    uint32_t local_var_sig_token() const noexcept
+    {
+        return _local_var_sig_token;
+    }
+
+    /// \brief  Return the IL code.
+    BytesView code() const noexcept
+    {
+        return _code;
+    }
+
+    /// \brief  Return an object that decodes the IL instructions of the code.
+    PeCliInstructions instructions() const noexcept
+    {
+        return PeCliInstructions{_code};
+    }
+
+    /// \brief  Return the total size of the body, including the header and any data sections.
+    uint32_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /// \brief  Return the number of exception handling clauses.
+    uint32_t exception_clause_count() const noexcept
+    {
+        return _clause_count;
+    }
+
+    /// \brief  Decode an exception handling clause.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p index is not less than exception_clause_count().
+    PeCliExceptionClause exception_clause(uint32_t index) const;
+
+private:
+    BytesView   _bytes;         // the whole body
+    BytesView   _code;
+    uint32_t    _local_var_sig_token{0};
+    uint32_t    _header_size{0};
+    uint32_t    _sections_offset{0};    // offset of the first data section, if any
+    uint32_t    _size{0};
+    uint32_t    _clause_count{0};
+    uint16_t    _flags{0};
+    uint16_t    _max_stack{0};
+};
+
+/// \brief  Locate and parse the body of a method.
+/// \param rva      The RVA of the method body, from the rva member of a MethodDef row.
+/// \param sections The sections of the executable, whose data must have been loaded.
+///
+/// A \c std::runtime_error exception is thrown if \p rva is zero, which is
+/// the case for abstract and runtime-implemented methods, if no section with
+/// loaded data contains \p rva, or if the body is malformed.
+PeCliMethodBody get_method_body(uint32_t rva, const std::vector<PeSection> &sections);
+
+#endif  //_EXELIB_CLIMETHODBODY_H_
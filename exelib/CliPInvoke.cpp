@@ -0,0 +1,43 @@
+/// \file   CliPInvoke.cpp
+/// Implementation of the platform invoke inventory.
+///
+/// \author Jeff Bienstadt
+///
+
+#include "CliPInvoke.h"
+
+
+std::vector<PeCliPInvokeImport> get_pinvoke_imports(const PeCliMetadata &metadata)
+{
+    std::vector<PeCliPInvokeImport> rv;
+    const auto                     *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr)
+        return rv;
+
+    const auto  impl_maps{tables->table<PeCliMetadataRowImplMap>()};
+    const auto  module_refs{tables->table<PeCliMetadataRowModuleRef>()};
+
+    // Imports from the same module tend to be adjacent, so the name of the
+    // last module is kept rather than looked up again.
+    uint32_t    last_scope{0};
+    StringView  last_module;
+
+    rv.reserve(impl_maps.size());
+    for (const auto &row : impl_maps)
+    {
+        if (row.import_scope != last_scope)
+        {
+            last_scope = row.import_scope;
+            last_module = row.import_scope != 0 && row.import_scope <= module_refs.size()
+                        ? metadata.get_string_view(module_refs.row(row.import_scope - 1).name)
+                        : StringView{};
+        }
+
+        const auto  member{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::MemberForwarded, row.member_forwarded)};
+
+        rv.push_back({last_module, metadata.get_string_view(row.import_name), member.token(), row.mapping_flags});
+    }
+
+    return rv;
+}
@@ -0,0 +1,71 @@
+/// \file   CliPInvoke.h
+/// Provides an inventory of the native functions an assembly calls through
+/// platform invoke.
+///
+/// Each method or field imported from a native module has a row in the
+/// ImplMap table, ECMA-335, section II.22.22, naming the entry point and
+/// referring to the ModuleRef row that names the module.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIPINVOKE_H_
+#define _EXELIB_CLIPINVOKE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Flags of an ImplMap row. ECMA-335, section II.23.1.8.
+enum class PeCliPInvokeAttributes : uint16_t
+{
+    NoMangle                        = 0x0001,   ///< The entry point name is used exactly as given
+    CharSetMask                     = 0x0006,
+    CharSetNotSpec                  = 0x0000,
+    CharSetAnsi                     = 0x0002,
+    CharSetUnicode                  = 0x0004,
+    CharSetAuto                     = 0x0006,
+    BestFitUseAssem                 = 0x0000,
+    BestFitEnabled                  = 0x0010,
+    BestFitDisabled                 = 0x0020,
+    BestFitMask                     = 0x0030,
+    SupportsLastError               = 0x0040,   ///< The last error is saved after the call
+    CallConvMask                    = 0x0700,
+    CallConvPlatformApi             = 0x0100,
+    CallConvCdecl                   = 0x0200,
+    CallConvStdcall                 = 0x0300,
+    CallConvThiscall                = 0x0400,
+    CallConvFastcall                = 0x0500,
+    ThrowOnUnmappableCharEnabled    = 0x1000,
+    ThrowOnUnmappableCharDisabled   = 0x2000,
+    ThrowOnUnmappableCharMask       = 0x3000
+};
+
+/// \brief  A native function imported through platform invoke.
+///
+/// The names are views of the \#Strings heap and are valid only as long as
+/// the PeCliMetadata they came from.
+struct PeCliPInvokeImport
+{
+    StringView  module;         ///< The name of the native module, such as "kernel32.dll" or "libc"
+    StringView  entry_point;    ///< The name of the function within the module
+    uint32_t    member;         ///< The metadata token of the importing MethodDef, or of a Field
+    uint16_t    flags;          ///< The PeCliPInvokeAttributes of the import
+};
+
+/// \brief  Return the native functions imported by an assembly, in ImplMap table order.
+/// \param metadata The metadata of the assembly, with its tables and heaps loaded.
+///
+/// The ImplMap table is read in a single pass, the names are views of the
+/// \#Strings heap rather than copies, and the only allocation is that of
+/// the returned vector. The vector is empty if the assembly has no ImplMap
+/// table or its metadata tables were not loaded. An import whose ModuleRef
+/// is out of range has an empty module name.
+///
+/// A \c std::out_of_range exception is thrown if a name is outside the \#Strings heap.
+std::vector<PeCliPInvokeImport> get_pinvoke_imports(const PeCliMetadata &metadata);
+
+#endif  //_EXELIB_CLIPINVOKE_H_
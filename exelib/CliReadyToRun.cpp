@@ -0,0 +1,344 @@
+/// \file   CliReadyToRun.cpp
+/// Implementation of the PeReadyToRun class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "CliReadyToRun.h"
+
+namespace {
+
+using MachineType = PeImageFileHeader::MachineType;
+
+// ReadyToRun images built for operating systems other than Windows have
+// their machine type exclusive-ored with one of these values.
+constexpr uint16_t  os_machine_overrides[]{0x0000, 0x4644, 0xADC4, 0x7B79, 0x1993, 0x1992};
+
+// The size of a RUNTIME_FUNCTION entry, which records an end address only on x64.
+uint32_t runtime_function_size(uint16_t target_machine) noexcept
+{
+    for (auto os : os_machine_overrides)
+        if (static_cast<MachineType>(target_machine ^ os) == MachineType::AMD64)
+            return 12;
+
+    return 8;
+}
+
+uint32_t read_u32(BytesView data, size_t offset) noexcept
+{
+    const auto *p{data.data() + offset};
+
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Decode an unsigned value in the runtime's native format at offset,
+// leaving offset past it. Returns false if the value is truncated or malformed.
+bool decode_unsigned(BytesView data, uint32_t &offset, uint32_t &value) noexcept
+{
+    if (offset >= data.size())
+        return false;
+
+    const auto      *p{data.data() + offset};
+    const uint32_t  first{p[0]};
+    uint32_t        size;
+
+    if ((first & 0x01) == 0)
+        size = 1;
+    else if ((first & 0x02) == 0)
+        size = 2;
+    else if ((first & 0x04) == 0)
+        size = 3;
+    else if ((first & 0x08) == 0)
+        size = 4;
+    else if ((first & 0x10) == 0)
+        size = 5;
+    else
+        return false;
+
+    if (data.size() - offset < size)
+        return false;
+
+    switch (size)
+    {
+        case 1:
+            value = first >> 1;
+            break;
+        case 2:
+            value = (first >> 2) | (static_cast<uint32_t>(p[1]) << 6);
+            break;
+        case 3:
+            value = (first >> 3) | (static_cast<uint32_t>(p[1]) << 5) | (static_cast<uint32_t>(p[2]) << 13);
+            break;
+        case 4:
+            value = (first >> 4) | (static_cast<uint32_t>(p[1]) << 4) | (static_cast<uint32_t>(p[2]) << 12)
+                  | (static_cast<uint32_t>(p[3]) << 20);
+            break;
+        default:
+            value = read_u32(data, offset + 1);
+            break;
+    }
+
+    offset += size;
+    return true;
+}
+
+// A sparse array in the runtime's native format, as used by the
+// MethodDefEntryPoints section. Elements are found through a binary tree
+// within each block of sixteen.
+class NativeArray
+{
+public:
+    NativeArray(BytesView data) noexcept
+      : _data{data}
+    {
+        uint32_t    header;
+
+        if (decode_unsigned(_data, _base, header))
+        {
+            _count = header >> 2;
+            _entry_index_size = header & 3;
+        }
+    }
+
+    uint32_t size() const noexcept
+    {
+        return _count;
+    }
+
+    // Set offset to that of the element at index, returning false if the element is absent.
+    bool try_get(uint32_t index, uint32_t &offset) const noexcept
+    {
+        if (index >= _count)
+            return false;
+
+        const uint32_t  entry_size{1u << _entry_index_size};
+        const size_t    entry{_base + static_cast<size_t>(index / block_size) * entry_size};
+
+        if (entry_size > _data.size() || entry > _data.size() - entry_size)
+            return false;
+
+        offset = _base;
+        for (uint32_t i = 0; i < entry_size; ++i)
+            offset += static_cast<uint32_t>(_data[entry + i]) << (8 * i);
+
+        for (uint32_t bit = block_size >> 1; bit > 0; bit >>= 1)
+        {
+            uint32_t    value;
+            uint32_t    next{offset};
+
+            if (!decode_unsigned(_data, next, value))
+                return false;
+
+            if (index & bit)
+            {
+                if (value & 2)
+                {
+                    offset += value >> 2;
+                    continue;
+                }
+            }
+            else if (value & 1)
+            {
+                offset = next;
+                continue;
+            }
+
+            // A leaf standing for a single element of the block
+            if ((value & 3) == 0 && (value >> 2) == (index & (block_size - 1)))
+            {
+                offset = next;
+                break;
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr uint32_t   block_size{16};
+
+    BytesView   _data;
+    uint32_t    _base{0};
+    uint32_t    _count{0};
+    uint32_t    _entry_index_size{0};
+};
+
+constexpr uint32_t  NativeArray::block_size;
+
+}   // anonymous namespace
+
+
+constexpr uint32_t  PeReadyToRunHeader::rtr_signature;
+
+PeReadyToRun::PeReadyToRun(const PeExeInfo &pe)
+  : _image_sections{pe.sections()},
+    _runtime_function_size{runtime_function_size(pe.header().target_machine)},
+    _header{}
+{
+    if (pe.cli() == nullptr || pe.cli()->header().managed_native_header.virtual_address == 0)
+        throw std::runtime_error("Image has no managed native header");
+
+    const auto  rva{pe.cli()->header().managed_native_header.virtual_address};
+    const auto  header{view(rva, 16)};
+
+    if (header.size() < 16)
+        throw std::runtime_error("ReadyToRun header is not within a loaded section");
+
+    _header.signature = read_u32(header, 0);
+    _header.major_version = static_cast<uint16_t>(header[4] | (header[5] << 8));
+    _header.minor_version = static_cast<uint16_t>(header[6] | (header[7] << 8));
+    _header.flags = read_u32(header, 8);
+    _header.section_count = read_u32(header, 12);
+
+    if (_header.signature != PeReadyToRunHeader::rtr_signature)
+        throw std::runtime_error("Managed native header is not a ReadyToRun header");
+
+    const auto  table{view(rva + 16, _header.section_count * 12)};
+
+    if (table.size() / 12 < _header.section_count)
+        throw std::runtime_error("ReadyToRun section table is not within a loaded section");
+
+    _sections.reserve(_header.section_count);
+    for (uint32_t i = 0; i < _header.section_count; ++i)
+        _sections.push_back({read_u32(table, i * 12), {read_u32(table, i * 12 + 4), read_u32(table, i * 12 + 8)}});
+}
+
+bool PeReadyToRun::is_ready_to_run(const PeExeInfo &pe) noexcept
+{
+    if (pe.cli() == nullptr)
+        return false;
+
+    const auto  rva{pe.cli()->header().managed_native_header.virtual_address};
+    const auto *section{find_section_by_rva(rva, pe.sections())};
+
+    if (rva == 0 || section == nullptr || !section->data_loaded())
+        return false;
+
+    const auto  header{BytesView{section->data()}.subview(rva - section->virtual_address(), 4)};
+
+    return header.size() == 4 && read_u32(header, 0) == PeReadyToRunHeader::rtr_signature;
+}
+
+BytesView PeReadyToRun::view(uint32_t rva, uint32_t size) const noexcept
+{
+    const auto *section{find_section_by_rva(rva, _image_sections)};
+
+    if (section == nullptr || !section->data_loaded())
+        return {};
+
+    return BytesView{section->data()}.subview(rva - section->virtual_address(), size);
+}
+
+const PeReadyToRunSection *PeReadyToRun::find_section(PeReadyToRunSectionType type) const noexcept
+{
+    for (const auto &section : _sections)
+        if (section.type == static_cast<uint32_t>(type))
+            return &section;
+
+    return nullptr;
+}
+
+BytesView PeReadyToRun::section_data(PeReadyToRunSectionType type) const noexcept
+{
+    const auto *section{find_section(type)};
+
+    return section ? view(section->location.virtual_address, section->location.size) : BytesView{};
+}
+
+StringView PeReadyToRun::compiler_identifier() const noexcept
+{
+    const auto  data{section_data(PeReadyToRunSectionType::CompilerIdentifier)};
+    size_t      size{0};
+
+    while (size < data.size() && data[size] != 0)
+        ++size;
+
+    return {reinterpret_cast<const char *>(data.data()), size};
+}
+
+void PeReadyToRun::build_index() const
+{
+    const auto  functions{section_data(PeReadyToRunSectionType::RuntimeFunctions)};
+    const auto  function_count{static_cast<uint32_t>(functions.size() / _runtime_function_size)};
+    const auto *entry_points{find_section(PeReadyToRunSectionType::MethodDefEntryPoints)};
+
+    _function_begins.reserve(function_count);
+    for (uint32_t i = 0; i < function_count; ++i)
+        _function_begins.push_back(read_u32(functions, static_cast<size_t>(i) * _runtime_function_size));
+    _function_owners.assign(function_count, 0);
+
+    if (entry_points == nullptr)
+        return;
+
+    // The entries of the array may lie beyond the array itself, so the
+    // view extends to the end of the image section holding it.
+    const auto          data{view(entry_points->location.virtual_address, UINT32_MAX)};
+    const NativeArray   array{data};
+
+    _method_by_row.assign(array.size(), 0);
+    for (uint32_t row = 1; row <= array.size(); ++row)
+    {
+        uint32_t    offset;
+        uint32_t    id;
+
+        if (!array.try_get(row - 1, offset) || !decode_unsigned(data, offset, id))
+            continue;
+
+        // The low bits say whether a list of fixups, which must be resolved
+        // before the method can run, precedes the entry.
+        id = (id & 1) ? id >> 2 : id >> 1;
+        if (id >= function_count)
+            continue;
+
+        const uint32_t  end{_runtime_function_size == 12 ? read_u32(functions, static_cast<size_t>(id) * 12 + 4) : 0};
+
+        _methods.push_back({PeCliMetadataTableIndex{PeCliMetadataTableId::MethodDef, row}.token(), id, _function_begins[id], end});
+        _method_by_row[row - 1] = static_cast<uint32_t>(_methods.size());
+        _function_owners[id] = static_cast<uint32_t>(_methods.size());
+    }
+}
+
+const std::vector<PeReadyToRunMethod> &PeReadyToRun::methods() const
+{
+    std::call_once(_index_once, [this]() { build_index(); });
+
+    return _methods;
+}
+
+uint32_t PeReadyToRun::method_entry_point(uint32_t method_def) const
+{
+    const auto &methods{this->methods()};
+    const auto  index{PeCliMetadataTableIndex::from_token(method_def)};
+
+    if (index.table_id != PeCliMetadataTableId::MethodDef || index.index == 0 || index.index > _method_by_row.size())
+        return 0;
+
+    const auto  position{_method_by_row[index.index - 1]};
+
+    return position ? methods[position - 1].begin_rva : 0;
+}
+
+const PeReadyToRunMethod *PeReadyToRun::find_method(uint32_t rva) const
+{
+    const auto &methods{this->methods()};
+    const auto  it{std::upper_bound(_function_begins.begin(), _function_begins.end(), rva)};
+
+    if (it == _function_begins.begin())
+        return nullptr;
+
+    const auto  function{static_cast<size_t>(it - _function_begins.begin() - 1)};
+    const auto  position{_function_owners[function]};
+
+    if (position == 0)
+        return nullptr;
+
+    const auto &method{methods[position - 1]};
+
+    return method.end_rva == 0 || rva < method.end_rva ? &method : nullptr;
+}
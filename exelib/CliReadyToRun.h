@@ -0,0 +1,176 @@
+/// \file   CliReadyToRun.h
+/// Provides access to the ReadyToRun header of an assembly compiled ahead
+/// of time by crossgen, and lookup of the native code of its methods.
+///
+/// The ReadyToRun format is described in the .NET runtime repository,
+/// docs/design/coreclr/botr/readytorun-format.md.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIREADYTORUN_H_
+#define _EXELIB_CLIREADYTORUN_H_
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  The header addressed by the managed_native_header member of the
+///         CLI header of a ReadyToRun image.
+struct PeReadyToRunHeader
+{
+    uint32_t    signature;      ///< Always PeReadyToRunHeader::rtr_signature
+    uint16_t    major_version;
+    uint16_t    minor_version;
+    uint32_t    flags;          ///< Combination of PeReadyToRunFlags values
+    uint32_t    section_count;
+
+    static constexpr uint32_t   rtr_signature{0x00525452};  ///< "RTR"
+};
+
+/// \brief  Flags in the \c flags member of the PeReadyToRunHeader structure.
+enum class PeReadyToRunFlags : uint32_t
+{
+    PlatformNeutralSource     = 0x00000001,   ///< The image was compiled from a platform-neutral assembly
+    SkipTypeValidation        = 0x00000002,   ///< Type layouts need not be validated at run time
+    Partial                   = 0x00000004,   ///< Only some of the methods were compiled
+    NonSharedPInvokeStubs     = 0x00000008,   ///< P/Invoke stubs were compiled into the image
+    EmbeddedMsil              = 0x00000010,   ///< The IL metadata is embedded in the image
+    Component                 = 0x00000020,   ///< The image is a component of a composite image
+    MultiModuleVersionBubble  = 0x00000040,   ///< The image was compiled together with other assemblies
+    UnrelatedR2RCode          = 0x00000080    ///< The image contains code for methods of other assemblies
+};
+
+/// \brief  Types of section listed in the ReadyToRun header.
+enum class PeReadyToRunSectionType : uint32_t
+{
+    CompilerIdentifier          = 100,
+    ImportSections              = 101,
+    RuntimeFunctions            = 102,
+    MethodDefEntryPoints        = 103,
+    ExceptionInfo               = 104,
+    DebugInfo                   = 105,
+    DelayLoadMethodCallThunks   = 106,
+    AvailableTypes              = 108,
+    InstanceMethodEntryPoints   = 109,
+    InliningInfo                = 110,
+    ProfileDataInfo             = 111,
+    ManifestMetadata            = 112,
+    AttributePresence           = 113,
+    InliningInfo2               = 114,
+    ComponentAssemblies         = 115,
+    OwnerCompositeExecutable    = 116,
+    PgoInstrumentationData      = 117,
+    ManifestAssemblyMvids       = 118,
+    CrossModuleInlineInfo       = 119,
+    HotColdMap                  = 120,
+    MethodIsGenericMap          = 121,
+    EnclosingTypeMap            = 122,
+    TypeGenericInfoMap          = 123
+};
+
+/// \brief  An entry in the section table following the ReadyToRun header.
+struct PeReadyToRunSection
+{
+    uint32_t                type;       ///< The PeReadyToRunSectionType of the section
+    PeDataDirectoryEntry    location;   ///< The RVA and size of the section
+};
+
+/// \brief  The native code of a method, as found in the RuntimeFunctions section.
+struct PeReadyToRunMethod
+{
+    uint32_t    method_def;         ///< The MethodDef token of the method
+    uint32_t    runtime_function;   ///< The index of the method's first entry in the RuntimeFunctions section
+    uint32_t    begin_rva;          ///< The RVA of the method's entry point
+    uint32_t    end_rva;            ///< The RVA just past the method's main body, or zero if the target does not record it
+};
+
+/// \brief  The ReadyToRun information of an image.
+///
+/// The methods of the image are found through the MethodDefEntryPoints
+/// section, which maps each MethodDef row compiled to native code to an
+/// entry in the RuntimeFunctions section. Generic method instantiations,
+/// listed in the InstanceMethodEntryPoints section, are not included.
+///
+/// The indexes used by method_entry_point() and find_method() are built
+/// on first use, which may be done concurrently from several threads.
+/// The object refers to the section data of the PeExeInfo object it was
+/// constructed from and is valid only as long as that object.
+class PeReadyToRun
+{
+public:
+    /// \brief  Read the ReadyToRun header and section table of an image.
+    /// \param pe   The image, loaded with LoadOptions::LoadSectionData.
+    ///
+    /// A \c std::runtime_error exception is thrown if \p pe is not a
+    /// ReadyToRun image or the header is not within loaded section data.
+    explicit PeReadyToRun(const PeExeInfo &pe);
+
+    PeReadyToRun(const PeReadyToRun &) = delete;
+    PeReadyToRun &operator=(const PeReadyToRun &) = delete;
+
+    /// \brief  Return \c true if \p pe has CLI information whose
+    ///         managed_native_header refers to a ReadyToRun header.
+    static bool is_ready_to_run(const PeExeInfo &pe) noexcept;
+
+    const PeReadyToRunHeader &header() const noexcept
+    {
+        return _header;
+    }
+
+    const std::vector<PeReadyToRunSection> &sections() const noexcept
+    {
+        return _sections;
+    }
+
+    /// \brief  Return the section of the given type, or \c nullptr if there is none.
+    const PeReadyToRunSection *find_section(PeReadyToRunSectionType type) const noexcept;
+
+    /// \brief  Return a view of the content of a section, which is empty
+    ///         if the section is absent or not within loaded section data.
+    BytesView section_data(PeReadyToRunSectionType type) const noexcept;
+
+    /// \brief  Return the compiler identifier string, such as "Crossgen2 8.0.20",
+    ///         which is empty if the image does not record it.
+    StringView compiler_identifier() const noexcept;
+
+    /// \brief  Return the methods compiled to native code, in MethodDef order,
+    ///         building the index if necessary.
+    const std::vector<PeReadyToRunMethod> &methods() const;
+
+    /// \brief  Return the RVA of the native entry point of a method, or
+    ///         zero if it has none.
+    /// \param method_def   A MethodDef token.
+    uint32_t method_entry_point(uint32_t method_def) const;
+
+    /// \brief  Return the method whose native code contains \p rva, or
+    ///         \c nullptr if there is none.
+    ///
+    /// Only the main body of a method is found. Its funclets, such as
+    /// exception handlers, have entries of their own in the RuntimeFunctions
+    /// section that cannot be told apart from those of generic method
+    /// instantiations without decoding the InstanceMethodEntryPoints
+    /// section, so their code is not attributed to any method.
+    const PeReadyToRunMethod *find_method(uint32_t rva) const;
+
+private:
+    BytesView view(uint32_t rva, uint32_t size) const noexcept;
+    void build_index() const;
+
+    const std::vector<PeSection>           &_image_sections;
+    uint32_t                                _runtime_function_size;
+    PeReadyToRunHeader                      _header;
+    std::vector<PeReadyToRunSection>        _sections;
+
+    mutable std::once_flag                  _index_once;
+    mutable std::vector<PeReadyToRunMethod> _methods;           // in MethodDef order
+    mutable std::vector<uint32_t>           _method_by_row;     // MethodDef row - 1 to position in _methods + 1, or zero
+    mutable std::vector<uint32_t>           _function_begins;   // RVA of each runtime function
+    mutable std::vector<uint32_t>           _function_owners;   // position in _methods + 1 of the method whose main body each runtime function is, or zero
+};
+
+#endif  //_EXELIB_CLIREADYTORUN_H_
@@ -0,0 +1,358 @@
+/// \file   CliRelations.cpp
+/// Implementation of the PeCliMetadataRelations class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "CliRelations.h"
+
+namespace {
+
+// Columns used below, in the order of the members of the row structures.
+constexpr size_t type_def_field_list{4};
+constexpr size_t type_def_method_list{5};
+constexpr size_t method_def_param_list{5};
+constexpr size_t map_parent{0};             // PropertyMap and EventMap
+constexpr size_t map_list{1};               // PropertyMap and EventMap
+constexpr size_t nested_class_nested{0};
+constexpr size_t nested_class_enclosing{1};
+constexpr size_t local_scope_variable_list{2};
+constexpr size_t local_scope_constant_list{3};
+
+constexpr int no_column{-1};
+
+// Return the column on which ECMA-335, section II.22, requires a table to
+// be sorted, when the table's bit is set in the sorted_tables header member.
+int sort_key_column(PeCliMetadataTableId table) noexcept
+{
+    switch (table)
+    {
+        case PeCliMetadataTableId::CustomAttribute:
+        case PeCliMetadataTableId::CustomDebugInformation:
+        case PeCliMetadataTableId::FieldMarshal:
+        case PeCliMetadataTableId::GenericParamConstraint:
+        case PeCliMetadataTableId::InterfaceImpl:
+        case PeCliMetadataTableId::LocalScope:
+        case PeCliMetadataTableId::MethodImpl:
+        case PeCliMetadataTableId::NestedClass:
+        case PeCliMetadataTableId::StateMachineMethod:
+            return 0;
+
+        case PeCliMetadataTableId::DeclSecurity:
+        case PeCliMetadataTableId::FieldLayout:
+        case PeCliMetadataTableId::FieldRVA:
+        case PeCliMetadataTableId::ImplMap:
+            return 1;
+
+        case PeCliMetadataTableId::ClassLayout:
+        case PeCliMetadataTableId::Constant:
+        case PeCliMetadataTableId::GenericParam:
+        case PeCliMetadataTableId::MethodSemantics:
+            return 2;
+
+        default:
+            return no_column;
+    }
+}
+
+// Return the first of the \p count row numbers starting at \p first for
+// which \p pred is false, given that it is true for all rows before that
+// one and false for all rows after. Returns first + count if there is none.
+template<typename Pred>
+uint32_t partition_point(uint32_t first, uint32_t count, Pred pred)
+{
+    while (count > 0)
+    {
+        const uint32_t  half{count / 2};
+
+        if (pred(first + half))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+
+    return first;
+}
+
+uint32_t first_row(const PeCliRowList &rows) noexcept
+{
+    return rows.empty() ? 0 : rows[0];
+}
+
+}   // anonymous namespace
+
+
+PeCliRowList PeCliMetadataRelations::fields(uint32_t type_def) const noexcept
+{
+    return list_range(PeCliMetadataTableId::TypeDef, type_def_field_list, PeCliMetadataTableId::Field, type_def);
+}
+
+PeCliRowList PeCliMetadataRelations::methods(uint32_t type_def) const noexcept
+{
+    return list_range(PeCliMetadataTableId::TypeDef, type_def_method_list, PeCliMetadataTableId::MethodDef, type_def);
+}
+
+PeCliRowList PeCliMetadataRelations::parameters(uint32_t method_def) const noexcept
+{
+    return list_range(PeCliMetadataTableId::MethodDef, method_def_param_list, PeCliMetadataTableId::Param, method_def);
+}
+
+PeCliRowList PeCliMetadataRelations::properties(uint32_t type_def) const
+{
+    const auto  maps{find_rows(PeCliMetadataTableId::PropertyMap, map_parent, type_def)};
+
+    if (maps.empty())
+        return {};
+
+    return list_range(PeCliMetadataTableId::PropertyMap, map_list, PeCliMetadataTableId::Property, maps[0]);
+}
+
+PeCliRowList PeCliMetadataRelations::events(uint32_t type_def) const
+{
+    const auto  maps{find_rows(PeCliMetadataTableId::EventMap, map_parent, type_def)};
+
+    if (maps.empty())
+        return {};
+
+    return list_range(PeCliMetadataTableId::EventMap, map_list, PeCliMetadataTableId::Event, maps[0]);
+}
+
+uint32_t PeCliMetadataRelations::field_owner(uint32_t field) const noexcept
+{
+    return list_owner(PeCliMetadataTableId::TypeDef, type_def_field_list, PeCliMetadataTableId::Field, field);
+}
+
+uint32_t PeCliMetadataRelations::method_owner(uint32_t method_def) const noexcept
+{
+    return list_owner(PeCliMetadataTableId::TypeDef, type_def_method_list, PeCliMetadataTableId::MethodDef, method_def);
+}
+
+uint32_t PeCliMetadataRelations::parameter_owner(uint32_t param) const noexcept
+{
+    return list_owner(PeCliMetadataTableId::MethodDef, method_def_param_list, PeCliMetadataTableId::Param, param);
+}
+
+uint32_t PeCliMetadataRelations::property_owner(uint32_t property) const noexcept
+{
+    const auto  map{list_owner(PeCliMetadataTableId::PropertyMap, map_list, PeCliMetadataTableId::Property, property)};
+
+    return map ? column_value(PeCliMetadataTableId::PropertyMap, map, map_parent) : 0;
+}
+
+uint32_t PeCliMetadataRelations::event_owner(uint32_t event) const noexcept
+{
+    const auto  map{list_owner(PeCliMetadataTableId::EventMap, map_list, PeCliMetadataTableId::Event, event)};
+
+    return map ? column_value(PeCliMetadataTableId::EventMap, map, map_parent) : 0;
+}
+
+PeCliRowList PeCliMetadataRelations::nested_classes(uint32_t type_def) const
+{
+    return find_rows(PeCliMetadataTableId::NestedClass, nested_class_enclosing, type_def);
+}
+
+uint32_t PeCliMetadataRelations::enclosing_class(uint32_t type_def) const
+{
+    const auto  rows{find_rows(PeCliMetadataTableId::NestedClass, nested_class_nested, type_def)};
+
+    return rows.empty() ? 0 : column_value(PeCliMetadataTableId::NestedClass, rows[0], nested_class_enclosing);
+}
+
+PeCliRowList PeCliMetadataRelations::interface_impls(uint32_t type_def) const
+{
+    return find_rows(PeCliMetadataTableId::InterfaceImpl, 0, type_def);
+}
+
+PeCliRowList PeCliMetadataRelations::method_impls(uint32_t type_def) const
+{
+    return find_rows(PeCliMetadataTableId::MethodImpl, 0, type_def);
+}
+
+PeCliRowList PeCliMetadataRelations::custom_attributes(PeCliMetadataTableIndex parent) const
+{
+    return find_coded(PeCliMetadataTableId::CustomAttribute, 0, PeCliEncodedIndexType::HasCustomAttribute, parent);
+}
+
+PeCliRowList PeCliMetadataRelations::decl_security(PeCliMetadataTableIndex parent) const
+{
+    return find_coded(PeCliMetadataTableId::DeclSecurity, 1, PeCliEncodedIndexType::HasDeclSecurity, parent);
+}
+
+PeCliRowList PeCliMetadataRelations::generic_params(PeCliMetadataTableIndex owner) const
+{
+    return find_coded(PeCliMetadataTableId::GenericParam, 2, PeCliEncodedIndexType::TypeOrMethodDef, owner);
+}
+
+PeCliRowList PeCliMetadataRelations::generic_param_constraints(uint32_t generic_param) const
+{
+    return find_rows(PeCliMetadataTableId::GenericParamConstraint, 0, generic_param);
+}
+
+PeCliRowList PeCliMetadataRelations::method_semantics(PeCliMetadataTableIndex association) const
+{
+    return find_coded(PeCliMetadataTableId::MethodSemantics, 2, PeCliEncodedIndexType::HasSemantics, association);
+}
+
+uint32_t PeCliMetadataRelations::find_constant(PeCliMetadataTableIndex parent) const
+{
+    return first_row(find_coded(PeCliMetadataTableId::Constant, 2, PeCliEncodedIndexType::HasConstant, parent));
+}
+
+uint32_t PeCliMetadataRelations::find_field_marshal(PeCliMetadataTableIndex parent) const
+{
+    return first_row(find_coded(PeCliMetadataTableId::FieldMarshal, 0, PeCliEncodedIndexType::HasFieldMarshall, parent));
+}
+
+uint32_t PeCliMetadataRelations::find_impl_map(PeCliMetadataTableIndex member) const
+{
+    return first_row(find_coded(PeCliMetadataTableId::ImplMap, 1, PeCliEncodedIndexType::MemberForwarded, member));
+}
+
+uint32_t PeCliMetadataRelations::find_class_layout(uint32_t type_def) const
+{
+    return first_row(find_rows(PeCliMetadataTableId::ClassLayout, 2, type_def));
+}
+
+uint32_t PeCliMetadataRelations::find_field_layout(uint32_t field) const
+{
+    return first_row(find_rows(PeCliMetadataTableId::FieldLayout, 1, field));
+}
+
+uint32_t PeCliMetadataRelations::find_field_rva(uint32_t field) const
+{
+    return first_row(find_rows(PeCliMetadataTableId::FieldRVA, 1, field));
+}
+
+PeCliRowList PeCliMetadataRelations::local_scopes(uint32_t method_def) const
+{
+    return find_rows(PeCliMetadataTableId::LocalScope, 0, method_def);
+}
+
+PeCliRowList PeCliMetadataRelations::local_variables(uint32_t local_scope) const noexcept
+{
+    return list_range(PeCliMetadataTableId::LocalScope, local_scope_variable_list, PeCliMetadataTableId::LocalVariable, local_scope);
+}
+
+PeCliRowList PeCliMetadataRelations::local_constants(uint32_t local_scope) const noexcept
+{
+    return list_range(PeCliMetadataTableId::LocalScope, local_scope_constant_list, PeCliMetadataTableId::LocalConstant, local_scope);
+}
+
+PeCliRowList PeCliMetadataRelations::custom_debug_information(PeCliMetadataTableIndex parent) const
+{
+    return find_coded(PeCliMetadataTableId::CustomDebugInformation, 0, PeCliEncodedIndexType::HasCustomDebugInformation, parent);
+}
+
+PeCliRowList PeCliMetadataRelations::find_rows(PeCliMetadataTableId table, size_t column, uint32_t key) const
+{
+    size_t  column_count;
+
+    if (PeCliMetadataSchema::table_columns(table, column_count) == nullptr || column >= column_count)
+        throw std::out_of_range("CLI metadata table column index out of range");
+
+    const uint32_t  row_count{_tables.schema().row_count(table)};
+
+    if (row_count == 0)
+        return {};
+
+    const auto  value{[&](uint32_t row) { return column_value(table, row, column); }};
+    const bool  sorted{((_tables.header().sorted_tables >> static_cast<unsigned>(table)) & 1) != 0};
+
+    if (sorted && sort_key_column(table) == static_cast<int>(column))
+    {
+        // The rows are already in key order.
+        const uint32_t  first{partition_point(1, row_count, [&](uint32_t row) { return value(row) < key; })};
+        const uint32_t  last{partition_point(first, row_count + 1 - first, [&](uint32_t row) { return value(row) <= key; })};
+
+        return {first, last};
+    }
+
+    const auto &rows{ordering(table, column)};
+    const auto  first{std::lower_bound(rows.begin(), rows.end(), key, [&](uint32_t row, uint32_t k) { return value(row) < k; })};
+    const auto  last{std::upper_bound(first, rows.end(), key, [&](uint32_t k, uint32_t row) { return k < value(row); })};
+
+    return {rows.data() + (first - rows.begin()), static_cast<uint32_t>(last - first)};
+}
+
+uint32_t PeCliMetadataRelations::column_value(PeCliMetadataTableId table, uint32_t row, size_t column) const noexcept
+{
+    const auto &layout{_tables.schema().layout(table)};
+    const auto  offset{layout.offset + static_cast<size_t>(row - 1) * layout.row_size + layout.column_offsets[column]};
+
+    return PeCliMetadataSchema::read_value(_tables.stream().data() + offset, layout.column_widths[column]);
+}
+
+PeCliRowList PeCliMetadataRelations::list_range(PeCliMetadataTableId owner_table, size_t list_column, PeCliMetadataTableId member_table, uint32_t owner) const noexcept
+{
+    const uint32_t  owner_count{_tables.schema().row_count(owner_table)};
+
+    if (owner == 0 || owner > owner_count)
+        return {};
+
+    // A run extends to the start of the next owner's run,
+    // or, for the last owner, to the end of the member table.
+    const uint32_t  end{member_count(member_table) + 1};
+    const uint32_t  first{column_value(owner_table, owner, list_column)};
+    const uint32_t  last{owner < owner_count ? column_value(owner_table, owner + 1, list_column) : end};
+
+    return {std::max(first, 1u), std::min(last, end)};
+}
+
+uint32_t PeCliMetadataRelations::list_owner(PeCliMetadataTableId owner_table, size_t list_column, PeCliMetadataTableId member_table, uint32_t member) const noexcept
+{
+    if (member == 0 || member > member_count(member_table))
+        return 0;
+
+    // Owners whose runs are empty have the same list value as the owner
+    // that follows them, so the owner is the last row whose list value
+    // does not exceed the member.
+    const uint32_t  count{_tables.schema().row_count(owner_table)};
+
+    return partition_point(1, count, [&](uint32_t row) { return column_value(owner_table, row, list_column) <= member; }) - 1;
+}
+
+uint32_t PeCliMetadataRelations::member_count(PeCliMetadataTableId member_table) const noexcept
+{
+    const auto  pointers{_tables.schema().row_count(PeCliMetadataSchema::pointer_table(member_table))};
+
+    return pointers ? pointers : _tables.schema().row_count(member_table);
+}
+
+PeCliRowList PeCliMetadataRelations::find_coded(PeCliMetadataTableId table, size_t column, PeCliEncodedIndexType type, PeCliMetadataTableIndex key) const
+{
+    return find_rows(table, column, PeCliMetadataSchema::encode_index(type, key));
+}
+
+const std::vector<uint32_t> &PeCliMetadataRelations::ordering(PeCliMetadataTableId table, size_t column) const
+{
+    auto   &ordering{_orderings[static_cast<size_t>(table) % PeCliMetadataSchema::table_count][column]};
+
+    std::call_once(ordering.once,
+                   [&]() {
+                       const uint32_t                              row_count{_tables.schema().row_count(table)};
+                       std::vector<std::pair<uint32_t, uint32_t>>  keyed;   // key and row number
+
+                       keyed.reserve(row_count);
+                       for (uint32_t row = 1; row <= row_count; ++row)
+                           keyed.emplace_back(column_value(table, row, column), row);
+
+                       // Rows with equal keys remain in table order.
+                       std::sort(keyed.begin(), keyed.end());
+
+                       ordering.rows.reserve(row_count);
+                       for (const auto &entry : keyed)
+                           ordering.rows.push_back(entry.second);
+                   });
+
+    return ordering.rows;
+}
@@ -0,0 +1,287 @@
+/// \file   CliRelations.h
+/// Provides navigation between related rows of CLI metadata tables: the
+/// members owned by a type, the owner of a member, and the rows of tables
+/// such as CustomAttribute or NestedClass that refer to a given row.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIRELATIONS_H_
+#define _EXELIB_CLIRELATIONS_H_
+
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+#include "PEExe.h"
+
+
+/// \brief  A list of rows of one metadata table, identified by their
+///         one-based row numbers.
+///
+/// The rows are either a contiguous range, or a range of an array of row
+/// numbers held by the PeCliMetadataRelations object that returned the list.
+class PeCliRowList
+{
+public:
+    /// \brief  Iterates over the row numbers in the list.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint32_t *;
+        using reference = uint32_t;
+
+        const_iterator(const PeCliRowList *list, uint32_t pos) noexcept
+          : _list{list},
+            _pos{pos}
+        {}
+
+        uint32_t operator*() const noexcept
+        {
+            return (*_list)[_pos];
+        }
+
+        const_iterator &operator++() noexcept
+        {
+            ++_pos;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            auto    rv{*this};
+
+            ++_pos;
+            return rv;
+        }
+
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return _pos == other._pos && _list == other._list;
+        }
+
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const PeCliRowList *_list;
+        uint32_t            _pos;
+    };
+
+    /// \brief  Construct an empty list.
+    PeCliRowList() noexcept
+    {}
+
+    /// \brief  Construct a list of the contiguous rows \p first up to, but not including, \p last.
+    PeCliRowList(uint32_t first, uint32_t last) noexcept
+      : _first{first},
+        _size{last > first ? last - first : 0}
+    {}
+
+    /// \brief  Construct a list of the \p size row numbers held in \p rows.
+    PeCliRowList(const uint32_t *rows, uint32_t size) noexcept
+      : _rows{rows},
+        _size{size}
+    {}
+
+    /// \brief  Return the number of rows in the list.
+    uint32_t size() const noexcept
+    {
+        return _size;
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /// \brief  Return the row number at position \p pos. No bounds checking is performed.
+    uint32_t operator[](uint32_t pos) const noexcept
+    {
+        return _rows ? _rows[pos] : _first + pos;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return {this, 0};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return {this, _size};
+    }
+
+private:
+    const uint32_t *_rows{nullptr};
+    uint32_t        _first{0};
+    uint32_t        _size{0};
+};
+
+/// \brief  Navigates the relationships between rows of CLI metadata tables.
+///
+/// Row numbers passed to and returned from these functions are one-based,
+/// as they are in metadata tables and tokens. A row number of zero means
+/// "no row".
+///
+/// Owned members (the fields and methods of a type, the parameters of a
+/// method, and so on) are stored as contiguous runs, so they are found
+/// directly from the owner's list column, and the owner of a member is
+/// found by a binary search of those columns.
+///
+/// Rows that refer to a given row, such as the custom attributes of a
+/// member, are found by a binary search of the referring table when the
+/// table header marks it as sorted on the referring column. Otherwise an
+/// ordering of the table by that column is built the first time it is
+/// needed and reused afterwards.
+///
+/// In an uncompressed (\#-) stream that has pointer tables (FieldPtr,
+/// MethodPtr, and so on), the runs of owned members are rows of the pointer
+/// table, each of which holds the row number of a member.
+///
+/// All member functions may be called concurrently from several threads.
+class PeCliMetadataRelations
+{
+public:
+    /// \brief  Construct an object navigating the given tables.
+    ///         Nothing is computed until it is needed.
+    explicit PeCliMetadataRelations(const PeCliMetadataTables &tables) noexcept
+      : _tables{tables}
+    {}
+
+    PeCliMetadataRelations(const PeCliMetadataRelations &) = delete;
+    PeCliMetadataRelations &operator=(const PeCliMetadataRelations &) = delete;
+
+    /// \brief  Return the Field rows of a TypeDef.
+    PeCliRowList fields(uint32_t type_def) const noexcept;
+
+    /// \brief  Return the MethodDef rows of a TypeDef.
+    PeCliRowList methods(uint32_t type_def) const noexcept;
+
+    /// \brief  Return the Param rows of a MethodDef.
+    PeCliRowList parameters(uint32_t method_def) const noexcept;
+
+    /// \brief  Return the Property rows of a TypeDef.
+    PeCliRowList properties(uint32_t type_def) const;
+
+    /// \brief  Return the Event rows of a TypeDef.
+    PeCliRowList events(uint32_t type_def) const;
+
+    /// \brief  Return the TypeDef row that owns a Field row, or zero if there is none.
+    uint32_t field_owner(uint32_t field) const noexcept;
+
+    /// \brief  Return the TypeDef row that owns a MethodDef row, or zero if there is none.
+    uint32_t method_owner(uint32_t method_def) const noexcept;
+
+    /// \brief  Return the MethodDef row that owns a Param row, or zero if there is none.
+    uint32_t parameter_owner(uint32_t param) const noexcept;
+
+    /// \brief  Return the TypeDef row that owns a Property row, or zero if there is none.
+    uint32_t property_owner(uint32_t property) const noexcept;
+
+    /// \brief  Return the TypeDef row that owns an Event row, or zero if there is none.
+    uint32_t event_owner(uint32_t event) const noexcept;
+
+    /// \brief  Return the NestedClass rows whose enclosing class is \p type_def.
+    PeCliRowList nested_classes(uint32_t type_def) const;
+
+    /// \brief  Return the TypeDef row enclosing a nested TypeDef,
+    ///         or zero if \p type_def is not nested.
+    uint32_t enclosing_class(uint32_t type_def) const;
+
+    /// \brief  Return the InterfaceImpl rows of a TypeDef.
+    PeCliRowList interface_impls(uint32_t type_def) const;
+
+    /// \brief  Return the MethodImpl rows of a TypeDef.
+    PeCliRowList method_impls(uint32_t type_def) const;
+
+    /// \brief  Return the CustomAttribute rows attached to a row of any table.
+    ///
+    /// Here and below, a \c std::runtime_error exception is thrown if the
+    /// table identified by a PeCliMetadataTableIndex cannot be referenced
+    /// by the corresponding column.
+    PeCliRowList custom_attributes(PeCliMetadataTableIndex parent) const;
+
+    /// \brief  Return the DeclSecurity rows attached to a TypeDef, MethodDef, or Assembly row.
+    PeCliRowList decl_security(PeCliMetadataTableIndex parent) const;
+
+    /// \brief  Return the GenericParam rows of a TypeDef or MethodDef row.
+    PeCliRowList generic_params(PeCliMetadataTableIndex owner) const;
+
+    /// \brief  Return the GenericParamConstraint rows of a GenericParam row.
+    PeCliRowList generic_param_constraints(uint32_t generic_param) const;
+
+    /// \brief  Return the MethodSemantics rows of an Event or Property row.
+    PeCliRowList method_semantics(PeCliMetadataTableIndex association) const;
+
+    /// \brief  Return the Constant row giving the value of a Field, Param, or
+    ///         Property row, or zero if there is none.
+    ///
+    /// This and the functions below return a single row because ECMA-335
+    /// allows at most one row of their tables for each row referred to.
+    uint32_t find_constant(PeCliMetadataTableIndex parent) const;
+
+    /// \brief  Return the FieldMarshal row of a Field or Param row, or zero if there is none.
+    uint32_t find_field_marshal(PeCliMetadataTableIndex parent) const;
+
+    /// \brief  Return the ImplMap row describing the P/Invoke target of a
+    ///         MethodDef or Field row, or zero if there is none.
+    uint32_t find_impl_map(PeCliMetadataTableIndex member) const;
+
+    /// \brief  Return the ClassLayout row of a TypeDef, or zero if there is none.
+    uint32_t find_class_layout(uint32_t type_def) const;
+
+    /// \brief  Return the FieldLayout row giving the offset of a Field, or zero if there is none.
+    uint32_t find_field_layout(uint32_t field) const;
+
+    /// \brief  Return the FieldRVA row giving the initial data of a Field, or zero if there is none.
+    uint32_t find_field_rva(uint32_t field) const;
+
+    /// \brief  Return the LocalScope rows of a MethodDef, in a Portable PDB.
+    PeCliRowList local_scopes(uint32_t method_def) const;
+
+    /// \brief  Return the LocalVariable rows of a LocalScope, in a Portable PDB.
+    PeCliRowList local_variables(uint32_t local_scope) const noexcept;
+
+    /// \brief  Return the LocalConstant rows of a LocalScope, in a Portable PDB.
+    PeCliRowList local_constants(uint32_t local_scope) const noexcept;
+
+    /// \brief  Return the CustomDebugInformation rows attached to a row of any table, in a Portable PDB.
+    PeCliRowList custom_debug_information(PeCliMetadataTableIndex parent) const;
+
+    /// \brief  Return the rows of a table whose value in a column equals \p key.
+    /// \param table    Identifier of the table to search.
+    /// \param column   Zero-based index of the column, in the order of the
+    ///                 members of the table's row structure.
+    /// \param key      The value to find. For a coded index column this is
+    ///                 the encoded value, as produced by PeCliMetadataSchema::encode_index.
+    ///
+    /// The rows are returned in table order. A \c std::out_of_range exception
+    /// is thrown if \p column is not a column of \p table.
+    PeCliRowList find_rows(PeCliMetadataTableId table, size_t column, uint32_t key) const;
+
+private:
+    // The rows of one table, ordered by the value of one column.
+    struct Ordering
+    {
+        std::once_flag          once;
+        std::vector<uint32_t>   rows;   // one-based row numbers
+    };
+
+    uint32_t column_value(PeCliMetadataTableId table, uint32_t row, size_t column) const noexcept;
+    PeCliRowList list_range(PeCliMetadataTableId owner_table, size_t list_column, PeCliMetadataTableId member_table, uint32_t owner) const noexcept;
+    uint32_t list_owner(PeCliMetadataTableId owner_table, size_t list_column, PeCliMetadataTableId member_table, uint32_t member) const noexcept;
+    uint32_t member_count(PeCliMetadataTableId member_table) const noexcept;
+    PeCliRowList find_coded(PeCliMetadataTableId table, size_t column, PeCliEncodedIndexType type, PeCliMetadataTableIndex key) const;
+    const std::vector<uint32_t> &ordering(PeCliMetadataTableId table, size_t column) const;
+
+    const PeCliMetadataTables  &_tables;
+    mutable Ordering            _orderings[PeCliMetadataSchema::table_count][PeCliMetadataTableLayout::max_columns];
+};
+
+#endif  //_EXELIB_CLIRELATIONS_H_
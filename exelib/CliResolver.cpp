@@ -0,0 +1,312 @@
+/// \file   CliResolver.cpp
+/// Implementation of the PeCliAssembly and PeCliAssemblyResolver classes.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "CliResolver.h"
+
+namespace {
+
+// Forwarders may lead to assemblies that forward the type again; chains
+// longer than this can only come from a cycle and are cut off.
+constexpr unsigned max_forwarding_depth{8};
+
+const PeCliMetadata &get_metadata(const ExeInfo &exe)
+{
+    const auto *pe{exe.pe_part()};
+
+    if (pe == nullptr || pe->cli() == nullptr || !pe->cli()->has_metadata()
+        || pe->cli()->metadata()->metadata_tables() == nullptr)
+    {
+        throw std::runtime_error("Executable has no CLI metadata tables");
+    }
+
+    return *pe->cli()->metadata();
+}
+
+// Return the fully-qualified name of the top-level type enclosing the
+// type with the name given, which is the name itself for a top-level type.
+StringView top_level_name(StringView name) noexcept
+{
+    for (size_t i = 0; i < name.size(); ++i)
+        if (name[i] == '+')
+            return {name.data(), i};
+
+    return name;
+}
+
+}   // anonymous namespace
+
+
+PeCliAssembly::PeCliAssembly(std::string path, ExeInfo &&exe)
+  : _path{std::move(path)},
+    _exe{std::move(exe)},
+    _metadata{&get_metadata(_exe)}
+{
+    if (!_metadata->metadata_tables()->table<PeCliMetadataRowAssembly>().empty())
+        _identity = PeCliAssemblyIdentity::from_assembly(*_metadata);
+
+    const auto  exported_types{_metadata->metadata_tables()->table<PeCliMetadataRowExportedType>()};
+    std::string name;
+
+    // Only top-level types are forwarded; their nested types go with them.
+    for (const auto &row : exported_types)
+    {
+        const auto  implementation{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::Implementation, row.implementation)};
+
+        if (implementation.table_id != PeCliMetadataTableId::AssemblyRef || implementation.index == 0)
+            continue;
+
+        const auto  name_space{_metadata->get_string_view(row.type_namespace)};
+
+        name.clear();
+        if (!name_space.empty())
+        {
+            name.append(name_space.data(), name_space.size());
+            name.push_back('.');
+        }
+        name += _metadata->get_string_view(row.type_name).str();
+        _forwarders.emplace(name, implementation.index);
+    }
+}
+
+uint32_t PeCliAssembly::find_forwarder(StringView name) const noexcept
+{
+    if (_forwarders.empty())
+        return 0;
+
+    const auto  it{_forwarders.find(name.str())};
+
+    return it == _forwarders.end() ? 0 : it->second;
+}
+
+
+PeCliAssemblyResolver::PeCliAssemblyResolver(std::vector<std::string> directories, size_t capacity, LoadOptions::Options options)
+  : _directories{std::move(directories)},
+    _capacity{capacity ? capacity : 1},
+    _options{options}
+{}
+
+std::shared_ptr<const PeCliAssembly> PeCliAssemblyResolver::open(const std::string &path) const
+{
+    std::shared_ptr<File>   file;
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto                       &slot{_files[path]};
+
+        if (slot == nullptr)
+            slot = std::make_shared<File>();
+        file = slot;
+    }
+
+    std::shared_ptr<const PeCliAssembly>    assembly;
+
+    try
+    {
+        // Only one thread loads a given file; any other thread asking for it
+        // meanwhile waits here, then shares what was loaded.
+        std::lock_guard<std::mutex> lock{file->mutex};
+
+        assembly = file->assembly.lock();
+        if (assembly == nullptr)
+        {
+            std::ifstream   stream(path, std::ios::binary);
+
+            if (!stream)
+                throw std::runtime_error("Cannot open " + path);
+
+            assembly = std::make_shared<const PeCliAssembly>(path, ExeInfo{stream, _options});
+            file->assembly = assembly;
+        }
+    }
+    catch (...)
+    {
+        // Most paths probed do not exist. Their entries are dropped, unless
+        // another thread is still waiting on one, so probing leaves nothing behind.
+        std::lock_guard<std::mutex> lock{_mutex};
+        const auto                  it{_files.find(path)};
+
+        if (it != _files.end() && it->second == file && file.use_count() == 2)
+            _files.erase(it);
+        throw;
+    }
+
+    return assembly;
+}
+
+std::shared_ptr<const PeCliAssembly> PeCliAssemblyResolver::load(const PeCliAssemblyIdentity &reference) const
+{
+    const auto  file_name{reference.culture.empty() ? reference.name : reference.culture + '/' + reference.name};
+
+    for (const auto &directory : _directories)
+    {
+        for (const auto *extension : {".dll", ".exe"})
+        {
+            std::shared_ptr<const PeCliAssembly>    assembly;
+
+            try
+            {
+                assembly = open(directory + '/' + file_name + extension);
+            }
+            catch (const std::exception &)
+            {
+                continue;   // missing or not an assembly; keep looking
+            }
+
+            if (assembly->identity().satisfies(reference))
+                return assembly;
+        }
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<const PeCliAssembly> PeCliAssemblyResolver::resolve_assembly(const PeCliAssembly &from, uint32_t row)
+{
+    const auto &metadata{from.metadata()};
+    const auto  table{metadata.metadata_tables()->table<PeCliMetadataRowAssemblyRef>()};
+
+    if (row == 0 || row > table.size())
+        return nullptr;
+
+    const auto  key{PeCliAssemblyIdentity::from_assembly_ref(metadata, row)};
+
+    std::promise<std::shared_ptr<const PeCliAssembly>>  promise;
+    Future                                              future;
+    bool                                                loader{false};
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        const auto                  it{_entries.find(key)};
+
+        if (it != _entries.end())
+        {
+            _order.splice(_order.begin(), _order, it->second.position);
+            future = it->second.assembly;
+        }
+        else
+        {
+            future = promise.get_future().share();
+            loader = true;
+            _order.push_front(key);
+            _entries.emplace(key, Entry{future, _order.begin()});
+
+            if (_entries.size() > _capacity)
+            {
+                while (_entries.size() > _capacity)
+                {
+                    _entries.erase(_order.back());
+                    _order.pop_back();
+                }
+                prune_files();
+            }
+        }
+    }
+
+    // This thread loads the assembly outside the lock; any other thread
+    // asking for it meanwhile waits on the future.
+    if (loader)
+    {
+        try
+        {
+            promise.set_value(load(key));
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    return future.get();
+}
+
+PeCliResolvedType PeCliAssemblyResolver::find_type(std::shared_ptr<const PeCliAssembly> assembly, StringView name, unsigned depth)
+{
+    if (assembly == nullptr)
+        return {};
+
+    const auto  type_def{assembly->type_names().find_type_def(name)};
+
+    if (type_def != 0)
+        return {std::move(assembly), type_def};
+
+    const auto  forwarder{assembly->find_forwarder(top_level_name(name))};
+
+    if (forwarder == 0 || depth >= max_forwarding_depth)
+        return {};
+
+    return find_type(resolve_assembly(*assembly, forwarder), name, depth + 1);
+}
+
+PeCliResolvedType PeCliAssemblyResolver::resolve_type(const PeCliAssembly &from, uint32_t token)
+{
+    const auto  index{PeCliMetadataTableIndex::from_token(token)};
+    const auto  type_refs{from.metadata().metadata_tables()->table<PeCliMetadataRowTypeRef>()};
+
+    if (index.table_id != PeCliMetadataTableId::TypeRef || index.index == 0 || index.index > type_refs.size())
+        return {};
+
+    // A TypeRef to a nested type has the TypeRef of its enclosing type as its
+    // resolution scope; the outermost TypeRef says where the type is defined.
+    auto        scope{PeCliMetadataTableIndex{PeCliMetadataTableId::TypeRef, index.index}};
+    unsigned    steps{0};
+
+    while (scope.table_id == PeCliMetadataTableId::TypeRef)
+    {
+        if (scope.index == 0 || scope.index > type_refs.size() || ++steps > type_refs.size())
+            return {};
+
+        scope = PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::ResolutionScope,
+                                                  type_refs.row(scope.index - 1).resolution_scope);
+    }
+
+    const auto  name{from.type_names().name(token)};
+
+    switch (scope.table_id)
+    {
+        case PeCliMetadataTableId::AssemblyRef:
+            return find_type(resolve_assembly(from, scope.index), name, 0);
+
+        case PeCliMetadataTableId::Module:
+            return find_type(from.shared_from_this(), name, 0);
+
+        default:
+            return {};
+    }
+}
+
+void PeCliAssemblyResolver::prune_files()
+{
+    // Drop the entries whose assemblies are no longer in use and which no
+    // thread is loading.
+    for (auto it = _files.begin(); it != _files.end(); )
+    {
+        if (it->second.use_count() == 1 && it->second->assembly.expired())
+            it = _files.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t PeCliAssemblyResolver::cached_count() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    return _entries.size();
+}
+
+void PeCliAssemblyResolver::clear()
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    _entries.clear();
+    _order.clear();
+    _files.clear();
+}
@@ -0,0 +1,229 @@
+/// \file   CliResolver.h
+/// Provides resolution of CLI assembly and type references to the
+/// assemblies and types they refer to, keeping the assemblies it loads
+/// in a cache shared between resolutions.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIRESOLVER_H_
+#define _EXELIB_CLIRESOLVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CliAssemblyIdentity.h"
+#include "CliTypeNames.h"
+#include "ExeInfo.h"
+#include "LoadOptions.h"
+#include "views.h"
+
+
+/// \brief  An assembly loaded for resolution: an executable with CLI
+///         metadata, together with the indexes used to look up its types.
+///
+/// An assembly is not modified after construction, so it may be used
+/// concurrently from several threads. Assemblies are always held by
+/// \c std::shared_ptr, as PeCliAssemblyResolver creates them.
+class PeCliAssembly : public std::enable_shared_from_this<PeCliAssembly>
+{
+public:
+    /// \brief  Construct an assembly from a loaded executable.
+    /// \param path The path from which the executable was loaded.
+    /// \param exe  The executable, which must have been loaded with at
+    ///             least LoadOptions::LoadCliMetadataTables.
+    ///
+    /// A \c std::runtime_error exception is thrown if \p exe has no CLI
+    /// metadata tables.
+    PeCliAssembly(std::string path, ExeInfo &&exe);
+
+    PeCliAssembly(const PeCliAssembly &) = delete;
+    PeCliAssembly &operator=(const PeCliAssembly &) = delete;
+
+    /// \brief  Return the path from which the assembly was loaded.
+    const std::string &path() const noexcept
+    {
+        return _path;
+    }
+
+    /// \brief  Return the executable.
+    const ExeInfo &exe() const noexcept
+    {
+        return _exe;
+    }
+
+    /// \brief  Return the identity of the assembly, which is empty if
+    ///         the executable is a module without an Assembly row.
+    const PeCliAssemblyIdentity &identity() const noexcept
+    {
+        return _identity;
+    }
+
+    /// \brief  Return the CLI metadata of the assembly.
+    const PeCliMetadata &metadata() const noexcept
+    {
+        return *_metadata;
+    }
+
+    /// \brief  Return the index of the names of the types defined and referenced by the assembly.
+    const PeCliTypeNameIndex &type_names() const
+    {
+        return _metadata->type_names();
+    }
+
+    /// \brief  Return the one-based AssemblyRef row number of the assembly
+    ///         to which the top-level type with the fully-qualified name
+    ///         \p name is forwarded, or zero if the type is not forwarded.
+    uint32_t find_forwarder(StringView name) const noexcept;
+
+private:
+    std::string                                     _path;
+    ExeInfo                                         _exe;
+    const PeCliMetadata                            *_metadata;
+    PeCliAssemblyIdentity                           _identity;
+    std::unordered_map<std::string, uint32_t>       _forwarders;    // top-level type name to AssemblyRef row
+};
+
+/// \brief  A TypeDef row found by PeCliAssemblyResolver::resolve_type.
+struct PeCliResolvedType
+{
+    std::shared_ptr<const PeCliAssembly>    assembly;   ///< The assembly defining the type, or null if the type could not be resolved
+    uint32_t                                type_def;   ///< The TypeDef token of the type, or zero if the type could not be resolved
+
+    explicit operator bool() const noexcept
+    {
+        return type_def != 0;
+    }
+};
+
+/// \brief  Resolves AssemblyRef and TypeRef rows to the assemblies and types
+///         they refer to, by probing a list of directories.
+///
+/// An assembly named \c N is looked for as \c N.dll, then as \c N.exe, in
+/// each of the directories in turn; an assembly with a culture \c C is
+/// looked for in the \c C subdirectory of each. A file is accepted if its
+/// identity satisfies the reference, as PeCliAssemblyIdentity::satisfies
+/// determines: it has the referenced name and culture, the referenced
+/// public key token if the reference has one, and a version no lower than
+/// the one referenced.
+///
+/// Resolutions are kept in a cache holding at most a given number of
+/// them, keyed by the identity of the reference: name, version, culture,
+/// and public key token. When the cache is full, the resolution used least
+/// recently is dropped from it. References that cannot be resolved are
+/// cached too, so the directories are probed for each identity only once
+/// while it remains in the cache.
+///
+/// Different references, such as those to different versions of an
+/// assembly, may resolve to the same file. Loaded assemblies are also
+/// tracked by the path from which they were loaded, so each file is
+/// loaded only once for as long as its assembly remains in use, whether
+/// through the cache or elsewhere.
+///
+/// A resolver may be shared by several threads. A thread that asks for an
+/// assembly that another thread is loading waits for that load rather than
+/// loading the assembly again. Assemblies are held by \c std::shared_ptr,
+/// so an assembly dropped from the cache remains valid for as long as it
+/// is in use.
+class PeCliAssemblyResolver
+{
+public:
+    /// \brief  Construct a resolver.
+    /// \param directories  The directories in which to look for assemblies, in order.
+    /// \param capacity     The largest number of assemblies to keep in the cache.
+    /// \param options      The options with which to load assemblies, which
+    ///                     must include LoadOptions::LoadCliMetadataTables.
+    explicit PeCliAssemblyResolver(std::vector<std::string> directories,
+                                   size_t capacity = 64,
+                                   LoadOptions::Options options = LoadOptions::LoadCliMetadataTables);
+
+    PeCliAssemblyResolver(const PeCliAssemblyResolver &) = delete;
+    PeCliAssemblyResolver &operator=(const PeCliAssemblyResolver &) = delete;
+
+    /// \brief  Load an assembly from a file.
+    ///
+    /// This is how the assembly at the root of an analysis is usually
+    /// loaded. If the assembly loaded from \p path is still in use, it is
+    /// returned rather than loaded again. A \c std::runtime_error exception
+    /// is thrown if the file cannot be opened or is not an assembly.
+    std::shared_ptr<const PeCliAssembly> open(const std::string &path) const;
+
+    /// \brief  Return the assembly referred to by an AssemblyRef row of another assembly.
+    /// \param from The assembly holding the reference.
+    /// \param row  The one-based AssemblyRef row number.
+    ///
+    /// Returns null if the assembly cannot be found, or if \p row is not
+    /// an AssemblyRef row of \p from.
+    std::shared_ptr<const PeCliAssembly> resolve_assembly(const PeCliAssembly &from, uint32_t row);
+
+    /// \brief  Return the TypeDef row referred to by a TypeRef row of another assembly.
+    /// \param from     The assembly holding the reference, which must be held by a \c std::shared_ptr.
+    /// \param token    The TypeRef token.
+    ///
+    /// Returns an unresolved type if \p token is not a TypeRef token of \p from.
+    /// Type forwarders, recorded in the ExportedType table of the assembly
+    /// referred to, are followed. A type in another module of a multi-module
+    /// assembly is not resolved.
+    PeCliResolvedType resolve_type(const PeCliAssembly &from, uint32_t token);
+
+    /// \brief  Return the TypeDef row of the type with a fully-qualified
+    ///         name in an assembly, following its type forwarders.
+    ///
+    /// Returns an unresolved type if \p assembly is null or neither it nor
+    /// the assemblies it forwards the type to define the type.
+    PeCliResolvedType find_type(std::shared_ptr<const PeCliAssembly> assembly, StringView name)
+    {
+        return find_type(std::move(assembly), name, 0);
+    }
+
+    /// \brief  Return the number of entries in the cache, including those
+    ///         for references that could not be resolved.
+    size_t cached_count() const;
+
+    /// \brief  Drop every assembly from the cache.
+    void clear();
+
+private:
+    using Future = std::shared_future<std::shared_ptr<const PeCliAssembly>>;
+    using Order = std::list<PeCliAssemblyIdentity>;
+
+    struct Entry
+    {
+        Future              assembly;
+        Order::iterator     position;   // within _order
+    };
+
+    std::shared_ptr<const PeCliAssembly> load(const PeCliAssemblyIdentity &reference) const;
+    PeCliResolvedType find_type(std::shared_ptr<const PeCliAssembly> assembly, StringView name, unsigned depth);
+    void prune_files();     // with _mutex held
+
+    // An assembly loaded from a file, which is loaded again only once it
+    // is no longer in use. Its mutex is held while the file is loaded.
+    // Entries for files that fail to load are removed at once, and those
+    // whose assemblies are no longer in use when the cache drops an entry.
+    struct File
+    {
+        std::mutex                              mutex;
+        std::weak_ptr<const PeCliAssembly>      assembly;
+    };
+
+    using Entries = std::unordered_map<PeCliAssemblyIdentity, Entry, PeCliAssemblyIdentityHash>;
+    using Files = std::unordered_map<std::string, std::shared_ptr<File>>;
+
+    std::vector<std::string>    _directories;
+    size_t                      _capacity;
+    LoadOptions::Options        _options;
+    mutable std::mutex          _mutex;     // guards _order, _entries, and _files
+    Order                       _order;     // most recently used first
+    Entries                     _entries;   // by the identity of the reference
+    mutable Files               _files;     // by the path from which the assembly was loaded
+};
+
+#endif  //_EXELIB_CLIRESOLVER_H_
@@ -0,0 +1,109 @@
+/// \file   CliResources.cpp
+/// Implementation of access to embedded managed resources.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "CliResources.h"
+
+namespace {
+
+// Return the number of resources embedded in this file, which are those
+// whose implementation is null.
+size_t count_embedded(const PeCli &cli)
+{
+    const auto *metadata{cli.metadata()};
+
+    if (metadata == nullptr || metadata->metadata_tables() == nullptr)
+        return 0;
+
+    size_t  rv{0};
+
+    for (const auto &row : metadata->metadata_tables()->table<PeCliMetadataRowManifestResource>())
+        if (row.implementation == 0)
+            ++rv;
+
+    return rv;
+}
+
+// Return the embedded resources, given the block of data holding them.
+std::vector<PeCliManagedResource> read_resources(const PeCli &cli, BytesView block, size_t embedded)
+{
+    std::vector<PeCliManagedResource>   rv;
+    const auto                         *metadata{cli.metadata()};
+    const auto                          table{metadata->metadata_tables()->table<PeCliMetadataRowManifestResource>()};
+
+    rv.reserve(embedded);
+    for (uint32_t i = 0; i < table.size(); ++i)
+    {
+        const auto  row{table.row(i)};
+
+        if (row.implementation != 0)
+            continue;
+
+        if (row.offset > block.size() || block.size() - row.offset < sizeof(uint32_t))
+            throw std::runtime_error("CLI resource offset is beyond the resources block");
+
+        const uint32_t  length{PeCliMetadataSchema::read_value(block.data() + row.offset, sizeof(uint32_t))};
+        const size_t    start{row.offset + sizeof(uint32_t)};
+
+        if (length > block.size() - start)
+            throw std::runtime_error("CLI resource extends beyond the resources block");
+
+        rv.push_back({i + 1, row.flags, metadata->get_string_view(row.name), block.subview(start, length)});
+    }
+
+    return rv;
+}
+
+}   // anonymous namespace
+
+
+std::vector<PeCliManagedResource> get_managed_resources(const PeCli &cli, const std::vector<PeSection> &sections)
+{
+    const auto  embedded{count_embedded(cli)};
+
+    if (embedded == 0)
+        return {};
+
+    const auto &directory{cli.header().resources};
+    const auto *section{find_section_by_rva(directory.virtual_address, sections)};
+
+    if (section == nullptr || !section->data_loaded()
+        || directory.virtual_address - section->virtual_address() >= section->data().size())
+    {
+        throw std::runtime_error("CLI resources are not within a loaded section");
+    }
+
+    return read_resources(cli, BytesView{section->data()}.subview(directory.virtual_address - section->virtual_address(), directory.size), embedded);
+}
+
+std::vector<PeCliManagedResource> get_managed_resources(const PeExeInfo &pe, BytesView image)
+{
+    const auto *cli{pe.cli()};
+    const auto  embedded{cli ? count_embedded(*cli) : 0};
+
+    if (embedded == 0)
+        return {};
+
+    const auto &directory{cli->header().resources};
+    const auto *section{find_section_by_rva(directory.virtual_address, pe.sections())};
+
+    if (section == nullptr || section->header().raw_data_position == 0
+        || directory.virtual_address - section->virtual_address() >= section->raw_data_size())
+    {
+        throw std::runtime_error("CLI resources are not within the raw data of a section");
+    }
+
+    // Only the part of the block within the section's raw data is in the file.
+    const auto  offset{static_cast<uint64_t>(get_file_offset(directory.virtual_address, *section))};
+    const auto  in_section{std::min<uint64_t>(directory.size, section->raw_data_size() - (directory.virtual_address - section->virtual_address()))};
+
+    if (offset >= image.size())
+        throw std::runtime_error("CLI resources are beyond the end of the image");
+
+    return read_resources(*cli, image.subview(static_cast<size_t>(offset), static_cast<size_t>(in_section)), embedded);
+}
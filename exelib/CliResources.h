@@ -0,0 +1,75 @@
+/// \file   CliResources.h
+/// Provides access to the managed resources embedded in an assembly.
+///
+/// Embedded resources are listed in the ManifestResource table, ECMA-335,
+/// section II.22.24. Their content is stored one after another in the
+/// block addressed by the resources member of the CLI header, each
+/// preceded by its length as a four-byte little-endian value.
+///
+/// The resources refer either to the raw data of the section containing
+/// them, which must have been loaded with LoadOptions::LoadSectionData, or
+/// to an image of the whole file, such as a memory-mapped file, so that no
+/// section data need be copied.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLIRESOURCES_H_
+#define _EXELIB_CLIRESOURCES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Visibility flags of a ManifestResource row. ECMA-335, section II.23.1.9.
+enum class PeCliManifestResourceFlags : uint32_t
+{
+    Public          = 0x0001,   ///< The resource is exported from the assembly
+    Private         = 0x0002,   ///< The resource is private to the assembly
+    VisibilityMask  = 0x0007
+};
+
+/// \brief  A managed resource embedded in an assembly.
+///
+/// The name and content are views of the metadata and of the section data
+/// or file image of the assembly, and are valid only as long as they are.
+struct PeCliManagedResource
+{
+    uint32_t    row;        ///< The one-based ManifestResource row number
+    uint32_t    flags;      ///< The PeCliManifestResourceFlags of the resource
+    StringView  name;       ///< The name of the resource, such as "MyApp.Strings.resources"
+    BytesView   content;    ///< The content of the resource
+};
+
+/// \brief  Return the resources embedded in an assembly, in ManifestResource table order.
+/// \param cli      The CLI information of the assembly, loaded with its metadata streams.
+/// \param sections The sections of the executable, whose data must have been loaded.
+///
+/// Resources held in other files of a multi-file assembly, or in other
+/// assemblies, are not included. The vector is empty if the assembly has
+/// no ManifestResource table or its metadata was not loaded.
+///
+/// A \c std::runtime_error exception is thrown if the resources block is
+/// not within a section with loaded data, or if a resource extends beyond
+/// the block.
+std::vector<PeCliManagedResource> get_managed_resources(const PeCli &cli, const std::vector<PeSection> &sections);
+
+/// \brief  Return the resources embedded in an assembly, in ManifestResource
+///         table order, as views of an image of the whole file.
+/// \param pe       The executable, loaded with its CLI metadata streams.
+///                 Its section data need not be loaded.
+/// \param image    The entire file, such as a memory-mapped view of it.
+///
+/// The resources block is found by translating its RVA to a file offset
+/// through the section headers. The vector is empty if the executable is
+/// not an assembly, or under the same conditions as the overload above.
+///
+/// A \c std::runtime_error exception is thrown if the resources block is
+/// not within the raw data of a section in \p image, or if a resource
+/// extends beyond the block.
+std::vector<PeCliManagedResource> get_managed_resources(const PeExeInfo &pe, BytesView image);
+
+#endif  //_EXELIB_CLIRESOURCES_H_
@@ -0,0 +1,344 @@
+/// \file   CliSignature.cpp
+/// Implementation of the CLI signature decoder.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <stdexcept>
+
+#include "CliSignature.h"
+
+namespace {
+
+// Signatures are decoded recursively. Well-formed signatures nest only a
+// few levels deep, so this limit only guards against hostile input.
+constexpr unsigned max_nesting{64};
+
+constexpr uint8_t kind_of(uint8_t calling_convention)
+{
+    return calling_convention & static_cast<uint8_t>(PeCliCallingConvention::KindMask);
+}
+
+constexpr bool has_flag(uint8_t calling_convention, PeCliCallingConvention flag)
+{
+    return (calling_convention & static_cast<uint8_t>(flag)) != 0;
+}
+
+constexpr uint8_t element(PeCliMetadataElementType type)
+{
+    return static_cast<uint8_t>(type);
+}
+
+class SignatureDecoder
+{
+public:
+    SignatureDecoder(BytesView signature, PeCliSignatureVisitor &visitor) noexcept
+      : _reader{signature},
+        _visitor{visitor}
+    {}
+
+    size_t decode_signature()
+    {
+        const uint8_t   calling_convention{_reader.read_byte()};
+
+        switch (kind_of(calling_convention))
+        {
+            case static_cast<uint8_t>(PeCliCallingConvention::FieldSig):
+                _visitor.field();
+                decode_type();
+                break;
+
+            case static_cast<uint8_t>(PeCliCallingConvention::LocalSig):
+                decode_locals();
+                break;
+
+            case static_cast<uint8_t>(PeCliCallingConvention::GenericInstSig):
+                decode_method_spec();
+                break;
+
+            default:    // a method or property signature
+                decode_method(calling_convention);
+                break;
+        }
+
+        return _reader.position();
+    }
+
+    size_t decode_type_spec()
+    {
+        decode_type();
+        return _reader.position();
+    }
+
+private:
+    // RAII guard counting the nesting depth.
+    class Nest
+    {
+    public:
+        explicit Nest(unsigned &depth)
+          : _depth{depth}
+        {
+            if (++_depth > max_nesting)
+                throw std::runtime_error("Malformed CLI signature: nested too deeply");
+        }
+
+        ~Nest()
+        {
+            --_depth;
+        }
+
+    private:
+        unsigned   &_depth;
+    };
+
+    void decode_method(uint8_t calling_convention)
+    {
+        const uint8_t   kind{kind_of(calling_convention)};
+
+        if (kind == static_cast<uint8_t>(PeCliCallingConvention::FieldSig)
+            || kind == static_cast<uint8_t>(PeCliCallingConvention::LocalSig)
+            || kind == static_cast<uint8_t>(PeCliCallingConvention::GenericInstSig)
+            || kind > static_cast<uint8_t>(PeCliCallingConvention::NativeVarArg))
+            throw std::runtime_error("Malformed CLI signature: unknown calling convention");
+
+        Nest        nest{_depth};
+        uint32_t    generic_parameter_count{0};
+
+        if (has_flag(calling_convention, PeCliCallingConvention::Generic))
+            generic_parameter_count = _reader.read_compressed_unsigned();
+
+        const uint32_t  parameter_count{_reader.read_compressed_unsigned()};
+
+        _visitor.begin_method(calling_convention, generic_parameter_count, parameter_count);
+        _visitor.return_type();
+        decode_type();
+
+        for (uint32_t i = 0; i < parameter_count; ++i)
+        {
+            if (_reader.peek() == element(PeCliMetadataElementType::Sentinel))
+            {
+                _reader.read_byte();
+                _visitor.sentinel();
+            }
+            _visitor.parameter(i);
+            decode_type();
+        }
+
+        _visitor.end_method();
+    }
+
+    void decode_locals()
+    {
+        const uint32_t  count{_reader.read_compressed_unsigned()};
+
+        _visitor.begin_locals(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            _visitor.local(i);
+            decode_type();
+        }
+        _visitor.end_locals();
+    }
+
+    void decode_method_spec()
+    {
+        const uint32_t  count{_reader.read_compressed_unsigned()};
+
+        _visitor.begin_method_spec(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            _visitor.generic_argument(i);
+            decode_type();
+        }
+        _visitor.end_method_spec();
+    }
+
+    // Decode a type, including any custom modifiers that precede it.
+    void decode_type()
+    {
+        Nest    nest{_depth};
+
+        for (;;)
+        {
+            const uint8_t   byte{_reader.read_byte()};
+            const auto      type{static_cast<PeCliMetadataElementType>(byte)};
+
+            switch (type)
+            {
+                case PeCliMetadataElementType::CModReq:
+                case PeCliMetadataElementType::CModOpt:
+                    _visitor.custom_modifier(type == PeCliMetadataElementType::CModReq, _reader.read_type_def_or_ref());
+                    continue;   // the modified type follows
+
+                case PeCliMetadataElementType::Void:
+                case PeCliMetadataElementType::Boolean:
+                case PeCliMetadataElementType::Char:
+                case PeCliMetadataElementType::I1:
+                case PeCliMetadataElementType::U1:
+                case PeCliMetadataElementType::I2:
+                case PeCliMetadataElementType::U2:
+                case PeCliMetadataElementType::I4:
+                case PeCliMetadataElementType::U4:
+                case PeCliMetadataElementType::I8:
+                case PeCliMetadataElementType::U8:
+                case PeCliMetadataElementType::R4:
+                case PeCliMetadataElementType::R8:
+                case PeCliMetadataElementType::String:
+                case PeCliMetadataElementType::TypedByRef:
+                case PeCliMetadataElementType::IntPtr:
+                case PeCliMetadataElementType::UIntPtr:
+                case PeCliMetadataElementType::Object:
+                    _visitor.element_type(type);
+                    return;
+
+                case PeCliMetadataElementType::Ptr:
+                case PeCliMetadataElementType::ByRef:
+                case PeCliMetadataElementType::SzArray:
+                case PeCliMetadataElementType::Pinned:
+                    _visitor.element_type(type);
+                    decode_type();
+                    return;
+
+                case PeCliMetadataElementType::Class:
+                case PeCliMetadataElementType::ValueType:
+                    _visitor.type_reference(type, _reader.read_type_def_or_ref());
+                    return;
+
+                case PeCliMetadataElementType::Var:
+                case PeCliMetadataElementType::MVar:
+                    _visitor.generic_parameter(type, _reader.read_compressed_unsigned());
+                    return;
+
+                case PeCliMetadataElementType::GenericInst:
+                    decode_generic_instance();
+                    return;
+
+                case PeCliMetadataElementType::Array:
+                    _visitor.element_type(type);
+                    decode_type();
+                    decode_array_shape();
+                    return;
+
+                case PeCliMetadataElementType::FnPtr:
+                    _visitor.element_type(type);
+                    decode_method(_reader.read_byte());
+                    return;
+
+                default:
+                    throw std::runtime_error("Malformed CLI signature: invalid element type");
+            }
+        }
+    }
+
+    void decode_generic_instance()
+    {
+        const auto  kind{static_cast<PeCliMetadataElementType>(_reader.read_byte())};
+
+        if (kind != PeCliMetadataElementType::Class && kind != PeCliMetadataElementType::ValueType)
+            throw std::runtime_error("Malformed CLI signature: generic instantiation of a type that is not a class or value type");
+
+        const auto      type{_reader.read_type_def_or_ref()};
+        const uint32_t  count{_reader.read_compressed_unsigned()};
+
+        _visitor.begin_generic_instance(kind, type, count);
+        for (uint32_t i = 0; i < count; ++i)
+            decode_type();
+        _visitor.end_generic_instance();
+    }
+
+    void decode_array_shape()
+    {
+        const uint32_t  rank{_reader.read_compressed_unsigned()};
+
+        _visitor.array_shape(rank, _reader);
+
+        // skip the sizes and lower bounds
+        for (uint32_t count = _reader.read_compressed_unsigned(); count; --count)
+            _reader.read_compressed_unsigned();
+        for (uint32_t count = _reader.read_compressed_unsigned(); count; --count)
+            _reader.read_compressed_signed();
+    }
+
+    PeCliSignatureReader    _reader;
+    PeCliSignatureVisitor  &_visitor;
+    unsigned                _depth{0};
+};
+
+}   // anonymous namespace
+
+
+uint8_t PeCliSignatureReader::peek() const
+{
+    if (at_end())
+        throw std::runtime_error("Malformed CLI signature: truncated");
+
+    return _bytes[_pos];
+}
+
+uint8_t PeCliSignatureReader::read_byte()
+{
+    const uint8_t   rv{peek()};
+
+    ++_pos;
+    return rv;
+}
+
+uint32_t PeCliSignatureReader::read_compressed_unsigned()
+{
+    const uint32_t  b1{read_byte()};
+
+    if ((b1 & 0x80) == 0)
+        return b1;
+
+    if ((b1 & 0xC0) == 0x80)
+        return (b1 & 0x3F) << 8 | read_byte();
+
+    if ((b1 & 0xE0) == 0xC0)
+    {
+        uint32_t    rv{b1 & 0x1F};
+
+        for (int i = 0; i < 3; ++i)
+            rv = rv << 8 | read_byte();
+        return rv;
+    }
+
+    throw std::runtime_error("Malformed CLI signature: invalid compressed integer");
+}
+
+int32_t PeCliSignatureReader::read_compressed_signed()
+{
+    // The value is rotated left by one bit within the width of its encoding,
+    // so the sign bit is stored in bit zero.
+    const size_t    start{_pos};
+    const uint32_t  value{read_compressed_unsigned()};
+    const size_t    length{_pos - start};
+    const int32_t   magnitude{static_cast<int32_t>(value >> 1)};
+
+    if ((value & 1) == 0)
+        return magnitude;
+
+    switch (length)
+    {
+        case 1:
+            return magnitude - 0x40;
+        case 2:
+            return magnitude - 0x2000;
+        default:
+            return magnitude - 0x10000000;
+    }
+}
+
+PeCliMetadataTableIndex PeCliSignatureReader::read_type_def_or_ref()
+{
+    return PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::TypeDefOrRef, read_compressed_unsigned());
+}
+
+size_t decode_signature(BytesView signature, PeCliSignatureVisitor &visitor)
+{
+    return SignatureDecoder{signature, visitor}.decode_signature();
+}
+
+size_t decode_type_spec(BytesView signature, PeCliSignatureVisitor &visitor)
+{
+    return SignatureDecoder{signature, visitor}.decode_type_spec();
+}
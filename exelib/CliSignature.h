@@ -0,0 +1,227 @@
+/// \file   CliSignature.h
+/// Provides a decoder for the signatures stored in the \#Blob heap of CLI
+/// metadata: method, field, property, local variable, method specification,
+/// and type specification signatures, as described in ECMA-335, section II.23.2.
+///
+/// The decoder reads directly from a view of the blob and reports what it
+/// finds to a visitor. It never allocates memory.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLISIGNATURE_H_
+#define _EXELIB_CLISIGNATURE_H_
+
+#include <cstdint>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Values of the first byte of a signature.
+///
+/// The low four bits hold the calling convention or the kind of signature;
+/// the high bits are flags.
+enum class PeCliCallingConvention : uint8_t
+{
+    Default         = 0x00,
+    C               = 0x01,
+    StdCall         = 0x02,
+    ThisCall        = 0x03,
+    FastCall        = 0x04,
+    VarArg          = 0x05,
+    FieldSig        = 0x06,     ///< The signature is a field signature
+    LocalSig        = 0x07,     ///< The signature is a local variable signature
+    PropertySig     = 0x08,     ///< The signature is a property signature
+    Unmanaged       = 0x09,
+    GenericInstSig  = 0x0A,     ///< The signature is a method specification
+    NativeVarArg    = 0x0B,
+    KindMask        = 0x0F,     ///< Mask of the bits holding the calling convention or signature kind
+
+    Generic         = 0x10,     ///< The method has generic parameters
+    HasThis         = 0x20,     ///< The method or property has a \c this pointer
+    ExplicitThis    = 0x40      ///< The \c this pointer is explicitly among the parameters
+};
+
+/// \brief  Reads the primitive items of a signature: bytes, compressed
+///         integers, and compressed type tokens.
+///
+/// A \c std::runtime_error exception is thrown by any function that would
+/// read past the end of the signature, or that finds an invalid encoding.
+class PeCliSignatureReader
+{
+public:
+    /// \brief  Construct a reader to read the items in \p signature.
+    explicit PeCliSignatureReader(BytesView signature) noexcept
+      : _bytes{signature}
+    {}
+
+    /// \brief  Return \c true if the entire signature has been read.
+    bool at_end() const noexcept
+    {
+        return _pos >= _bytes.size();
+    }
+
+    /// \brief  Return the offset of the next byte to be read.
+    size_t position() const noexcept
+    {
+        return _pos;
+    }
+
+    /// \brief  Return a view of the bytes not yet read.
+    BytesView remaining() const noexcept
+    {
+        return _bytes.subview(_pos);
+    }
+
+    /// \brief  Return the next byte without consuming it.
+    uint8_t peek() const;
+
+    /// \brief  Read one byte.
+    uint8_t read_byte();
+
+    /// \brief  Read a compressed unsigned integer. ECMA-335, section II.23.2.
+    uint32_t read_compressed_unsigned();
+
+    /// \brief  Read a compressed signed integer. ECMA-335, section II.23.2.
+    int32_t read_compressed_signed();
+
+    /// \brief  Read a TypeDefOrRefOrSpecEncoded token and split it into a
+    ///         table identifier and row index. ECMA-335, section II.23.2.8.
+    PeCliMetadataTableIndex read_type_def_or_ref();
+
+private:
+    BytesView   _bytes;
+    size_t      _pos{0};
+};
+
+/// \brief  Receives the items of a decoded signature.
+///
+/// Each function is called as the corresponding item is reached, in the
+/// order the items are encoded. The default implementations do nothing, so
+/// a visitor needs to override only the functions it is interested in.
+///
+/// A type is reported as a sequence of calls. Custom modifiers come first.
+/// Then element_type() is called for a primitive type, or for one of the
+/// prefixes Ptr, ByRef, SzArray, Pinned, Array and FnPtr. Each prefix is
+/// followed by the type it applies to. For FnPtr that type is a method
+/// signature, and for Array it is followed by array_shape().
+class PeCliSignatureVisitor
+{
+public:
+    virtual ~PeCliSignatureVisitor() = default;
+
+    /// \brief  Start of a method or property signature, including the
+    ///         signature of a function pointer type.
+    /// \param calling_convention   The first byte of the signature.
+    /// \param generic_parameter_count  Number of generic parameters; zero if the method is not generic.
+    /// \param parameter_count  Number of parameters, not counting the return type.
+    virtual void begin_method(uint8_t /*calling_convention*/, uint32_t /*generic_parameter_count*/, uint32_t /*parameter_count*/)
+    {}
+
+    /// \brief  The next type is the return type of a method, or the type of a property.
+    virtual void return_type()
+    {}
+
+    /// \brief  The next type is the parameter with the given zero-based index.
+    virtual void parameter(uint32_t /*index*/)
+    {}
+
+    /// \brief  The remaining parameters are the variable arguments of a vararg call site.
+    virtual void sentinel()
+    {}
+
+    /// \brief  End of a method or property signature.
+    virtual void end_method()
+    {}
+
+    /// \brief  The next type is the type of a field.
+    virtual void field()
+    {}
+
+    /// \brief  Start of a local variable signature.
+    virtual void begin_locals(uint32_t /*count*/)
+    {}
+
+    /// \brief  The next type is the local variable with the given zero-based index.
+    virtual void local(uint32_t /*index*/)
+    {}
+
+    /// \brief  End of a local variable signature.
+    virtual void end_locals()
+    {}
+
+    /// \brief  Start of the generic arguments of a method specification.
+    virtual void begin_method_spec(uint32_t /*argument_count*/)
+    {}
+
+    /// \brief  The next type is the generic argument with the given zero-based index.
+    virtual void generic_argument(uint32_t /*index*/)
+    {}
+
+    /// \brief  End of a method specification.
+    virtual void end_method_spec()
+    {}
+
+    /// \brief  A custom modifier applying to the type that follows.
+    /// \param required \c true for a required modifier (modreq), \c false for an optional one (modopt).
+    /// \param type     The modifier type.
+    virtual void custom_modifier(bool /*required*/, PeCliMetadataTableIndex /*type*/)
+    {}
+
+    /// \brief  A primitive type, or a prefix modifying the type that follows.
+    virtual void element_type(PeCliMetadataElementType /*type*/)
+    {}
+
+    /// \brief  A class or value type.
+    /// \param kind Either PeCliMetadataElementType::Class or PeCliMetadataElementType::ValueType.
+    /// \param type The TypeDef, TypeRef, or TypeSpec row.
+    virtual void type_reference(PeCliMetadataElementType /*kind*/, PeCliMetadataTableIndex /*type*/)
+    {}
+
+    /// \brief  A generic parameter.
+    /// \param kind     PeCliMetadataElementType::Var for a type parameter,
+    ///                 PeCliMetadataElementType::MVar for a method parameter.
+    /// \param number   The zero-based number of the parameter.
+    virtual void generic_parameter(PeCliMetadataElementType /*kind*/, uint32_t /*number*/)
+    {}
+
+    /// \brief  Start of a generic type instantiation, which is followed by
+    ///         \p argument_count types.
+    virtual void begin_generic_instance(PeCliMetadataElementType /*kind*/, PeCliMetadataTableIndex /*type*/, uint32_t /*argument_count*/)
+    {}
+
+    /// \brief  End of a generic type instantiation.
+    virtual void end_generic_instance()
+    {}
+
+    /// \brief  The shape of an array, following its element type.
+    /// \param rank         Number of dimensions.
+    /// \param shape        A reader positioned at the sizes and lower bounds:
+    ///                     a compressed count followed by that many compressed
+    ///                     unsigned sizes, then a compressed count followed by
+    ///                     that many compressed signed lower bounds. The
+    ///                     visitor may read them or ignore them.
+    virtual void array_shape(uint32_t /*rank*/, PeCliSignatureReader /*shape*/)
+    {}
+};
+
+/// \brief  Decode a method, field, property, local variable, or method
+///         specification signature.
+/// \param signature    The signature blob, such as the view returned by
+///                     PeCliMetadata::get_blob_view for the signature column
+///                     of a MethodDef, MemberRef, Field, Property, StandAloneSig,
+///                     or MethodSpec row.
+/// \param visitor      Receives the items of the signature.
+/// \return The number of bytes decoded.
+///
+/// A \c std::runtime_error exception is thrown if the signature is malformed.
+size_t decode_signature(BytesView signature, PeCliSignatureVisitor &visitor);
+
+/// \brief  Decode the signature of a TypeSpec row, which consists of a single type.
+/// \return The number of bytes decoded.
+///
+/// A \c std::runtime_error exception is thrown if the signature is malformed.
+size_t decode_type_spec(BytesView signature, PeCliSignatureVisitor &visitor);
+
+#endif  //_EXELIB_CLISIGNATURE_H_
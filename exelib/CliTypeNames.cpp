@@ -0,0 +1,189 @@
+/// \file   CliTypeNames.cpp
+/// Implementation of the PeCliTypeNameIndex class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CliRelations.h"
+#include "CliTypeNames.h"
+
+namespace {
+
+// Nesting chains longer than this can only come from a cycle in
+// malformed metadata; the chain is cut off there.
+constexpr size_t max_nesting{64};
+
+// The position of a name within the buffer.
+struct Span
+{
+    size_t  offset;
+    size_t  size;
+};
+
+void append(std::string &buffer, StringView str)
+{
+    buffer.append(str.data(), str.size());
+}
+
+// Append a fully-qualified name to the buffer. The chain holds the row
+// numbers of the type and its enclosing types, innermost first.
+template<typename Row>
+Span append_name(std::string &buffer, const PeCliMetadata &metadata, const PeCliMetadataTableView<Row> &table, const std::vector<uint32_t> &chain)
+{
+    const Span  rv{buffer.size(), 0};
+
+    for (size_t i = chain.size(); i-- > 0; )
+    {
+        const auto  row{table.row(chain[i] - 1)};
+
+        if (i == chain.size() - 1)
+        {
+            const auto  name_space{metadata.get_string_view(row.type_namespace)};
+
+            if (!name_space.empty())
+            {
+                append(buffer, name_space);
+                buffer.push_back('.');
+            }
+        }
+        else
+        {
+            buffer.push_back('+');
+        }
+        append(buffer, metadata.get_string_view(row.type_name));
+    }
+
+    return {rv.offset, buffer.size() - rv.offset};
+}
+
+// Return the row number of the TypeRef enclosing the TypeRef in row \p row,
+// or zero if it has none. A resolution scope that cannot be decoded is
+// treated as having no enclosing type, so one malformed row does not
+// prevent the rest of the index from being built.
+uint32_t enclosing_type_ref(const PeCliMetadataTableView<PeCliMetadataRowTypeRef> &type_refs, uint32_t row)
+{
+    try
+    {
+        const auto  scope{PeCliMetadataSchema::decode_index(PeCliEncodedIndexType::ResolutionScope,
+                                                            type_refs.row(row - 1).resolution_scope)};
+
+        return scope.table_id == PeCliMetadataTableId::TypeRef ? scope.index : 0;
+    }
+    catch (const std::runtime_error &)
+    {
+        return 0;
+    }
+}
+
+}   // anonymous namespace
+
+
+PeCliTypeNameIndex::PeCliTypeNameIndex(const PeCliMetadata &metadata)
+{
+    const auto *tables{metadata.metadata_tables()};
+
+    if (tables == nullptr || metadata.stream(PeCliStreamId::Strings).empty())
+        return;
+
+    const auto          type_defs{tables->table<PeCliMetadataRowTypeDef>()};
+    const auto          type_refs{tables->table<PeCliMetadataRowTypeRef>()};
+    const auto         &relations{tables->relations()};
+    std::vector<Span>   def_spans;
+    std::vector<Span>   ref_spans;
+    std::vector<uint32_t> chain;
+
+    def_spans.reserve(type_defs.size());
+    for (uint32_t row = 1; row <= type_defs.size(); ++row)
+    {
+        chain.clear();
+        for (auto type = row; type != 0 && chain.size() < max_nesting; type = relations.enclosing_class(type))
+            chain.push_back(type);
+
+        def_spans.push_back(append_name(_buffer, metadata, type_defs, chain));
+    }
+
+    // A TypeRef to a nested type has the TypeRef of its enclosing type as its resolution scope.
+    ref_spans.reserve(type_refs.size());
+    for (uint32_t row = 1; row <= type_refs.size(); ++row)
+    {
+        chain.clear();
+        for (auto type = row; type != 0 && type <= type_refs.size() && chain.size() < max_nesting; type = enclosing_type_ref(type_refs, type))
+            chain.push_back(type);
+
+        ref_spans.push_back(append_name(_buffer, metadata, type_refs, chain));
+    }
+
+    // The buffer is complete, so views of it remain valid from here on.
+    _type_def_names.reserve(def_spans.size());
+    _type_defs.reserve(def_spans.size());
+    for (const auto &span : def_spans)
+    {
+        _type_def_names.emplace_back(_buffer.data() + span.offset, span.size);
+        _type_defs.emplace(_type_def_names.back(),
+                           PeCliMetadataTableIndex{PeCliMetadataTableId::TypeDef, static_cast<uint32_t>(_type_def_names.size())}.token());
+    }
+
+    _type_ref_names.reserve(ref_spans.size());
+    for (const auto &span : ref_spans)
+        _type_ref_names.emplace_back(_buffer.data() + span.offset, span.size);
+
+    // Rows are added last to first, so the map holds the first row with
+    // each name, and each row links to the next one with the same name.
+    _type_refs.reserve(ref_spans.size());
+    _next_type_ref.resize(ref_spans.size());
+    for (auto row = static_cast<uint32_t>(_type_ref_names.size()); row > 0; --row)
+    {
+        const auto  token{PeCliMetadataTableIndex{PeCliMetadataTableId::TypeRef, row}.token()};
+        const auto  inserted{_type_refs.emplace(_type_ref_names[row - 1], token)};
+
+        if (!inserted.second)
+        {
+            _next_type_ref[row - 1] = PeCliMetadataTableIndex::from_token(inserted.first->second).index;
+            inserted.first->second = token;
+        }
+    }
+}
+
+uint32_t PeCliTypeNameIndex::find_type_def(StringView name) const noexcept
+{
+    const auto  it{_type_defs.find(name)};
+
+    return it == _type_defs.end() ? 0 : it->second;
+}
+
+uint32_t PeCliTypeNameIndex::find_type_ref(StringView name) const noexcept
+{
+    const auto  it{_type_refs.find(name)};
+
+    return it == _type_refs.end() ? 0 : it->second;
+}
+
+std::vector<uint32_t> PeCliTypeNameIndex::find_type_refs(StringView name) const
+{
+    std::vector<uint32_t>   rv;
+
+    for (auto row = PeCliMetadataTableIndex::from_token(find_type_ref(name)).index; row != 0; row = _next_type_ref[row - 1])
+        rv.push_back(PeCliMetadataTableIndex{PeCliMetadataTableId::TypeRef, row}.token());
+
+    return rv;
+}
+
+StringView PeCliTypeNameIndex::name(uint32_t token) const noexcept
+{
+    const auto  index{PeCliMetadataTableIndex::from_token(token)};
+    const std::vector<StringView>  *names{nullptr};
+
+    if (index.table_id == PeCliMetadataTableId::TypeDef)
+        names = &_type_def_names;
+    else if (index.table_id == PeCliMetadataTableId::TypeRef)
+        names = &_type_ref_names;
+
+    if (names == nullptr || index.index == 0 || index.index > names->size())
+        return {};
+
+    return (*names)[index.index - 1];
+}
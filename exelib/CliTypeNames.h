@@ -0,0 +1,112 @@
+/// \file   CliTypeNames.h
+/// Provides an index of the fully-qualified names of the types defined and
+/// referenced by CLI metadata.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_CLITYPENAMES_H_
+#define _EXELIB_CLITYPENAMES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Maps the fully-qualified names of TypeDef and TypeRef rows to
+///         their metadata tokens, and tokens to names.
+///
+/// A fully-qualified name is the namespace and the name joined by a period,
+/// as in \c System.Collections.Generic.List`1. A nested type's name is its
+/// enclosing type's fully-qualified name and its own name joined by a plus
+/// sign, as in \c System.Environment+SpecialFolder, the form used by
+/// reflection.
+///
+/// The names are built once, when the index is constructed, and held in a
+/// single buffer; the views returned by name() refer to that buffer and
+/// are valid for as long as the index.
+///
+/// The index is not modified after construction, so it may be used
+/// concurrently from several threads.
+class PeCliTypeNameIndex
+{
+public:
+    /// \brief  Build the index of the types in \p metadata.
+    ///
+    /// The index is empty if the metadata tables or the \#Strings heap
+    /// were not loaded.
+    explicit PeCliTypeNameIndex(const PeCliMetadata &metadata);
+
+    PeCliTypeNameIndex(const PeCliTypeNameIndex &) = delete;
+    PeCliTypeNameIndex &operator=(const PeCliTypeNameIndex &) = delete;
+
+    /// \brief  Return the token of the TypeDef with the given name, or zero if there is none.
+    uint32_t find_type_def(StringView name) const noexcept;
+
+    /// \brief  Return the token of a TypeRef with the given name, or zero if there is none.
+    ///
+    /// If several TypeRef rows have the name, as when the same name is
+    /// referenced in more than one assembly, the first is returned.
+    uint32_t find_type_ref(StringView name) const noexcept;
+
+    /// \brief  Return the tokens of every TypeRef with the given name, in table order.
+    std::vector<uint32_t> find_type_refs(StringView name) const;
+
+    /// \brief  Return the token of the TypeDef with the given name or, if
+    ///         there is none, of a TypeRef with the name. Returns zero if
+    ///         neither exists.
+    uint32_t find(StringView name) const noexcept
+    {
+        const auto  rv{find_type_def(name)};
+
+        return rv ? rv : find_type_ref(name);
+    }
+
+    /// \brief  Return the fully-qualified name of a TypeDef or TypeRef.
+    ///
+    /// The view is empty if \p token does not identify a TypeDef or TypeRef row.
+    StringView name(uint32_t token) const noexcept;
+
+    /// \brief  Return the number of TypeDef rows indexed.
+    size_t type_def_count() const noexcept
+    {
+        return _type_def_names.size();
+    }
+
+    /// \brief  Return the number of TypeRef rows indexed.
+    size_t type_ref_count() const noexcept
+    {
+        return _type_ref_names.size();
+    }
+
+private:
+    // FNV-1a, which is quick on the short strings that type names are.
+    struct Hash
+    {
+        size_t operator()(StringView str) const noexcept
+        {
+            uint32_t    hash{2166136261u};
+
+            for (auto ch : str)
+                hash = (hash ^ static_cast<uint8_t>(ch)) * 16777619u;
+
+            return hash;
+        }
+    };
+
+    using Map = std::unordered_map<StringView, uint32_t, Hash>;
+
+    std::string             _buffer;            // every name, one after another
+    std::vector<StringView> _type_def_names;    // indexed by row number - 1
+    std::vector<StringView> _type_ref_names;    // indexed by row number - 1
+    std::vector<uint32_t>   _next_type_ref;     // indexed by row number - 1; the next row with the same name, or zero
+    Map                     _type_defs;
+    Map                     _type_refs;
+};
+
+#endif  //_EXELIB_CLITYPENAMES_H_
@@ -11,6 +11,7 @@
 #include <memory>
 #include <vector>
 
+#include "FuzzyHash.h"
 #include "LoadOptions.h"
 #include "MZExe.h"
 #include "NEExe.h"
@@ -60,6 +61,7 @@ public:
             _mz_info = std::move(other._mz_info);
             _ne_info = std::move(other._ne_info);
             _pe_info = std::move(other._pe_info);
+            _fuzzy_hashes = std::move(other._fuzzy_hashes);
 
             other._type = ExeType::Unknown;
         }
@@ -76,6 +78,21 @@ public:
         load(stream, options);
     }
 
+    /// \brief  Construct an \c ExeInfo object from a stream, sharing its raw data through a store.
+    /// \param stream   An \c std::istream instance from which to read.
+    ///                 The stream must have been opened using binary mode.
+    /// \param options  Flags indicating what portions of the file to load.
+    /// \param store    A store holding one copy of each distinct section, segment,
+    ///                 and CLI metadata stream. See #share_data().
+    ///
+    /// This is the safe way to share data: the data is shared before the
+    /// object is returned, so no view of it can have been taken yet.
+    ExeInfo(std::istream &stream, LoadOptions::Options options, BlobStore &store)
+    {
+        load(stream, options);
+        share_data(store);
+    }
+
     /// \brief  Load an \c ExeInfo object from a stream.
     /// \param stream   An \c std::istream instance from which to read.
     ///                 The stream must have been opened using binary mode.
@@ -119,6 +136,9 @@ public:
                 _type = ExeType::Unknown;
             }
         }
+
+        if (options & LoadOptions::ComputeFuzzyHashes)
+            load_fuzzy_hashes(stream);
     }
     /// \brief  Return a value indicating the type of executable, such as MZ, NE, PE, etc.
     /// \return An \c ExeType enumeration.
@@ -155,11 +175,78 @@ public:
         return _pe_info.get();
     }
 
+    /// \brief  Share the loaded raw data through a content-addressed store.
+    ///
+    /// The raw data of each PE section and NE segment, and each CLI metadata
+    /// stream, is replaced by the store's copy of identical data if it has
+    /// one, and otherwise added to the store. Executables sharing a store
+    /// then hold only one copy of each distinct piece of data.
+    ///
+    /// \note   Replacing the data frees this object's own copy of it, so
+    ///         every view taken of the data beforehand is left dangling.
+    ///         That includes the StringView and BytesView objects from
+    ///         PeCliMetadata::get_string_view() and get_blob_view(), heap
+    ///         iterators and entries, table views, and the results of
+    ///         get_managed_resources(), get_method_body(), and PeReadyToRun.
+    ///         Call this before taking any views, or construct the object
+    ///         with a store instead.
+    void share_data(BlobStore &store)
+    {
+        if (_ne_info)
+            _ne_info->share_data(store);
+        if (_pe_info)
+            _pe_info->share_data(store);
+    }
+
+    /// \brief  Return a pointer to the fuzzy hashes of the file, if they were computed.
+    ///
+    /// The hashes are computed only if the LoadOptions::ComputeFuzzyHashes
+    /// option was specified, so the returned pointer may be null.
+    const FuzzyHashes *fuzzy_hashes() const noexcept
+    {
+        return _fuzzy_hashes.get();
+    }
+
 private:
-    ExeType                     _type{ExeType::Unknown};    // the type of the executable: MZ, NE, PE, etc.
-    std::unique_ptr<MzExeInfo>  _mz_info;   // MZ part, used with all executables.
-    std::unique_ptr<NeExeInfo>  _ne_info;   // "New" NE part. Might not exist, particularly for modern PE-style or old MS-DOS executables.
-    std::unique_ptr<PeExeInfo>  _pe_info;   // Newer PE part. Might not exist, if the executable is old or REALLY old.
+    void load_fuzzy_hashes(std::istream &stream)
+    {
+        std::vector<FileRange>          ranges;
+        std::vector<LoadedFileRange>    loaded;
+
+        if (_pe_info)
+        {
+            for (const auto &section : _pe_info->sections())
+            {
+                const auto &header{section.header()};
+
+                ranges.push_back(FileRange{header.raw_data_position,
+                                           header.raw_data_position ? section.raw_data_size() : 0u});
+                if (header.raw_data_position && !section.data().empty())
+                    loaded.push_back(LoadedFileRange{header.raw_data_position, section.data().data(), section.data().size()});
+            }
+        }
+        else if (_ne_info)
+        {
+            for (const auto &segment : _ne_info->segment_table())
+            {
+                uint64_t    position{static_cast<uint64_t>(segment.sector) << _ne_info->align_shift_count()};
+
+                ranges.push_back(FileRange{position, segment.sector ? (segment.length ? segment.length : 65536u) : 0u});
+                if (segment.sector && !segment.data.empty())
+                    loaded.push_back(LoadedFileRange{position, segment.data.data(), segment.data.size()});
+            }
+        }
+
+        // Section and segment data the loaders have already read is hashed
+        // from memory; only the bytes outside it are read from the stream.
+        _fuzzy_hashes = std::make_unique<FuzzyHashes>(compute_fuzzy_hashes(stream, ranges, std::move(loaded)));
+    }
+
+    ExeType                         _type{ExeType::Unknown};    // the type of the executable: MZ, NE, PE, etc.
+    std::unique_ptr<MzExeInfo>      _mz_info;   // MZ part, used with all executables.
+    std::unique_ptr<NeExeInfo>      _ne_info;   // "New" NE part. Might not exist, particularly for modern PE-style or old MS-DOS executables.
+    std::unique_ptr<PeExeInfo>      _pe_info;   // Newer PE part. Might not exist, if the executable is old or REALLY old.
+    std::unique_ptr<FuzzyHashes>    _fuzzy_hashes;  // Fuzzy hashes of the file and its parts. Only computed if requested.
 };
 
 #endif  // _EXELIB_EXEINFO_H_
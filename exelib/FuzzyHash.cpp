@@ -0,0 +1,469 @@
+/// \file   FuzzyHash.cpp
+/// Implementation of the streaming fuzzy hash classes.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "FuzzyHash.h"
+
+namespace {
+
+// Constants for the context-triggered piecewise hash.
+constexpr uint32_t  min_block_size{3};
+constexpr uint32_t  hash_prime{0x01000193};
+constexpr uint32_t  hash_init{0x28021967};
+
+const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline uint32_t block_size(uint32_t index) noexcept
+{
+    return min_block_size << index;
+}
+
+inline uint32_t sum_hash(uint8_t c, uint32_t h) noexcept
+{
+    return (h * hash_prime) ^ c;
+}
+
+// Pearson permutation used by the locality-sensitive hash.
+const uint8_t   pearson_table[256] =
+{
+      1,  87,  49,  12, 176, 178, 102, 166, 121, 193,   6,  84, 249, 230,  44, 163,
+     14, 197, 213, 181, 161,  85, 218,  80,  64, 239,  24, 226, 236, 142,  38, 200,
+    110, 177, 104, 103, 141, 253, 255,  50,  77, 101,  81,  18,  45,  96,  31, 222,
+     25, 107, 190,  70,  86, 237, 240,  34,  72, 242,  20, 214, 244, 227, 149, 235,
+     97, 234,  57,  22,  60, 250,  82, 175, 208,   5, 127, 199, 111,  62, 135, 248,
+    174, 169, 211,  58,  66, 154, 106, 195, 245, 171,  17, 187, 182, 179,   0, 243,
+    132,  56, 148,  75, 128, 133, 158, 100, 130, 126,  91,  13, 153, 246, 216, 219,
+    119,  68, 223,  78,  83,  88, 201,  99, 122,  11,  92,  32, 136, 114,  52,  10,
+    138,  30,  48, 183, 156,  35,  61,  26, 143,  74, 251,  94, 129, 162,  63, 152,
+    170,   7, 115, 167, 241, 206,   3, 150,  55,  59, 151, 220,  90,  53,  23, 131,
+    125, 173,  15, 238,  79,  95,  89,  16, 105, 137, 225, 224, 217, 160,  37, 123,
+    118,  73,   2, 157,  46, 116,   9, 145, 134, 228, 207, 212, 202, 215,  69, 229,
+     27, 188,  67, 124, 168, 252,  42,   4,  29, 108,  21, 247,  19, 205,  39, 203,
+    233,  40, 186, 147, 198, 192, 155,  33, 164, 191,  98, 204, 165, 180, 117,  76,
+    140,  36, 210, 172,  41,  54, 159,   8, 185, 232, 113, 196, 231,  47, 146, 120,
+     51,  65,  28, 144, 254, 221,  93, 189, 194, 139, 112,  43,  71, 109, 184, 209
+};
+
+inline uint8_t pearson_hash(uint8_t salt, uint8_t i, uint8_t j, uint8_t k) noexcept
+{
+    uint8_t h{pearson_table[salt]};
+
+    h = pearson_table[h ^ i];
+    h = pearson_table[h ^ j];
+    return pearson_table[h ^ k];
+}
+
+// Map the data length logarithmically into a single byte.
+uint8_t length_capture(uint64_t length)
+{
+    double  log_length{std::log(static_cast<float>(length))};
+    int     rv;
+
+    if (length <= 656)
+        rv = static_cast<int>(std::floor(log_length / 0.4054651));
+    else if (length <= 3199)
+        rv = static_cast<int>(std::floor(log_length / 0.26236426 - 8.72777));
+    else
+        rv = static_cast<int>(std::floor(log_length / 0.095310180 - 62.5472));
+
+    return static_cast<uint8_t>(rv & 0xFF);
+}
+
+inline uint8_t swap_nibbles(uint8_t value) noexcept
+{
+    return static_cast<uint8_t>((value >> 4) | (value << 4));
+}
+
+void append_hex(std::string &str, uint8_t value)
+{
+    static const char   digits[] = "0123456789ABCDEF";
+
+    str += digits[value >> 4];
+    str += digits[value & 0x0F];
+}
+
+}   // anonymous namespace
+
+
+//
+// CtphHasher
+//
+CtphHasher::CtphHasher() noexcept
+  : _window{},
+    _h1{0},
+    _h2{0},
+    _h3{0},
+    _n{0},
+    _start{0},
+    _end{1},
+    _need_last_h{false},
+    _last_h{0},
+    _total_size{0}
+{
+    _block_hashes[0].h = hash_init;
+    _block_hashes[0].half_h = hash_init;
+    _block_hashes[0].digest[0] = '\0';
+    _block_hashes[0].half_digest = '\0';
+    _block_hashes[0].length = 0;
+}
+
+void CtphHasher::fork_block_hash() noexcept
+{
+    const auto &old_hash{_block_hashes[_end - 1]};
+
+    if (_end < max_block_hashes)
+    {
+        auto   &new_hash{_block_hashes[_end]};
+
+        new_hash.h = old_hash.h;
+        new_hash.half_h = old_hash.half_h;
+        new_hash.digest[0] = '\0';
+        new_hash.half_digest = '\0';
+        new_hash.length = 0;
+        ++_end;
+    }
+    else if (!_need_last_h)
+    {
+        _need_last_h = true;
+        _last_h = old_hash.h;
+    }
+}
+
+void CtphHasher::reduce_block_hash() noexcept
+{
+    // Stop tracking the smallest block size once it can no longer be chosen.
+    if (_end - _start < 2)
+        return;
+    if (static_cast<uint64_t>(block_size(_start)) * digest_length >= _total_size)
+        return;
+    if (_block_hashes[_start + 1].length < digest_length / 2)
+        return;
+
+    ++_start;
+}
+
+void CtphHasher::update(const uint8_t *data, size_t size) noexcept
+{
+    for (const uint8_t *end = data + size; data < end; ++data)
+    {
+        uint8_t c{*data};
+
+        ++_total_size;
+
+        // Update the rolling hash.
+        _h2 -= _h1;
+        _h2 += static_cast<uint32_t>(window_size) * c;
+        _h1 += c;
+        _h1 -= _window[_n % window_size];
+        _window[_n % window_size] = c;
+        ++_n;
+        _h3 <<= 5;
+        _h3 ^= c;
+
+        uint32_t    h{_h1 + _h2 + _h3};
+
+        for (uint32_t i = _start; i < _end; ++i)
+        {
+            _block_hashes[i].h = sum_hash(c, _block_hashes[i].h);
+            _block_hashes[i].half_h = sum_hash(c, _block_hashes[i].half_h);
+        }
+        if (_need_last_h)
+            _last_h = sum_hash(c, _last_h);
+
+        // A trigger point for one block size is a trigger point for every
+        // smaller block size too, so stop at the first that doesn't trigger.
+        if (h == 0 || h % min_block_size != min_block_size - 1)
+            continue;
+
+        for (uint32_t i = _start; i < _end; ++i)
+        {
+            auto   &block_hash{_block_hashes[i]};
+
+            if (h % block_size(i) != block_size(i) - 1)
+                break;
+
+            if (block_hash.length == 0)
+                fork_block_hash();
+
+            block_hash.digest[block_hash.length] = base64[block_hash.h % 64];
+            block_hash.half_digest = base64[block_hash.half_h % 64];
+            if (block_hash.length < digest_length - 1)
+            {
+                block_hash.digest[++block_hash.length] = '\0';
+                block_hash.h = hash_init;
+                if (block_hash.length < digest_length / 2)
+                    block_hash.half_h = hash_init;
+            }
+            else
+            {
+                reduce_block_hash();
+            }
+        }
+    }
+}
+
+std::string CtphHasher::digest() const
+{
+    uint32_t    index{_start};
+    uint32_t    h{_h1 + _h2 + _h3};
+
+    // Choose the smallest block size giving a digest that is not too long,
+    // then back off to smaller ones if that digest turns out to be too short.
+    while (static_cast<uint64_t>(block_size(index)) * digest_length < _total_size && index + 1 < max_block_hashes)
+        ++index;
+    while (index >= _end)
+        --index;
+    while (index > _start && _block_hashes[index].length < digest_length / 2)
+        --index;
+
+    std::string rv{std::to_string(block_size(index))};
+    const auto &first{_block_hashes[index]};
+
+    rv += ':';
+    rv.append(first.digest, first.length);
+    if (h != 0)
+        rv += base64[first.h % 64];
+    else if (first.length < digest_length && first.digest[first.length] != '\0')
+        rv += first.digest[first.length];
+    rv += ':';
+
+    if (index + 1 < _end)
+    {
+        const auto &second{_block_hashes[index + 1]};
+        uint32_t    length{std::min<uint32_t>(second.length, digest_length / 2 - 1)};
+
+        rv.append(second.digest, length);
+        if (h != 0)
+            rv += base64[second.half_h % 64];
+        else if (second.half_digest != '\0')
+            rv += second.half_digest;
+    }
+    else if (h != 0)
+    {
+        rv += base64[(index == 0 ? first.h : _last_h) % 64];
+    }
+
+    return rv;
+}
+
+
+//
+// TlshHasher
+//
+TlshHasher::TlshHasher() noexcept
+  : _buckets{},
+    _window{},
+    _checksum{0},
+    _length{0}
+{}
+
+void TlshHasher::update(const uint8_t *data, size_t size) noexcept
+{
+    for (const uint8_t *end = data + size; data < end; ++data, ++_length)
+    {
+        size_t  j{static_cast<size_t>(_length % window_size)};
+
+        _window[j] = *data;
+        if (_length < window_size - 1)
+            continue;
+
+        const uint8_t   a{_window[j]};
+        const uint8_t   b{_window[(j + 4) % window_size]};
+        const uint8_t   c{_window[(j + 3) % window_size]};
+        const uint8_t   d{_window[(j + 2) % window_size]};
+        const uint8_t   e{_window[(j + 1) % window_size]};
+
+        _checksum = pearson_hash(0, a, b, _checksum);
+
+        ++_buckets[pearson_hash(2, a, b, c)];
+        ++_buckets[pearson_hash(3, a, b, d)];
+        ++_buckets[pearson_hash(5, a, c, d)];
+        ++_buckets[pearson_hash(7, a, c, e)];
+        ++_buckets[pearson_hash(11, a, b, e)];
+        ++_buckets[pearson_hash(13, a, d, e)];
+    }
+}
+
+std::string TlshHasher::digest() const
+{
+    if (_length < min_data_length)
+        return {};
+
+    // Only the first bucket_count buckets contribute to the hash.
+    std::vector<uint32_t>   sorted(_buckets.begin(), _buckets.begin() + bucket_count);
+
+    if (std::count_if(sorted.begin(), sorted.end(), [](uint32_t n) { return n != 0; }) <= static_cast<ptrdiff_t>(bucket_count / 2))
+        return {};
+
+    std::sort(sorted.begin(), sorted.end());
+
+    const uint32_t  q1{sorted[bucket_count / 4 - 1]};
+    const uint32_t  q2{sorted[bucket_count / 2 - 1]};
+    const uint32_t  q3{sorted[bucket_count * 3 / 4 - 1]};
+
+    if (q3 == 0)
+        return {};
+
+    const uint8_t   q1_ratio{static_cast<uint8_t>(static_cast<uint32_t>(q1 * 100.0f / q3) % 16)};
+    const uint8_t   q2_ratio{static_cast<uint8_t>(static_cast<uint32_t>(q2 * 100.0f / q3) % 16)};
+
+    std::string rv{"T1"};
+
+    append_hex(rv, swap_nibbles(_checksum));
+    append_hex(rv, swap_nibbles(length_capture(_length)));
+    append_hex(rv, static_cast<uint8_t>((q1_ratio << 4) | q2_ratio));
+
+    // Each group of four buckets becomes one byte, two bits per bucket
+    // giving its quartile. The bytes are written last group first.
+    for (size_t i = bucket_count / 4; i-- > 0; )
+    {
+        uint8_t code{0};
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            uint32_t    count{_buckets[i * 4 + j]};
+
+            if (count > q3)
+                code |= 3 << (j * 2);
+            else if (count > q2)
+                code |= 2 << (j * 2);
+            else if (count > q1)
+                code |= 1 << (j * 2);
+        }
+
+        append_hex(rv, code);
+    }
+
+    return rv;
+}
+
+
+//
+// Whole-stream hashing
+//
+namespace {
+
+/// Feeds the bytes of a file, in file order, to the whole-file hasher
+/// and to the hasher of each range that the bytes overlap.
+class RangeFeeder
+{
+public:
+    explicit RangeFeeder(const std::vector<FileRange> &ranges)
+      : _ranges{ranges}
+      , _range_hashers(ranges.size())
+    {}
+
+    uint64_t position() const noexcept
+    {
+        return _position;
+    }
+
+    void feed(const uint8_t *data, uint64_t count) noexcept
+    {
+        _file_hasher.update(data, static_cast<size_t>(count));
+
+        for (size_t i = 0; i < _ranges.size(); ++i)
+        {
+            uint64_t    begin{std::max(_position, _ranges[i].offset)};
+            uint64_t    end{std::min(_position + count, _ranges[i].offset + _ranges[i].size)};
+
+            if (begin < end)
+                _range_hashers[i].update(data + (begin - _position), static_cast<size_t>(end - begin));
+        }
+
+        _position += count;
+    }
+
+    // Read and feed bytes from the stream up to, but not including,
+    // file offset \p limit, or to the end of the stream.
+    void feed_from(std::istream &stream, std::vector<char> &buffer, uint64_t limit)
+    {
+        stream.clear();
+        stream.seekg(static_cast<std::streamoff>(_position));
+
+        while (_position < limit && stream)
+        {
+            auto    wanted{std::min(static_cast<uint64_t>(buffer.size()), limit - _position)};
+
+            stream.read(buffer.data(), static_cast<std::streamsize>(wanted));
+
+            auto    count{static_cast<uint64_t>(stream.gcount())};
+
+            if (count == 0)
+                break;
+
+            feed(reinterpret_cast<const uint8_t *>(buffer.data()), count);
+        }
+    }
+
+    FuzzyHashes digests() const
+    {
+        FuzzyHashes rv;
+
+        rv.file = _file_hasher.digest();
+        rv.sections.reserve(_range_hashers.size());
+        for (const auto &hasher : _range_hashers)
+            rv.sections.push_back(hasher.digest());
+
+        return rv;
+    }
+
+private:
+    const std::vector<FileRange>   &_ranges;
+    FuzzyHasher                     _file_hasher;
+    std::vector<FuzzyHasher>        _range_hashers;
+    uint64_t                        _position{0};
+};
+
+}   // anonymous namespace
+
+FuzzyHashes compute_fuzzy_hashes(std::istream &stream,
+                                 const std::vector<FileRange> &ranges,
+                                 std::vector<LoadedFileRange> loaded)
+{
+    RangeFeeder         feeder{ranges};
+    std::vector<char>   buffer(64 * 1024);
+
+    // Loaded data may have been padded past a truncated end of file,
+    // so nothing beyond the stream's real size is taken from memory.
+    stream.clear();
+    stream.seekg(0, std::ios::end);
+
+    auto    end_pos{stream.tellg()};
+    auto    file_size{end_pos < 0 ? uint64_t{0} : static_cast<uint64_t>(end_pos)};
+
+    std::sort(loaded.begin(), loaded.end(),
+              [](const LoadedFileRange &a, const LoadedFileRange &b) { return a.offset < b.offset; });
+
+    for (const auto &range : loaded)
+    {
+        uint64_t    end{std::min(range.offset + range.size, file_size)};
+
+        if (end <= feeder.position())
+            continue;
+
+        // Read the gap, such as headers or padding, between the previous range and this one.
+        if (range.offset > feeder.position())
+            feeder.feed_from(stream, buffer, range.offset);
+
+        if (feeder.position() < range.offset)
+            break;  // the stream ended early
+
+        feeder.feed(range.data + (feeder.position() - range.offset), end - feeder.position());
+    }
+
+    // Read whatever follows the last loaded range, such as an overlay.
+    feeder.feed_from(stream, buffer, file_size);
+
+    stream.clear();
+
+    return feeder.digests();
+}
@@ -0,0 +1,159 @@
+/// \file   FuzzyHash.h
+/// Provides streaming similarity hashes: a context-triggered piecewise hash
+/// in the style of ssdeep, and a locality-sensitive hash in the style of TLSH.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_FUZZYHASH_H_
+#define _EXELIB_FUZZYHASH_H_
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+/// \brief  Computes a context-triggered piecewise hash (CTPH) in the style of ssdeep.
+///
+/// Data may be supplied in any number of pieces. Because the block size
+/// depends on the total length of the data, a hash is maintained for every
+/// candidate block size that could still be chosen, and the best is
+/// selected when the digest is produced.
+class CtphHasher
+{
+public:
+    CtphHasher() noexcept;
+
+    /// \brief  Add \p size bytes at \p data to the hash.
+    void update(const uint8_t *data, size_t size) noexcept;
+
+    /// \brief  Return the digest of the data added so far,
+    ///         in the form "blocksize:hash:hash".
+    std::string digest() const;
+
+private:
+    static constexpr size_t     window_size{7};
+    static constexpr size_t     digest_length{64};
+    static constexpr size_t     max_block_hashes{31};
+
+    struct BlockHash
+    {
+        uint32_t    h;
+        uint32_t    half_h;
+        char        digest[digest_length];
+        char        half_digest;
+        uint32_t    length;
+    };
+
+    void fork_block_hash() noexcept;
+    void reduce_block_hash() noexcept;
+
+    // the rolling hash over the last window_size bytes
+    uint8_t     _window[window_size];
+    uint32_t    _h1;
+    uint32_t    _h2;
+    uint32_t    _h3;
+    uint32_t    _n;
+
+    uint32_t    _start;         // index of the smallest block size still in the running
+    uint32_t    _end;           // one past the index of the largest block size started
+    bool        _need_last_h;   // true when all block hashes are in use
+    uint32_t    _last_h;
+    uint64_t    _total_size;
+
+    std::array<BlockHash, max_block_hashes> _block_hashes;
+};
+
+/// \brief  Computes a locality-sensitive hash in the style of TLSH,
+///         with 128 buckets and a one-byte checksum.
+class TlshHasher
+{
+public:
+    TlshHasher() noexcept;
+
+    /// \brief  Add \p size bytes at \p data to the hash.
+    void update(const uint8_t *data, size_t size) noexcept;
+
+    /// \brief  Return the digest of the data added so far, as 70 hex digits
+    ///         preceded by "T1". The digest is empty if there is too little
+    ///         data, or the data is too uniform, to produce a meaningful hash.
+    std::string digest() const;
+
+private:
+    static constexpr size_t     bucket_count{128};
+    static constexpr size_t     window_size{5};
+    static constexpr uint64_t   min_data_length{50};
+
+    std::array<uint32_t, 256>   _buckets;
+    uint8_t                     _window[window_size];
+    uint8_t                     _checksum;
+    uint64_t                    _length;
+};
+
+/// \brief  The fuzzy hashes of a single piece of data.
+struct FuzzyDigest
+{
+    std::string ctph;   ///< The ssdeep-style context-triggered piecewise hash.
+    std::string tlsh;   ///< The TLSH-style locality-sensitive hash; empty if it could not be computed.
+};
+
+/// \brief  Computes both fuzzy hashes in a single pass over the data.
+class FuzzyHasher
+{
+public:
+    /// \brief  Add \p size bytes at \p data to both hashes.
+    void update(const uint8_t *data, size_t size) noexcept
+    {
+        _ctph.update(data, size);
+        _tlsh.update(data, size);
+    }
+
+    /// \brief  Return the digests of the data added so far.
+    FuzzyDigest digest() const
+    {
+        return FuzzyDigest{_ctph.digest(), _tlsh.digest()};
+    }
+
+private:
+    CtphHasher  _ctph;
+    TlshHasher  _tlsh;
+};
+
+/// \brief  A range of bytes within a file.
+struct FileRange
+{
+    uint64_t    offset;     ///< File offset of the first byte of the range.
+    uint64_t    size;       ///< Number of bytes in the range.
+};
+
+/// \brief  A range of a file whose bytes have already been read into memory.
+struct LoadedFileRange
+{
+    uint64_t        offset;     ///< File offset of the first byte of the range.
+    const uint8_t  *data;       ///< The bytes of the range.
+    size_t          size;       ///< Number of bytes in the range.
+};
+
+/// \brief  The fuzzy hashes of an executable file and of its parts.
+struct FuzzyHashes
+{
+    FuzzyDigest                 file;       ///< Hashes of the entire file.
+    std::vector<FuzzyDigest>    sections;   ///< Hashes of each PE section's or NE segment's raw data, in table order.
+};
+
+/// \brief  Compute the fuzzy hashes of an entire stream and of ranges within it.
+/// \param stream   The stream to hash, opened in binary mode.
+/// \param ranges   Ranges of the stream, such as the raw data of each section,
+///                 to be hashed individually. Ranges may overlap.
+/// \param loaded   Ranges of the stream that have already been read into
+///                 memory, such as loaded section data. Their bytes are hashed
+///                 from memory; only the bytes outside them are read from
+///                 \p stream, sequentially.
+/// \return A FuzzyHashes structure with one entry in \c sections for each range.
+FuzzyHashes compute_fuzzy_hashes(std::istream &stream,
+                                 const std::vector<FileRange> &ranges,
+                                 std::vector<LoadedFileRange> loaded = {});
+
+#endif  //_EXELIB_FUZZYHASH_H_
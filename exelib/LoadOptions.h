@@ -27,8 +27,14 @@ public:
     static constexpr Options LoadCliMetadataStreams = 0x00E0;   ///< Load the CLI metadata tables from the CLI #~ heap. Implies loading CLI metadata.
     static constexpr Options LoadCliMetadataTables  = 0x01E0;   ///< Load the CLI metadata tables from the CLI #~ heap. Implies loading CLI metadata streams.
     static constexpr Options LoadAllCli             = 0x01E0;   ///< Load all the CLI information, including the metadata and tables.
-    static constexpr Options LoadAll                = 0xFFFF;   ///< Load all the data from an executable image.
+    static constexpr Options ComputeFuzzyHashes     = 0x0200;   ///< Compute fuzzy hashes of the file and of each PE section or NE segment.
+    static constexpr Options LoadCertificates       = 0x0400;   ///< Load the Attribute Certificate Table from PE files.
+    static constexpr Options LoadCliTablesConcurrently = 0x0800;    ///< Decode the CLI metadata tables on several threads. Applies only with LoadCliMetadataTables.
+    static constexpr Options LoadAll                = 0xFFFF & ~(ComputeFuzzyHashes | LoadCertificates | LoadCliTablesConcurrently);   ///< Load all the data from an executable image.
                                                                 //This value could change if more flags are added above.
+                                                                //Options that cost extra work, such as another pass over the
+                                                                //file or a pool of threads, are left out of LoadAll and must
+                                                                //be requested explicitly.
 };
 
 #endif  // _EXELIB_LOADOPTIONS_H_
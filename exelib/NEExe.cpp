@@ -32,8 +32,9 @@ void load_seg_table_entry(std::istream &stream, NeSegmentEntry &entry, uint16_t
             auto here = stream.tellg();
             stream.seekg(static_cast<std::streamsize>((entry.sector) << align_shift));
             std::streamsize size = entry.length ? entry.length : 65536;
-            entry.data.resize(static_cast<size_t>(size));
-            stream.read(reinterpret_cast<char *>(&entry.data[0]), size);
+            std::vector<uint8_t>    data(static_cast<size_t>(size));
+            stream.read(reinterpret_cast<char *>(&data[0]), size);
+            entry.data = SharedBytes{std::move(data)};
             stream.seekg(here);
         }
         entry.data_loaded = true;  // say we have data even if we didn't read anything.
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include "BlobStore.h"
 #include "LoadOptions.h"
 
 /// \brief  Describes the new NE-style header
@@ -182,7 +183,7 @@ struct NeSegmentEntry
     };
 
     bool                    data_loaded {false};
-    std::vector<uint8_t>    data;
+    SharedBytes             data;
 };
 
 /// \brief  Entry in the Resource sub-table. Describes a single resource.
@@ -357,6 +358,16 @@ public:
             return std::string();
     }
 
+    /// \brief  Replace the data of each segment with the copy held in
+    ///         \p store, adding it to the store if it is not already there.
+    ///
+    /// References to segment data taken beforehand may be left dangling.
+    void share_data(BlobStore &store)
+    {
+        for (auto &segment : _segment_table)
+            segment.data = store.intern(segment.data);
+    }
+
 private:
     std::streamoff  _header_position;   // absolute position in the file of the NE header. used for offset calculations
     uint16_t        _res_shift_count;   // shift count loaded from the Resource Table
@@ -231,6 +231,9 @@ PeExeInfo::PeExeInfo(std::istream &stream, size_t header_location, LoadOptions::
         load_cli(stream, options);
 
         load_resource_info(stream, options);
+
+        if (options & LoadOptions::LoadCertificates)
+            load_certificates(stream);
         //TODO: Load more here!!!
     }
     else
@@ -766,3 +769,68 @@ std::unique_ptr<PeResourceDataEntry> PeExeInfo::load_resource_data_entry(std::is
     stream.seekg(base + std::streamoff{offset});
     return resdata;
 }
+
+std::vector<PeCertificate> parse_certificate_table(BytesView table)
+{
+    std::vector<PeCertificate>  rv;
+    size_t                      pos{0};
+
+    while (table.size() - pos >= PeCertificate::header_size)
+    {
+        BytesReader     reader{table.subview(pos, PeCertificate::header_size)};
+        PeCertificate   entry;
+
+        reader.read(entry.length);
+        reader.read(entry.revision);
+        reader.read(entry.certificate_type);
+
+        if (entry.length < PeCertificate::header_size || entry.length > table.size() - pos)
+            break;
+
+        entry.certificate = table.subview(pos + PeCertificate::header_size, entry.length - PeCertificate::header_size);
+        rv.push_back(entry);
+
+        // each entry begins on an eight-byte boundary
+        pos += (static_cast<size_t>(entry.length) + 7) & ~static_cast<size_t>(7);
+    }
+
+    return rv;
+}
+
+BytesView PeExeInfo::certificate_table_view(BytesView image) const noexcept
+{
+    constexpr int   dir_index = DataDirectoryIndex::CertificateTable;
+
+    if (_data_directory.size() >= dir_index + 1 && _data_directory[dir_index].size > 0)
+    {
+        // The "RVA" of this directory is a file offset.
+        auto    offset{_data_directory[dir_index].virtual_address};
+        auto    size{_data_directory[dir_index].size};
+
+        if (offset < image.size() && size <= image.size() - offset)
+            return image.subview(offset, size);
+    }
+
+    return {};
+}
+
+void PeExeInfo::load_certificates(std::istream &stream)
+{
+    constexpr int   dir_index = DataDirectoryIndex::CertificateTable;
+
+    if (_data_directory.size() >= dir_index + 1 && _data_directory[dir_index].size > 0)
+    {
+        // The "RVA" of this directory is a file offset.
+        auto    offset{_data_directory[dir_index].virtual_address};
+        auto    here{stream.tellg()};
+
+        _certificate_data.resize(_data_directory[dir_index].size);
+        stream.seekg(offset);
+        stream.read(reinterpret_cast<char *>(_certificate_data.data()), static_cast<std::streamsize>(_certificate_data.size()));
+        _certificate_data.resize(static_cast<size_t>(stream.gcount()));
+        stream.clear();
+        stream.seekg(here);
+
+        _certificates = parse_certificate_table(_certificate_data);
+    }
+}
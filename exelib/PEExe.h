@@ -8,15 +8,22 @@
 #ifndef _EXELIB_PEEXE_H_
 #define _EXELIB_PEEXE_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <iosfwd>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "BlobStore.h"
+#include "CliHeaps.h"
 #include "LoadOptions.h"
 #include "readers.h"
+#include "views.h"
 
 
 /// \brief  Represents a GUID
@@ -289,7 +296,7 @@ class PeSection
 public:
     /// \brief  Construct a PeSection object from a #PeSectionHeader and a \c vector of raw data.
     ///         The raw data is moved into the new object.
-    PeSection(const PeSectionHeader &header, std::vector<uint8_t> &&data) noexcept
+    PeSection(const PeSectionHeader &header, std::vector<uint8_t> &&data)
         : _header{header}
         , _data{std::move(data)}
         , _data_loaded{true}
@@ -298,6 +305,13 @@ public:
     /// \brief  Construct a PeSection object from a #PeSectionHeader and a \c vector of raw data.
     ///         The raw data is copied into the new object.
     PeSection(const PeSectionHeader &header, const std::vector<uint8_t> &data)
+        : _header{header}
+        , _data{std::vector<uint8_t>(data)}
+        , _data_loaded{true}
+    {}
+
+    /// \brief  Construct a PeSection object from a #PeSectionHeader and shared raw data.
+    PeSection(const PeSectionHeader &header, const SharedBytes &data) noexcept
         : _header{header}
         , _data{data}
         , _data_loaded{true}
@@ -333,10 +347,25 @@ public:
 
     /// \brief  Return a reference to the raw data container.
     const std::vector<uint8_t> &data() const noexcept
+    {
+        return _data.vector();
+    }
+
+    /// \brief  Return the raw data in its shareable form.
+    const SharedBytes &shared_data() const noexcept
     {
         return _data;
     }
 
+    /// \brief  Replace the raw data with the copy held in \p store,
+    ///         adding it to the store if it is not already there.
+    ///
+    /// References to data() taken beforehand may be left dangling.
+    void share_data(BlobStore &store)
+    {
+        _data = store.intern(_data);
+    }
+
     /// \brief  Return a reference to the section header.
     const PeSectionHeader &header() const noexcept
     {
@@ -374,7 +403,7 @@ public:
 
 private:
     PeSectionHeader         _header;
-    std::vector<uint8_t>    _data;
+    SharedBytes             _data;
     bool                    _data_loaded;
 };
 
@@ -532,6 +561,45 @@ struct PeDebugMisc
     static constexpr uint32_t   DataTypeExeName = 1;
 };
 
+/// \brief  Describes an entry in the Attribute Certificate Table (a \c WIN_CERTIFICATE structure).
+///
+/// The Attribute Certificate Table is located by the Data Directory, but
+/// unlike every other directory its "RVA" is a file offset, because the
+/// table is not mapped into memory when the image is loaded.
+struct PeCertificate
+{
+    uint32_t    length;             ///< Length, in bytes, of the entry including this header.
+    uint16_t    revision;           ///< Certificate revision. One of the \c Revision values.
+    uint16_t    certificate_type;   ///< Type of content in \c certificate. One of the \c Type values.
+    BytesView   certificate;        ///< The certificate content; for Authenticode, a PKCS#7 SignedData structure.
+                                    ///< This is a view of the bytes held by the PeExeInfo object, or of the
+                                    ///< bytes passed to parse_certificate_table().
+
+    enum Revision : uint16_t
+    {
+        Revision1_0 = 0x0100,   ///< Legacy version of the structure.
+        Revision2_0 = 0x0200    ///< The current version.
+    };
+
+    enum Type : uint16_t
+    {
+        X509            = 0x0001,   ///< An X.509 certificate. Not supported by Windows.
+        PkcsSignedData  = 0x0002,   ///< A PKCS#7 SignedData structure, as used by Authenticode.
+        Reserved1       = 0x0003,   ///< Reserved.
+        TsStackSigned   = 0x0004    ///< Terminal Server protocol stack certificate signing. Not supported by Windows.
+    };
+
+    static constexpr size_t header_size{8};     ///< Size of the fixed part of the structure.
+};
+
+/// \brief  Parse the entries of an Attribute Certificate Table.
+/// \param table    The bytes of the table, typically a view into a memory-mapped file.
+/// \return A vector of entries whose \c certificate members are views into \p table.
+///
+/// Entries are aligned on eight-byte boundaries. Parsing stops at the first
+/// entry whose length is invalid.
+std::vector<PeCertificate> parse_certificate_table(BytesView table);
+
 /// \brief  Describes a VC_FEATURE debug record
 struct PeDebugVcFeature
 {
@@ -820,7 +888,26 @@ enum class PeCliMetadataTableId
     StandAloneSig           = 0x11,
     TypeDef                 = 0x02,
     TypeRef                 = 0x01,
-    TypeSpec                = 0x1B
+    TypeSpec                = 0x1B,
+
+    // Tables found only in uncompressed (#-) streams
+    FieldPtr                = 0x03,
+    MethodPtr               = 0x05,
+    ParamPtr                = 0x07,
+    EventPtr                = 0x13,
+    PropertyPtr             = 0x16,
+    ENCLog                  = 0x1E,
+    ENCMap                  = 0x1F,
+
+    // Portable PDB tables
+    Document                = 0x30,
+    MethodDebugInformation  = 0x31,
+    LocalScope              = 0x32,
+    LocalVariable           = 0x33,
+    LocalConstant           = 0x34,
+    ImportScope             = 0x35,
+    StateMachineMethod      = 0x36,
+    CustomDebugInformation  = 0x37
 };
 
 /// \brief  Provides values primarily used in signatures, but are also used
@@ -972,7 +1059,7 @@ struct PeCliMetadataRowCustomAttribute
     uint32_t    type;       // index into the MethodDef or MemberRef table
     uint32_t    value;      // index into #Blob heap
 };
-//TODO: There is more to this than just this struct. ECMA-335, section II.22.10 describes data in the #Blob heap
+// The value blob, ECMA-335, section II.23.3, is decoded by decode_custom_attribute in CliCustomAttributes.h.
 
 // Row of DeclSecurity table (0x0E)
 struct PeCliMetadataRowDeclSecurity
@@ -1205,6 +1292,122 @@ struct PeCliMetadataRowTypeSpec
     uint32_t    signature;  // index into the #Blob heap
 };
 
+//////////////////////////////////////////////////////////////////////////////
+// Rows of the tables found only in uncompressed (#-) streams. ECMA-335 does not
+// describe these; they are used by edit-and-continue.
+//////////////////////////////////////////////////////////////////////////////
+
+// Row of FieldPtr table (0x03)
+struct PeCliMetadataRowFieldPtr
+{
+    uint32_t    field;  // index into the Field table
+};
+
+// Row of MethodPtr table (0x05)
+struct PeCliMetadataRowMethodPtr
+{
+    uint32_t    method;  // index into the MethodDef table
+};
+
+// Row of ParamPtr table (0x07)
+struct PeCliMetadataRowParamPtr
+{
+    uint32_t    param;  // index into the Param table
+};
+
+// Row of EventPtr table (0x13)
+struct PeCliMetadataRowEventPtr
+{
+    uint32_t    event;  // index into the Event table
+};
+
+// Row of PropertyPtr table (0x16)
+struct PeCliMetadataRowPropertyPtr
+{
+    uint32_t    property;  // index into the Property table
+};
+
+// Row of ENCLog table (0x1E)
+struct PeCliMetadataRowENCLog
+{
+    uint32_t    token;      // metadata token of the row edited
+    uint32_t    func_code;  // kind of edit
+};
+
+// Row of ENCMap table (0x1F)
+struct PeCliMetadataRowENCMap
+{
+    uint32_t    token;  // metadata token of the row edited
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Rows of the tables of a Portable PDB. Portable PDB specification, "Metadata".
+//////////////////////////////////////////////////////////////////////////////
+
+// Row of Document table (0x30)
+struct PeCliMetadataRowDocument
+{
+    uint32_t    name;            // index into the #Blob heap; the encoded document name
+    uint32_t    hash_algorithm;  // index into the #Guid heap
+    uint32_t    hash;            // index into the #Blob heap
+    uint32_t    language;        // index into the #Guid heap
+};
+
+// Row of MethodDebugInformation table (0x31)
+struct PeCliMetadataRowMethodDebugInformation
+{
+    uint32_t    document;         // index into the Document table, or null
+    uint32_t    sequence_points;  // index into the #Blob heap, or null
+};
+
+// Row of LocalScope table (0x32)
+struct PeCliMetadataRowLocalScope
+{
+    uint32_t    method;         // index into the MethodDef table
+    uint32_t    import_scope;   // index into the ImportScope table
+    uint32_t    variable_list;  // index into the LocalVariable table
+    uint32_t    constant_list;  // index into the LocalConstant table
+    uint32_t    start_offset;   // IL offset of the start of the scope
+    uint32_t    length;         // length of the scope, in bytes of IL
+};
+
+// Row of LocalVariable table (0x33)
+struct PeCliMetadataRowLocalVariable
+{
+    uint16_t    attributes;
+    uint16_t    index;       // slot number of the variable
+    uint32_t    name;        // index into the #Strings heap
+};
+
+// Row of LocalConstant table (0x34)
+struct PeCliMetadataRowLocalConstant
+{
+    uint32_t    name;       // index into the #Strings heap
+    uint32_t    signature;  // index into the #Blob heap
+};
+
+// Row of ImportScope table (0x35)
+struct PeCliMetadataRowImportScope
+{
+    uint32_t    parent;   // index into the ImportScope table, or null
+    uint32_t    imports;  // index into the #Blob heap
+};
+
+// Row of StateMachineMethod table (0x36)
+struct PeCliMetadataRowStateMachineMethod
+{
+    uint32_t    move_next_method;  // index into the MethodDef table
+    uint32_t    kickoff_method;    // index into the MethodDef table
+};
+
+// Row of CustomDebugInformation table (0x37)
+struct PeCliMetadataRowCustomDebugInformation
+{
+    uint32_t    parent;  // index into any table that can have custom debug information
+    uint32_t    kind;    // index into the #Guid heap
+    uint32_t    value;   // index into the #Blob heap
+};
+
 ///////////////////////////////////////
 // End of metadata table row structures
 ///////////////////////////////////////
@@ -1225,205 +1428,1361 @@ enum class PeCliEncodedIndexType
     Implementation,
     CustomAttributeType,
     ResolutionScope,
-    TypeOrMethodDef
+    TypeOrMethodDef,
+    HasCustomDebugInformation   ///< Used only by Portable PDB tables
 };
 
-/// \brief Deconstruction of the #~ stream
-class PeCliMetadataTables
+/// \brief  Structure returned by the PeCliMetadata::decode_index function.
+struct PeCliMetadataTableIndex
 {
-public:
-    PeCliMetadataTables() = default;
-    PeCliMetadataTables(const PeCliMetadataTables &) = delete;
-    PeCliMetadataTables &operator=(const PeCliMetadataTables &) = delete;
-
-    void load(BytesReader &reader);
+    PeCliMetadataTableId    table_id;   ///< The identifier of the table to be indexed
+    uint32_t                index;      ///< The actual index value
 
-    const std::vector<PeCliMetadataTableId> &valid_table_types() const noexcept
+    /// \brief  Return the metadata token of the row: the table identifier
+    ///         in the high byte and the one-based row number in the low three bytes.
+    uint32_t token() const noexcept
     {
-        return _valid_table_types;
+        return static_cast<uint32_t>(table_id) << 24 | (index & 0x00FFFFFF);
     }
 
-    const PeCliMetadataTablesStreamHeader &header() const noexcept
+    /// \brief  Split a metadata token into its table identifier and row number.
+    static PeCliMetadataTableIndex from_token(uint32_t token) noexcept
     {
-        return _header;
+        return {static_cast<PeCliMetadataTableId>(token >> 24), token & 0x00FFFFFF};
     }
+};
 
-    const std::vector<PeCliMetadataRowAssembly> *assembly_table() const noexcept
+/// \brief  Kinds of column found in CLI metadata tables.
+enum class PeCliColumnKind : uint8_t
+{
+    UInt8,          ///< A one-byte constant
+    UInt16,         ///< A two-byte constant
+    UInt32,         ///< A four-byte constant
+    StringIndex,    ///< An index into the \#Strings heap
+    GuidIndex,      ///< An index into the \#GUID heap
+    BlobIndex,      ///< An index into the \#Blob heap
+    TableIndex,     ///< A simple index into another table
+    CodedIndex,     ///< A coded index, as described by PeCliEncodedIndexType
+    ListIndex       ///< An index into another table that begins a run of rows, such as TypeDef.FieldList.
+                    ///< In an uncompressed (\#-) stream that has the corresponding Ptr table, such as
+                    ///< FieldPtr, the index refers to the Ptr table instead.
+};
+
+/// \brief  Describes one column of a CLI metadata table.
+struct PeCliColumn
+{
+    PeCliColumnKind kind;
+    uint8_t         target;     ///< The PeCliMetadataTableId of a TableIndex column,
+                                ///< or the PeCliEncodedIndexType of a CodedIndex column.
+};
+
+/// \brief  The position and shape of one table in the \#~ stream.
+struct PeCliMetadataTableLayout
+{
+    static constexpr size_t max_columns{9};
+
+    uint32_t    row_count;                      ///< Number of rows in the table
+    uint32_t    row_size;                       ///< Size of each row, in bytes
+    uint32_t    offset;                         ///< Offset of the first row from the start of the stream
+    uint8_t     column_count;                   ///< Number of columns in each row
+    uint8_t     column_offsets[max_columns];    ///< Offset of each column from the start of a row
+    uint8_t     column_widths[max_columns];     ///< Width of each column, in bytes
+};
+
+/// \brief  The layout of every table in a \#~ stream.
+///
+/// The widths of heap and table indexes in a \#~ stream depend on the
+/// sizes of the heaps and tables. PeCliMetadataSchema computes them, and
+/// from them the size and position of every table, once from the stream
+/// header, so that any column of any row can be located directly.
+class PeCliMetadataSchema
+{
+public:
+    static constexpr size_t table_count{64};    ///< Number of table identifiers in the valid_tables bit vector
+
+    /// \brief  Return the columns of a table.
+    /// \param id       Identifier of the table.
+    /// \param count    Receives the number of columns.
+    /// \return A pointer to the column descriptions, or \c nullptr if the table is not known.
+    static const PeCliColumn *table_columns(PeCliMetadataTableId id, size_t &count) noexcept;
+
+    /// \brief  Return \c true if the layout of the table with the given identifier is known.
+    static bool is_known_table(PeCliMetadataTableId id) noexcept
     {
-        return _assembly_table.get();
+        size_t  count;
+
+        return table_columns(id, count) != nullptr;
     }
 
-    const std::vector<PeCliMetadataRowAssemblyOS> *assembly_os_table() const noexcept
+    /// \brief  Return the pointer table, such as FieldPtr, through which a
+    ///         list column of an uncompressed (\#-) stream may refer to a
+    ///         table, or the table itself if it has none.
+    static PeCliMetadataTableId pointer_table(PeCliMetadataTableId id) noexcept;
+
+    /// \brief  Split a coded index into its table identifier and row index.
+    ///
+    /// A \c std::runtime_error exception is thrown if the tag does not identify a table.
+    static PeCliMetadataTableIndex decode_index(PeCliEncodedIndexType type, uint32_t index);
+
+    /// \brief  Combine a table identifier and row index into a coded index.
+    ///
+    /// A \c std::runtime_error exception is thrown if the coded index cannot reference the table.
+    static uint32_t encode_index(PeCliEncodedIndexType type, PeCliMetadataTableIndex index);
+
+    /// \brief  Compute the layout of every table.
+    /// \param heap_sizes       The heap_sizes member of the stream header.
+    /// \param valid_tables     The valid_tables member of the stream header.
+    /// \param row_counts       The row counts of the valid tables, in table identifier order.
+    /// \param tables_offset    Offset of the first table from the start of the stream.
+    /// \param referenced_row_counts    For a Portable PDB, the row counts of the
+    ///                         type system tables in the assembly it describes,
+    ///                         indexed by table identifier; otherwise \c nullptr.
+    ///                         These determine the width of indexes into those tables.
+    ///
+    /// If a valid table is not known, the position of the tables that follow
+    /// it cannot be determined. That table and those following it are then
+    /// given no rows, and is_complete() returns \c false.
+    void compute(uint8_t heap_sizes, uint64_t valid_tables, const std::vector<uint32_t> &row_counts, uint32_t tables_offset,
+                 const uint32_t *referenced_row_counts = nullptr);
+
+    /// \brief  Return \c true if the layout of every valid table is known.
+    bool is_complete() const noexcept
     {
-        return _assembly_os_table.get();
+        return _complete;
     }
 
-    const std::vector<PeCliMetadataRowAssemblyRef> *assembly_ref_table() const noexcept
+    /// \brief  Return the layout of a table. Tables that are not present have no rows.
+    const PeCliMetadataTableLayout &layout(PeCliMetadataTableId id) const noexcept
     {
-        return _assembly_ref_table.get();
+        return _layouts[static_cast<size_t>(id) % table_count];
     }
 
-    const std::vector<PeCliMetadataRowAssemblyProcessor> *assembly_processor_table() const noexcept
+    /// \brief  Return the number of rows in a table.
+    uint32_t row_count(PeCliMetadataTableId id) const noexcept
     {
-        return _assembly_processor_table.get();
+        return layout(id).row_count;
     }
 
-    const std::vector<PeCliMetadataRowAssemblyRefOS> *assembly_ref_os_table() const noexcept
+    /// \brief  Return the width, in bytes, of a simple index into a table.
+    uint8_t index_width(PeCliMetadataTableId id) const noexcept
     {
-        return _assembly_ref_os_table.get();
+        return _index_row_counts[static_cast<size_t>(id) % table_count] < 0x10000 ? 2 : 4;
     }
 
-    const std::vector<PeCliMetadataRowAssemblyRefProcessor> *assembly_ref_processor_table() const noexcept
+    /// \brief  Return the width, in bytes, of a coded index.
+    uint8_t index_width(PeCliEncodedIndexType type) const noexcept
     {
-        return _assembly_ref_processor_table.get();
+        return _coded_index_widths[static_cast<size_t>(type)];
     }
 
-    const std::vector<PeCliMetadataRowClassLayout> *class_layout_table() const noexcept
+    /// \brief  Return the width, in bytes, of an index into the \#Strings heap.
+    uint8_t string_index_width() const noexcept
     {
-        return _class_layout_table.get();
+        return _string_index_width;
     }
 
-    const std::vector<PeCliMetadataRowConstant> *constant_table() const noexcept
+    /// \brief  Return the width, in bytes, of an index into the \#GUID heap.
+    uint8_t guid_index_width() const noexcept
     {
-        return _constant_table.get();
+        return _guid_index_width;
     }
 
-    const std::vector<PeCliMetadataRowCustomAttribute> *custom_attribute_table() const noexcept
+    /// \brief  Return the width, in bytes, of an index into the \#Blob heap.
+    uint8_t blob_index_width() const noexcept
     {
-        return _custom_attribute_table.get();
+        return _blob_index_width;
     }
 
-    const std::vector<PeCliMetadataRowDeclSecurity> *decl_security_table() const noexcept
+    /// \brief  Return the offset from the start of the stream to the end of the last table.
+    uint32_t tables_end() const noexcept
     {
-        return _decl_security_table.get();
+        return _tables_end;
     }
 
-    const std::vector<PeCliMetadataRowEvent> *event_table() const noexcept
+    /// \brief  Read a little-endian value one, two, or four bytes wide.
+    static uint32_t read_value(const uint8_t *ptr, uint8_t width) noexcept
     {
-        return _event_table.get();
+        switch (width)
+        {
+            case 1:
+                return ptr[0];
+            case 2:
+                return static_cast<uint32_t>(ptr[0]) | static_cast<uint32_t>(ptr[1]) << 8;
+            default:
+                return static_cast<uint32_t>(ptr[0])
+                     | static_cast<uint32_t>(ptr[1]) << 8
+                     | static_cast<uint32_t>(ptr[2]) << 16
+                     | static_cast<uint32_t>(ptr[3]) << 24;
+        }
     }
 
-    const std::vector<PeCliMetadataRowEventMap> *event_map_table() const noexcept
+    /// \brief  Read every column of a row.
+    /// \param row      Pointer to the first byte of the row.
+    /// \param layout   Layout of the table containing the row.
+    /// \param values   Receives the column values. Must have room for
+    ///                 \c layout.column_count values.
+    static void read_row(const uint8_t *row, const PeCliMetadataTableLayout &layout, uint32_t *values) noexcept
     {
-        return _event_map_table.get();
+        for (size_t i = 0; i < layout.column_count; ++i)
+            values[i] = read_value(row + layout.column_offsets[i], layout.column_widths[i]);
     }
 
-    const std::vector<PeCliMetadataRowExportedType> *exported_type_table() const noexcept
+private:
+    static constexpr size_t coded_index_type_count{14};
+
+    PeCliMetadataTableLayout    _layouts[table_count]{};
+    uint32_t                    _index_row_counts[table_count]{};   // row counts that determine index widths
+    uint8_t                     _coded_index_widths[coded_index_type_count]{};
+    uint8_t                     _string_index_width{2};
+    uint8_t                     _guid_index_width{2};
+    uint8_t                     _blob_index_width{2};
+    uint32_t                    _tables_end{0};
+    bool                        _complete{true};
+};
+
+/// \brief  Associates a metadata table row structure with its table identifier,
+///         and copies decoded column values into the structure's members.
+///
+/// There is a specialization for each of the PeCliMetadataRow structures.
+template<typename Row>
+struct PeCliMetadataRowTraits;
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssembly>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Assembly};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssembly &row) noexcept
     {
-        return _exported_type_table.get();
+        row.hash_alg_id = c[0];
+        row.major_version = static_cast<uint16_t>(c[1]);
+        row.minor_version = static_cast<uint16_t>(c[2]);
+        row.build_number = static_cast<uint16_t>(c[3]);
+        row.revision_number = static_cast<uint16_t>(c[4]);
+        row.flags = c[5];
+        row.public_key = c[6];
+        row.name = c[7];
+        row.culture = c[8];
     }
+};
 
-    const std::vector<PeCliMetadataRowField> *field_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssemblyOS>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::AssemblyOS};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssemblyOS &row) noexcept
     {
-        return _field_table.get();
+        row.os_platformID = c[0];
+        row.os_major_version = c[1];
+        row.os_minor_version = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowFieldLayout> *field_layout_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssemblyProcessor>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::AssemblyProcessor};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssemblyProcessor &row) noexcept
     {
-        return _field_layout_table.get();
+        row.processor = c[0];
     }
+};
 
-    const std::vector<PeCliMetadataRowFieldMarshal> *field_marshal_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssemblyRef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::AssemblyRef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssemblyRef &row) noexcept
     {
-        return _field_marshal_table.get();
+        row.major_version = static_cast<uint16_t>(c[0]);
+        row.minor_version = static_cast<uint16_t>(c[1]);
+        row.build_number = static_cast<uint16_t>(c[2]);
+        row.revision_number = static_cast<uint16_t>(c[3]);
+        row.flags = c[4];
+        row.public_key_or_token = c[5];
+        row.name = c[6];
+        row.culture = c[7];
+        row.hash_value = c[8];
     }
+};
 
-    const std::vector<PeCliMetadataRowFieldRVA> *field_rva_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssemblyRefOS>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::AssemblyRefOS};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssemblyRefOS &row) noexcept
     {
-        return _field_rva_table.get();
+        row.os_platformID = c[0];
+        row.os_major_version = c[1];
+        row.os_minor_version = c[2];
+        row.assembly_ref = c[3];
     }
+};
 
-    const std::vector<PeCliMetadataRowFile> *file_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowAssemblyRefProcessor>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::AssemblyRefProcessor};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowAssemblyRefProcessor &row) noexcept
     {
-        return _file_table.get();
+        row.processor = c[0];
+        row.assembly_ref = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowGenericParam> *generic_param_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowClassLayout>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ClassLayout};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowClassLayout &row) noexcept
     {
-        return _generic_param_table.get();
+        row.packing_size = static_cast<uint16_t>(c[0]);
+        row.class_size = c[1];
+        row.parent = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowGenericParamConstraint> *generic_param_constraint_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowConstant>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Constant};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowConstant &row) noexcept
     {
-        return _generic_param_constraint_table.get();
+        row.type = static_cast<uint8_t>(c[0]);
+        row.padding = static_cast<uint8_t>(c[1]);
+        row.parent = c[2];
+        row.value = c[3];
     }
+};
 
-    const std::vector<PeCliMetadataRowImplMap> *impl_map_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowCustomAttribute>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::CustomAttribute};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowCustomAttribute &row) noexcept
     {
-        return _impl_map_table.get();
+        row.parent = c[0];
+        row.type = c[1];
+        row.value = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowInterfaceImpl> *interface_impl_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowDeclSecurity>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::DeclSecurity};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowDeclSecurity &row) noexcept
     {
-        return _interface_impl_table.get();
+        row.action = static_cast<uint16_t>(c[0]);
+        row.parent = c[1];
+        row.permission_set = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowManifestResource> *manifest_resource_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowEvent>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Event};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowEvent &row) noexcept
     {
-        return _manifest_resource_table.get();
+        row.event_flags = static_cast<uint16_t>(c[0]);
+        row.name = c[1];
+        row.event_type = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowMemberRef> *member_ref_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowEventMap>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::EventMap};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowEventMap &row) noexcept
     {
-        return _member_ref_table.get();
+        row.parent = c[0];
+        row.event_list = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowMethodDef> *method_def_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowExportedType>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ExportedType};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowExportedType &row) noexcept
     {
-        return _method_def_table.get();
+        row.flags = c[0];
+        row.typedef_id = c[1];
+        row.type_name = c[2];
+        row.type_namespace = c[3];
+        row.implementation = c[4];
     }
+};
 
-    const std::vector<PeCliMetadataRowMethodImpl> *method_impl_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowField>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Field};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowField &row) noexcept
     {
-        return _method_impl_table.get();
+        row.flags = static_cast<uint16_t>(c[0]);
+        row.name = c[1];
+        row.signature = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowMethodSemantics> *method_semantics_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowFieldLayout>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::FieldLayout};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowFieldLayout &row) noexcept
     {
-        return _method_semantics_table.get();
+        row.offset = c[0];
+        row.field = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowMethodSpec> *method_spec_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowFieldMarshal>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::FieldMarshal};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowFieldMarshal &row) noexcept
     {
-        return _method_spec_table.get();
+        row.parent = c[0];
+        row.native_type = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowModule> *module_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowFieldRVA>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::FieldRVA};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowFieldRVA &row) noexcept
     {
-        return _module_table.get();
+        row.rva = c[0];
+        row.field = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowModuleRef> *module_ref_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowFile>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::File};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowFile &row) noexcept
     {
-        return _module_ref_table.get();
+        row.flags = c[0];
+        row.name = c[1];
+        row.hash_value = c[2];
     }
+};
 
-    const std::vector<PeCliMetadataRowNestedClass> *nested_class_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowGenericParam>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::GenericParam};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowGenericParam &row) noexcept
     {
-        return _nested_class_table.get();
+        row.number = static_cast<uint16_t>(c[0]);
+        row.flags = static_cast<uint16_t>(c[1]);
+        row.owner = c[2];
+        row.name = c[3];
     }
+};
 
-    const std::vector<PeCliMetadataRowParam> *param_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowGenericParamConstraint>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::GenericParamConstraint};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowGenericParamConstraint &row) noexcept
     {
-        return _param_table.get();
+        row.owner = c[0];
+        row.constraint = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowProperty> *property_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowImplMap>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ImplMap};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowImplMap &row) noexcept
     {
-        return _property_table.get();
+        row.mapping_flags = static_cast<uint16_t>(c[0]);
+        row.member_forwarded = c[1];
+        row.import_name = c[2];
+        row.import_scope = c[3];
     }
+};
 
-    const std::vector<PeCliMetadataRowPropertyMap> *property_map_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowInterfaceImpl>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::InterfaceImpl};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowInterfaceImpl &row) noexcept
     {
-        return _property_map_table.get();
+        row.class_ = c[0];
+        row.interface_ = c[1];
     }
+};
 
-    const std::vector<PeCliMetadataRowStandAloneSig> *standalone_sig_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowManifestResource>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ManifestResource};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowManifestResource &row) noexcept
     {
-        return _standalone_sig_table.get();
+        row.offset = c[0];
+        row.flags = c[1];
+        row.name = c[2];
+        row.implementation = c[3];
     }
+};
 
-    const std::vector<PeCliMetadataRowTypeDef> *type_def_table() const noexcept
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMemberRef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MemberRef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMemberRef &row) noexcept
+    {
+        row.class_ = c[0];
+        row.name = c[1];
+        row.signature = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodDef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodDef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodDef &row) noexcept
+    {
+        row.rva = c[0];
+        row.impl_flags = static_cast<uint16_t>(c[1]);
+        row.flags = static_cast<uint16_t>(c[2]);
+        row.name = c[3];
+        row.signature = c[4];
+        row.param_list = c[5];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodImpl>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodImpl};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodImpl &row) noexcept
+    {
+        row.class_ = c[0];
+        row.method_body = c[1];
+        row.method_declaration = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodSemantics>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodSemantics};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodSemantics &row) noexcept
+    {
+        row.semantics = static_cast<uint16_t>(c[0]);
+        row.method = c[1];
+        row.association = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodSpec>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodSpec};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodSpec &row) noexcept
+    {
+        row.method = c[0];
+        row.instantiation = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowModule>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Module};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowModule &row) noexcept
+    {
+        row.generation = static_cast<uint16_t>(c[0]);
+        row.name = c[1];
+        row.mv_id = c[2];
+        row.enc_id = c[3];
+        row.enc_base_id = c[4];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowModuleRef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ModuleRef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowModuleRef &row) noexcept
+    {
+        row.name = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowNestedClass>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::NestedClass};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowNestedClass &row) noexcept
+    {
+        row.nested_class = c[0];
+        row.enclosing_class = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowParam>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Param};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowParam &row) noexcept
+    {
+        row.flags = static_cast<uint16_t>(c[0]);
+        row.sequence = static_cast<uint16_t>(c[1]);
+        row.name = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowProperty>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Property};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowProperty &row) noexcept
+    {
+        row.flags = static_cast<uint16_t>(c[0]);
+        row.name = c[1];
+        row.type = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowPropertyMap>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::PropertyMap};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowPropertyMap &row) noexcept
+    {
+        row.parent = c[0];
+        row.property_list = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowStandAloneSig>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::StandAloneSig};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowStandAloneSig &row) noexcept
+    {
+        row.signature = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowTypeDef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::TypeDef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowTypeDef &row) noexcept
+    {
+        row.flags = c[0];
+        row.type_name = c[1];
+        row.type_namespace = c[2];
+        row.extends = c[3];
+        row.field_list = c[4];
+        row.method_list = c[5];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowTypeRef>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::TypeRef};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowTypeRef &row) noexcept
+    {
+        row.resolution_scope = c[0];
+        row.type_name = c[1];
+        row.type_namespace = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowTypeSpec>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::TypeSpec};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowTypeSpec &row) noexcept
+    {
+        row.signature = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowFieldPtr>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::FieldPtr};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowFieldPtr &row) noexcept
+    {
+        row.field = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodPtr>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodPtr};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodPtr &row) noexcept
+    {
+        row.method = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowParamPtr>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ParamPtr};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowParamPtr &row) noexcept
+    {
+        row.param = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowEventPtr>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::EventPtr};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowEventPtr &row) noexcept
+    {
+        row.event = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowPropertyPtr>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::PropertyPtr};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowPropertyPtr &row) noexcept
+    {
+        row.property = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowENCLog>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ENCLog};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowENCLog &row) noexcept
+    {
+        row.token = c[0];
+        row.func_code = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowENCMap>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ENCMap};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowENCMap &row) noexcept
+    {
+        row.token = c[0];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowDocument>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::Document};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowDocument &row) noexcept
+    {
+        row.name = c[0];
+        row.hash_algorithm = c[1];
+        row.hash = c[2];
+        row.language = c[3];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowMethodDebugInformation>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::MethodDebugInformation};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowMethodDebugInformation &row) noexcept
+    {
+        row.document = c[0];
+        row.sequence_points = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowLocalScope>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::LocalScope};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowLocalScope &row) noexcept
+    {
+        row.method = c[0];
+        row.import_scope = c[1];
+        row.variable_list = c[2];
+        row.constant_list = c[3];
+        row.start_offset = c[4];
+        row.length = c[5];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowLocalVariable>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::LocalVariable};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowLocalVariable &row) noexcept
+    {
+        row.attributes = static_cast<uint16_t>(c[0]);
+        row.index = static_cast<uint16_t>(c[1]);
+        row.name = c[2];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowLocalConstant>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::LocalConstant};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowLocalConstant &row) noexcept
+    {
+        row.name = c[0];
+        row.signature = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowImportScope>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::ImportScope};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowImportScope &row) noexcept
+    {
+        row.parent = c[0];
+        row.imports = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowStateMachineMethod>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::StateMachineMethod};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowStateMachineMethod &row) noexcept
+    {
+        row.move_next_method = c[0];
+        row.kickoff_method = c[1];
+    }
+};
+
+template<>
+struct PeCliMetadataRowTraits<PeCliMetadataRowCustomDebugInformation>
+{
+    static constexpr PeCliMetadataTableId id{PeCliMetadataTableId::CustomDebugInformation};
+
+    static void assign(const uint32_t *c, PeCliMetadataRowCustomDebugInformation &row) noexcept
+    {
+        row.parent = c[0];
+        row.kind = c[1];
+        row.value = c[2];
+    }
+};
+
+/// \brief  A random-access view of one table in the \#~ stream.
+///
+/// Rows are decoded on demand, directly from the stream's bytes, so a view
+/// is cheap to create and to copy. A view is valid only as long as the
+/// PeCliMetadataTables object that created it.
+///
+/// \tparam Row One of the PeCliMetadataRow structures.
+template<typename Row>
+class PeCliMetadataTableView
+{
+public:
+    /// \brief  Iterates over the rows of the table, decoding each one as it is dereferenced.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Row;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Row *;
+        using reference = Row;
+
+        const_iterator(const PeCliMetadataTableView *view, uint32_t index) noexcept
+          : _view{view},
+            _index{index}
+        {}
+
+        Row operator*() const
+        {
+            return _view->row(_index);
+        }
+
+        const_iterator &operator++() noexcept
+        {
+            ++_index;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            auto    rv{*this};
+
+            ++_index;
+            return rv;
+        }
+
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return _index == other._index && _view == other._view;
+        }
+
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const PeCliMetadataTableView   *_view;
+        uint32_t                        _index;
+    };
+
+    /// \brief  Construct a view of an empty table.
+    PeCliMetadataTableView() noexcept
+      : _layout{&empty_layout()}
+    {}
+
+    /// \brief  Construct a view of a table.
+    /// \param stream   The content of the \#~ stream.
+    /// \param layout   The layout of the table within the stream.
+    PeCliMetadataTableView(BytesView stream, const PeCliMetadataTableLayout &layout) noexcept
+      : _stream{stream},
+        _layout{&layout}
+    {}
+
+    /// \brief  Return the identifier of the table.
+    static constexpr PeCliMetadataTableId id() noexcept
+    {
+        return PeCliMetadataRowTraits<Row>::id;
+    }
+
+    /// \brief  Return the number of rows in the table.
+    uint32_t size() const noexcept
+    {
+        return _layout->row_count;
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /// \brief  Decode a row.
+    /// \param index    Zero-based index of the row. Note that indexes
+    ///                 stored in metadata tables and tokens are one-based.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p index is not less than size().
+    Row row(uint32_t index) const
+    {
+        uint32_t    values[PeCliMetadataTableLayout::max_columns];
+        Row         rv{};
+
+        PeCliMetadataSchema::read_row(row_bytes(index).data(), *_layout, values);
+        PeCliMetadataRowTraits<Row>::assign(values, rv);
+
+        return rv;
+    }
+
+    /// \brief  Decode a single column of a row.
+    /// \param index    Zero-based index of the row.
+    /// \param column   Zero-based index of the column, in the order of the members of \p Row.
+    ///
+    /// A \c std::out_of_range exception is thrown if either index is out of range.
+    uint32_t column(uint32_t index, size_t column) const
+    {
+        if (column >= _layout->column_count)
+            throw std::out_of_range("CLI metadata table column index out of range");
+
+        return PeCliMetadataSchema::read_value(row_bytes(index).data() + _layout->column_offsets[column],
+                                               _layout->column_widths[column]);
+    }
+
+    /// \brief  Return the undecoded bytes of a row.
+    ///
+    /// A \c std::out_of_range exception is thrown if \p index is not less than size().
+    BytesView row_bytes(uint32_t index) const
+    {
+        if (index >= size())
+            throw std::out_of_range("CLI metadata table row index out of range");
+
+        return _stream.subview(_layout->offset + static_cast<size_t>(index) * _layout->row_size, _layout->row_size);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return {this, 0};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return {this, size()};
+    }
+
+private:
+    static const PeCliMetadataTableLayout &empty_layout() noexcept
+    {
+        static const PeCliMetadataTableLayout   empty{};
+
+        return empty;
+    }
+
+    BytesView                       _stream;
+    const PeCliMetadataTableLayout *_layout;
+};
+
+class PeCliMetadataRelations;
+
+/// \brief  The content of the \#Pdb stream of a Portable PDB.
+///         Portable PDB specification, "#Pdb stream".
+struct PeCliPdbStream
+{
+    uint8_t                 pdb_id[20];     ///< Identifies the PDB; matches the debug directory entry of the assembly
+    uint32_t                entry_point;    ///< MethodDef token of the entry point, or zero
+    uint64_t                referenced_type_system_tables;  ///< Bit vector of the assembly's tables referenced by the PDB
+    std::vector<uint32_t>   type_system_table_rows;         ///< Row counts of the referenced tables, in table identifier order
+};
+
+/// \brief  The size of one table of a \#~ stream.
+struct PeCliMetadataTableStatistics
+{
+    PeCliMetadataTableId    id;         ///< Identifier of the table
+    uint32_t                row_count;  ///< Number of rows, as given by the stream header
+    uint32_t                row_size;   ///< Size of each row, in bytes, or zero if the layout of the table is not known
+    uint64_t                size;       ///< Size of the table, in bytes
+};
+
+/// \brief  The sizes, row counts, and index widths of the tables in a \#~
+///         stream, as returned by PeCliMetadataTables::statistics().
+struct PeCliMetadataTablesStatistics
+{
+    uint32_t    stream_size{0};         ///< Size of the whole stream, in bytes
+    uint32_t    header_size{0};         ///< Size of the stream header and row counts, which precede the first table
+    uint64_t    tables_size{0};         ///< Total size of the tables, in bytes
+    uint64_t    row_count{0};           ///< Total number of rows in all tables
+    uint8_t     string_index_width{2};  ///< Width, in bytes, of an index into the \#Strings heap
+    uint8_t     guid_index_width{2};    ///< Width, in bytes, of an index into the \#GUID heap
+    uint8_t     blob_index_width{2};    ///< Width, in bytes, of an index into the \#Blob heap
+    uint64_t    wide_table_indexes{0};  ///< Bit vector, by table identifier, of the tables whose simple indexes are four bytes wide
+    uint32_t    wide_coded_indexes{0};  ///< Bit vector, by PeCliEncodedIndexType, of the coded indexes that are four bytes wide
+    bool        is_complete{true};      ///< \c false if a table whose layout is not known hides the size of those following it
+    std::vector<PeCliMetadataTableStatistics>   tables; ///< The valid tables, in table identifier order
+};
+
+/// \brief Deconstruction of the #~ stream
+class PeCliMetadataTables
+{
+public:
+    PeCliMetadataTables();
+    PeCliMetadataTables(const PeCliMetadataTables &) = delete;
+    PeCliMetadataTables &operator=(const PeCliMetadataTables &) = delete;
+    ~PeCliMetadataTables();
+
+    /// \brief  Read the header of a \#~ or \#- stream and compute the layout of its tables.
+    /// \param stream   The content of the stream.
+    /// \param pdb      The \#Pdb stream, if the tables are those of a Portable PDB; otherwise \c nullptr.
+    ///
+    /// Rows are not decoded; they are available on demand through table().
+    /// The tables object shares ownership of \p stream.
+    void load(const SharedBytes &stream, const PeCliPdbStream *pdb = nullptr);
+
+    /// \brief  Decode every row of every table into the vectors returned by
+    ///         assembly_table(), assembly_os_table(), and so on.
+    /// \param thread_count    The number of threads on which to decode the
+    ///                         rows. Large tables are divided among the
+    ///                         threads in blocks of rows; each row is decoded
+    ///                         into its own place, so the result does not
+    ///                         depend on the number of threads.
+    void load_rows(unsigned thread_count = 1);
+
+    const std::vector<PeCliMetadataTableId> &valid_table_types() const noexcept
+    {
+        return _valid_table_types;
+    }
+
+    const PeCliMetadataTablesStreamHeader &header() const noexcept
+    {
+        return _header;
+    }
+
+    /// \brief  Return the layout of the tables, computed from the stream header.
+    const PeCliMetadataSchema &schema() const noexcept
+    {
+        return _schema;
+    }
+
+    /// \brief  Return the content of the \#~ stream.
+    BytesView stream() const noexcept
+    {
+        return _stream;
+    }
+
+    /// \brief  Return the sizes, row counts, and index widths of the tables.
+    ///
+    /// The statistics are computed from the stream header and the schema
+    /// alone, without decoding any rows.
+    PeCliMetadataTablesStatistics statistics() const;
+
+    /// \brief  Return a view of a table that decodes rows on demand.
+    /// \tparam Row The row structure of the table, such as PeCliMetadataRowAssembly.
+    ///
+    /// The view is empty if the table does not exist.
+    template<typename Row>
+    PeCliMetadataTableView<Row> table() const noexcept
+    {
+        return {_stream, _schema.layout(PeCliMetadataRowTraits<Row>::id)};
+    }
+
+    /// \brief  Return an object navigating the relationships between rows
+    ///         of the tables. Declared in CliRelations.h.
+    const PeCliMetadataRelations &relations() const noexcept
+    {
+        return *_relations;
+    }
+
+    /// \brief  Replace the \#~ stream with the copy held in \p store,
+    ///         adding it to the store if it is not already there.
+    ///
+    /// Table views and rows' byte views taken beforehand may be left dangling.
+    void share_data(BlobStore &store)
+    {
+        _stream = store.intern(_stream);
+    }
+
+    // The following functions return pointers to the decoded rows of each
+    // table. The pointers are null if the table does not exist or if
+    // load_rows() has not been called.
+
+    const std::vector<PeCliMetadataRowAssembly> *assembly_table() const noexcept
+    {
+        return _assembly_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowAssemblyOS> *assembly_os_table() const noexcept
+    {
+        return _assembly_os_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowAssemblyRef> *assembly_ref_table() const noexcept
+    {
+        return _assembly_ref_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowAssemblyProcessor> *assembly_processor_table() const noexcept
+    {
+        return _assembly_processor_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowAssemblyRefOS> *assembly_ref_os_table() const noexcept
+    {
+        return _assembly_ref_os_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowAssemblyRefProcessor> *assembly_ref_processor_table() const noexcept
+    {
+        return _assembly_ref_processor_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowClassLayout> *class_layout_table() const noexcept
+    {
+        return _class_layout_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowConstant> *constant_table() const noexcept
+    {
+        return _constant_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowCustomAttribute> *custom_attribute_table() const noexcept
+    {
+        return _custom_attribute_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowDeclSecurity> *decl_security_table() const noexcept
+    {
+        return _decl_security_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowEvent> *event_table() const noexcept
+    {
+        return _event_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowEventMap> *event_map_table() const noexcept
+    {
+        return _event_map_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowExportedType> *exported_type_table() const noexcept
+    {
+        return _exported_type_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowField> *field_table() const noexcept
+    {
+        return _field_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowFieldLayout> *field_layout_table() const noexcept
+    {
+        return _field_layout_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowFieldMarshal> *field_marshal_table() const noexcept
+    {
+        return _field_marshal_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowFieldRVA> *field_rva_table() const noexcept
+    {
+        return _field_rva_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowFile> *file_table() const noexcept
+    {
+        return _file_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowGenericParam> *generic_param_table() const noexcept
+    {
+        return _generic_param_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowGenericParamConstraint> *generic_param_constraint_table() const noexcept
+    {
+        return _generic_param_constraint_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowImplMap> *impl_map_table() const noexcept
+    {
+        return _impl_map_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowInterfaceImpl> *interface_impl_table() const noexcept
+    {
+        return _interface_impl_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowManifestResource> *manifest_resource_table() const noexcept
+    {
+        return _manifest_resource_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMemberRef> *member_ref_table() const noexcept
+    {
+        return _member_ref_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMethodDef> *method_def_table() const noexcept
+    {
+        return _method_def_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMethodImpl> *method_impl_table() const noexcept
+    {
+        return _method_impl_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMethodSemantics> *method_semantics_table() const noexcept
+    {
+        return _method_semantics_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMethodSpec> *method_spec_table() const noexcept
+    {
+        return _method_spec_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowModule> *module_table() const noexcept
+    {
+        return _module_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowModuleRef> *module_ref_table() const noexcept
+    {
+        return _module_ref_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowNestedClass> *nested_class_table() const noexcept
+    {
+        return _nested_class_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowParam> *param_table() const noexcept
+    {
+        return _param_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowProperty> *property_table() const noexcept
+    {
+        return _property_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowPropertyMap> *property_map_table() const noexcept
+    {
+        return _property_map_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowStandAloneSig> *standalone_sig_table() const noexcept
+    {
+        return _standalone_sig_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowTypeDef> *type_def_table() const noexcept
     {
         return _type_def_table.get();
     }
@@ -1438,46 +2797,92 @@ public:
         return _type_spec_table.get();
     }
 
-private:
-    size_t read_index(BytesReader &reader, uint32_t &ndx, bool wide)
+    const std::vector<PeCliMetadataRowFieldPtr> *field_ptr_table() const noexcept
     {
-        if (wide)
-        {
-            reader.read(ndx);
-            return sizeof(ndx);
-        }
-        else
-        {
-            uint16_t    tmp;
+        return _field_ptr_table.get();
+    }
 
-            reader.read(tmp);
-            ndx = tmp;
-            return sizeof(tmp);
-        }
+    const std::vector<PeCliMetadataRowMethodPtr> *method_ptr_table() const noexcept
+    {
+        return _method_ptr_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowParamPtr> *param_ptr_table() const noexcept
+    {
+        return _param_ptr_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowEventPtr> *event_ptr_table() const noexcept
+    {
+        return _event_ptr_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowPropertyPtr> *property_ptr_table() const noexcept
+    {
+        return _property_ptr_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowENCLog> *enc_log_table() const noexcept
+    {
+        return _enc_log_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowENCMap> *enc_map_table() const noexcept
+    {
+        return _enc_map_table.get();
     }
-    size_t read_strings_heap_index(BytesReader &reader, uint32_t &ndx)
+
+    const std::vector<PeCliMetadataRowDocument> *document_table() const noexcept
+    {
+        return _document_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowMethodDebugInformation> *method_debug_information_table() const noexcept
+    {
+        return _method_debug_information_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowLocalScope> *local_scope_table() const noexcept
+    {
+        return _local_scope_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowLocalVariable> *local_variable_table() const noexcept
+    {
+        return _local_variable_table.get();
+    }
+
+    const std::vector<PeCliMetadataRowLocalConstant> *local_constant_table() const noexcept
     {
-        return read_index(reader, ndx, _header.heap_sizes & 0x01);
+        return _local_constant_table.get();
     }
-    size_t read_guid_heap_index(BytesReader &reader, uint32_t &ndx)
+
+    const std::vector<PeCliMetadataRowImportScope> *import_scope_table() const noexcept
     {
-        return read_index(reader, ndx, _header.heap_sizes & 0x02);
+        return _import_scope_table.get();
     }
-    size_t read_blob_heap_index(BytesReader &reader, uint32_t &ndx)
+
+    const std::vector<PeCliMetadataRowStateMachineMethod> *state_machine_method_table() const noexcept
     {
-        return read_index(reader, ndx, _header.heap_sizes & 0x04);
+        return _state_machine_method_table.get();
     }
-    // ECMA spec does not specify information about the width of indexes into the #US heap.
-    // It appears that none of the metadata tables contain indexes into the #US heap,
-    // so there is no read_us_heap_index function.
 
-    bool needs_wide_index(PeCliMetadataTableId id, uint32_t threshold = 65535);
-    bool needs_wide_index(const std::vector<PeCliMetadataTableId> &ids, uint32_t threshold);
-    bool needs_wide_index(PeCliEncodedIndexType index_type);
+    const std::vector<PeCliMetadataRowCustomDebugInformation> *custom_debug_information_table() const noexcept
+    {
+        return _custom_debug_information_table.get();
+    }
 
+private:
+    template<typename Fn>
+    void visit_table(PeCliMetadataTableId id, Fn &&fn);
+    template<typename Row>
+    void decode_rows(std::vector<Row> &table, uint32_t first, uint32_t last) const noexcept;
 
+    SharedBytes                         _stream;
     PeCliMetadataTablesStreamHeader     _header;
     std::vector<PeCliMetadataTableId>   _valid_table_types;
+    PeCliMetadataSchema                 _schema;
+    std::unique_ptr<PeCliMetadataRelations> _relations;
 
     // A std::unique_ptr for each table type. Null pointers indicate the table does not exist.
     std::unique_ptr<std::vector<PeCliMetadataRowAssembly>>              _assembly_table;
@@ -1518,20 +2923,61 @@ private:
     std::unique_ptr<std::vector<PeCliMetadataRowTypeDef>>               _type_def_table;
     std::unique_ptr<std::vector<PeCliMetadataRowTypeRef>>               _type_ref_table;
     std::unique_ptr<std::vector<PeCliMetadataRowTypeSpec>>              _type_spec_table;
-};
-
-/// \brief  Structure returned by the PeCliMetadata::decode_index function.
-struct PeCliMetadataTableIndex
+    std::unique_ptr<std::vector<PeCliMetadataRowFieldPtr>>              _field_ptr_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowMethodPtr>>             _method_ptr_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowParamPtr>>              _param_ptr_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowEventPtr>>              _event_ptr_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowPropertyPtr>>           _property_ptr_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowENCLog>>                _enc_log_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowENCMap>>                _enc_map_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowDocument>>              _document_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowMethodDebugInformation>>    _method_debug_information_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowLocalScope>>            _local_scope_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowLocalVariable>>         _local_variable_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowLocalConstant>>         _local_constant_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowImportScope>>           _import_scope_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowStateMachineMethod>>    _state_machine_method_table;
+    std::unique_ptr<std::vector<PeCliMetadataRowCustomDebugInformation>>    _custom_debug_information_table;
+};
+
+/// \brief  Identifies the CLI metadata streams that the library interprets.
+enum class PeCliStreamId
+{
+    Tables,         ///< The \#~ stream, or the uncompressed \#- stream
+    Strings,        ///< The \#Strings heap
+    UserStrings,    ///< The \#US heap
+    Guid,           ///< The \#GUID heap
+    Blob,           ///< The \#Blob heap
+    Pdb             ///< The \#Pdb stream of a Portable PDB
+};
+
+/// \brief  The sizes of the streams of CLI metadata and of the tables
+///         within them, as returned by PeCliMetadata::statistics().
+///
+/// The size of a stream the metadata does not contain is zero.
+struct PeCliMetadataStatistics
 {
-    PeCliMetadataTableId    table_id;   ///< The identifier of the table to be indexed
-    uint32_t                index;      ///< The actual index value
+    uint32_t    streams_size{0};        ///< Total size of all streams, including any the library does not interpret
+    uint32_t    tables_stream_size{0};  ///< Size of the \#~ or \#- stream
+    uint32_t    strings_size{0};        ///< Size of the \#Strings heap
+    uint32_t    user_strings_size{0};   ///< Size of the \#US heap
+    uint32_t    guid_size{0};           ///< Size of the \#GUID heap
+    uint32_t    blob_size{0};           ///< Size of the \#Blob heap
+    uint32_t    pdb_size{0};            ///< Size of the \#Pdb stream
+    PeCliMetadataTablesStatistics   tables; ///< The tables; empty if they were not loaded
 };
 
+class PeCliTypeNameIndex;
+
 /// \brief  Contains the CLI metadata from a managed PE
+///
+/// The metadata of a standalone Portable PDB file, which has the same form,
+/// can be read by calling load() with the stream positioned at the start of the file.
 class PeCliMetadata
 {
 public:
-    PeCliMetadata() = default;
+    PeCliMetadata();
+    ~PeCliMetadata();
     PeCliMetadata(const PeCliMetadata &) = delete;              ///< The copy constructor is deleted
     PeCliMetadata(PeCliMetadata &&) = delete;                   ///< The copy constructor is deleted
     PeCliMetadata &operator=(const PeCliMetadata &) = delete;   ///< The copy assignment operator is deleted
@@ -1549,7 +2995,7 @@ public:
         return _stream_headers;
     }
 
-    const std::vector<std::vector<uint8_t>> &streams() const noexcept
+    const std::vector<SharedBytes> &streams() const noexcept
     {
         return _streams;
     }
@@ -1559,29 +3005,70 @@ public:
     ///         if the stream was not found.
     const std::vector<uint8_t> *get_stream(const std::string &stream_name) const
     {
-        static const std::vector<uint8_t> empty;
-
-        for (uint32_t i = 0; i < header().stream_count; ++i)
+        for (size_t i = 0; i < streams().size(); ++i)
         {
             if (stream_headers().at(i).name == stream_name)
-                return &(streams().at(i));
+                return &(streams().at(i).vector());
         }
 
         return nullptr;
     }
 
+    /// \brief  Return the index into stream_headers() of a well-known stream,
+    ///         or -1 if the metadata does not contain the stream.
+    int stream_index(PeCliStreamId id) const noexcept
+    {
+        return _stream_indexes[static_cast<size_t>(id)];
+    }
+
+    /// \brief  Return the content of a well-known stream.
+    ///
+    /// The view is empty if the metadata does not contain the stream or
+    /// the streams were not loaded.
+    BytesView stream(PeCliStreamId id) const noexcept
+    {
+        return _stream_views[static_cast<size_t>(id)];
+    }
+
     bool has_streams() const noexcept
     {
         return header().stream_count == streams().size();
     }
 
+    /// \brief  Return the \#Strings heap, whose entries may be enumerated
+    ///         or looked up without copying them.
+    const PeCliStringsHeap &strings_heap() const noexcept
+    {
+        return _strings_heap;
+    }
+
+    /// \brief  Return the \#US heap, whose entries may be enumerated
+    ///         or looked up without copying them.
+    const PeCliUserStringsHeap &user_strings_heap() const noexcept
+    {
+        return _user_strings_heap;
+    }
+
+    /// \brief  Return the \#Blob heap, whose entries may be enumerated
+    ///         or looked up without copying them.
+    const PeCliBlobHeap &blob_heap() const noexcept
+    {
+        return _blob_heap;
+    }
+
     /// \brief  Return a vector of strings as contained in the CLI \#Strings stream.
+    ///
+    /// Each string is copied; strings_heap() provides the same strings as views.
     std::vector<std::string> get_strings_heap_strings() const;
 
     /// \brief  Return a vector of std::u16strings as contained in the CLI \#US stream.
+    ///
+    /// Each string is copied; user_strings_heap() provides the same strings as views.
     std::vector<std::u16string> get_us_heap_strings() const;
 
     /// \brief  Return a vector of vectors of byte blobs as contained in the CLI \#Blob stream.
+    ///
+    /// Each blob is copied; blob_heap() provides the same blobs as views.
     std::vector<std::vector<uint8_t>> get_blob_heap_blobs() const;
 
     /// \brief  Return a vector of Guid structures as contained in the CLI \#GUID stream.
@@ -1599,6 +3086,22 @@ public:
     /// \param index    Index of the Blob to retrieve.
     const std::vector<uint8_t> get_blob(uint32_t index) const;
 
+    /// \brief  Return a view of a string in the \#Strings heap, without copying it.
+    /// \param index    Index of the string, which is its offset within the heap.
+    ///
+    /// The view is empty if there is no \#Strings heap. A \c std::out_of_range
+    /// exception is thrown if \p index is outside the heap or the string is
+    /// not terminated within it.
+    StringView get_string_view(uint32_t index) const;
+
+    /// \brief  Return a view of a blob in the \#Blob heap, without copying it.
+    /// \param index    Index of the blob, which is the offset of its length prefix within the heap.
+    ///
+    /// The view is empty if there is no \#Blob heap. A \c std::out_of_range
+    /// exception is thrown if \p index is outside the heap or the blob
+    /// extends beyond it.
+    BytesView get_blob_view(uint32_t index) const;
+
     /// \brief  Return a raw pointer to a PeCLiMetadataTables structure containing the parsed CLI \#~ stream.
     const PeCliMetadataTables *metadata_tables() const noexcept
     {
@@ -1610,15 +3113,64 @@ public:
         return _tables != nullptr;
     }
 
+    /// \brief  Return the sizes of the streams and of the tables.
+    ///
+    /// The stream sizes are taken from the stream headers, so they are
+    /// known even if the streams were not loaded. The table statistics are
+    /// computed as by PeCliMetadataTables::statistics(), without decoding any rows.
+    PeCliMetadataStatistics statistics() const;
+
+    /// \brief  Return the content of the \#Pdb stream, or \c nullptr if the
+    ///         metadata is not that of a Portable PDB or the streams were not loaded.
+    const PeCliPdbStream *pdb_stream() const noexcept
+    {
+        return _pdb.get();
+    }
+
     PeCliMetadataTableIndex decode_index(PeCliEncodedIndexType type, uint32_t index) const;
 
+    /// \brief  Return the index of the fully-qualified names of the TypeDef
+    ///         and TypeRef rows. Declared in CliTypeNames.h.
+    ///
+    /// The index is built the first time it is requested, which may be
+    /// done concurrently from several threads.
+    const PeCliTypeNameIndex &type_names() const;
+
+    /// \brief  Replace each metadata stream with the copy held in \p store,
+    ///         adding it to the store if it is not already there.
+    ///
+    /// Any view of a stream taken beforehand, such as a string or blob
+    /// view, a heap iterator, or a table view, may be left dangling; see
+    /// ExeInfo::share_data().
+    void share_data(BlobStore &store)
+    {
+        for (auto &stream : _streams)
+            stream = store.intern(stream);
+        if (_tables)
+            _tables->share_data(store);
+        update_stream_views();
+    }
+
 private:
-    void load_metadata_tables();
+    static constexpr size_t stream_id_count{6};
+
+    void resolve_streams();
+    void update_stream_views();
+    void load_pdb_stream();
+    void load_metadata_tables(bool load_rows, bool concurrently);
 
     PeCliMetadataHeader                     _metadata_header;
     std::vector<PeCliStreamHeader>          _stream_headers;
-    std::vector<std::vector<uint8_t>>       _streams;   // all metadata streams
-    std::unique_ptr<PeCliMetadataTables>    _tables;    // from the #~ stream
+    std::vector<SharedBytes>                _streams;       // all metadata streams
+    std::unique_ptr<PeCliMetadataTables>    _tables;        // from the #~ stream
+    std::unique_ptr<PeCliPdbStream>         _pdb;           // from the #Pdb stream
+    int                                     _stream_indexes[stream_id_count]{-1, -1, -1, -1, -1, -1};   // indexed by PeCliStreamId
+    BytesView                               _stream_views[stream_id_count];     // indexed by PeCliStreamId
+    PeCliStringsHeap                        _strings_heap;
+    PeCliUserStringsHeap                    _user_strings_heap;
+    PeCliBlobHeap                           _blob_heap;
+    mutable std::once_flag                  _type_names_once;
+    mutable std::unique_ptr<PeCliTypeNameIndex> _type_names;   // built on first use
 };
 
 /// \brief Represents the CLI portion, if any, of the PE executable.
@@ -1670,6 +3222,14 @@ public:
         return _metadata != nullptr;
     }
 
+    /// \brief  Replace the metadata streams with the copies held in \p store.
+    ///         See PeCliMetadata::share_data().
+    void share_data(BlobStore &store)
+    {
+        if (_metadata)
+            _metadata->share_data(store);
+    }
+
 private:
     std::streamoff                  _file_offset;
     const PeSection                &_section;
@@ -1692,6 +3252,7 @@ public:
     using SectionTable      = std::vector<PeSection>;
     using ImportDirectory   = std::vector<PeImportDirectoryEntry>;
     using DebugDirectory    = std::vector<PeDebugDirectoryEntry>;
+    using CertificateTable  = std::vector<PeCertificate>;
 
 
     /// \brief  Construct a \c PeExeInfo object from a stream.
@@ -1817,6 +3378,60 @@ public:
         return _debug_directory;
     }
 
+    /// \brief  Return a reference to the Attribute Certificate Table.
+    ///
+    /// The table is loaded only if the LoadOptions::LoadCertificates option
+    /// is specified. Each entry's certificate is a view of bytes held by
+    /// this object; no per-entry copies are made.
+    const CertificateTable &certificates() const noexcept
+    {
+        return _certificates;
+    }
+
+    /// \brief  Return \c true if the Attribute Certificate Table was loaded
+    ///         and is not empty, \c false otherwise.
+    bool has_certificates() const noexcept
+    {
+        return !_certificates.empty();
+    }
+
+    /// \brief  Return a view of the Attribute Certificate Table within \p image.
+    /// \param image    The complete file, typically memory-mapped.
+    ///
+    /// This locates the table without loading it, for use with
+    /// parse_certificate_table(). The view is empty if there is no table.
+    BytesView certificate_table_view(BytesView image) const noexcept;
+
+    /// \brief  Return the file position at which the overlay begins.
+    ///
+    /// The overlay is any data appended to the file after the raw data of
+    /// the last section, such as an installer payload. If the file is no
+    /// longer than this position, it has no overlay.
+    uint64_t overlay_position() const noexcept
+    {
+        uint64_t    rv{0};
+
+        for (const auto &section : _sections)
+            if (section.header().raw_data_position)
+                rv = std::max(rv, static_cast<uint64_t>(section.header().raw_data_position) + section.raw_data_size());
+
+        return rv;
+    }
+
+    /// \brief  Replace the raw data of each section, and the CLI metadata
+    ///         streams, with the copies held in \p store, adding them to the
+    ///         store if they are not already there.
+    ///
+    /// Views of that data taken beforehand may be left dangling; see
+    /// ExeInfo::share_data().
+    void share_data(BlobStore &store)
+    {
+        for (auto &section : _sections)
+            section.share_data(store);
+        if (_cli)
+            _cli->share_data(store);
+    }
+
 private:
     size_t                                  _header_position;   // Absolute position in the file of the PE header. Useful for offset calculations.
     PeImageFileHeader                       _image_file_header; // The PE image file header structure for this file.
@@ -1829,6 +3444,8 @@ private:
     DebugDirectory                          _debug_directory;   // The Debug Directory
     std::unique_ptr<PeCli>                  _cli;               // CLI information if the PE image is managed code.
     std::unique_ptr<PeResourceDirectory>    _resource_directory;    // The Resource Directory
+    std::vector<uint8_t>                    _certificate_data;  // The raw Attribute Certificate Table
+    CertificateTable                        _certificates;      // Entries of the Attribute Certificate Table, viewing _certificate_data
 
 
 
@@ -1841,6 +3458,7 @@ private:
     void load_debug_directory(std::istream &stream, LoadOptions::Options options);
     void load_cli(std::istream &stream, LoadOptions::Options options);
     void load_resource_info(std::istream &stream, LoadOptions::Options options);
+    void load_certificates(std::istream &stream);
     std::unique_ptr<PeResourceDirectory> load_resource_directory(std::istream &stream, size_t level, uint32_t offset, std::streampos base);
     std::unique_ptr<PeResourceDataEntry> load_resource_data_entry(std::istream &stream, uint32_t offset, std::streampos base);
 };
@@ -1871,4 +3489,26 @@ inline std::streamoff get_file_offset(uint32_t rva, const PeSection &section) no
     return static_cast<std::streamoff>(rva) - section.virtual_address() + section.header().raw_data_position;
 }
 
+/// \brief  Find the section whose raw data contains the given file offset.
+/// \return A pointer to the section, or \c nullptr if the offset falls in the
+///         headers, in the overlay, or in the padding between sections.
+inline const PeSection *find_section_by_file_offset(uint64_t offset, const std::vector<PeSection> &sections) noexcept
+{
+    for (const auto &section : sections)
+    {
+        uint64_t    begin{section.header().raw_data_position};
+
+        if (begin && offset >= begin && offset < begin + section.raw_data_size())
+            return &section;
+    }
+
+    return nullptr;
+}
+
+/// \brief  Return the RVA corresponding to a file offset within a section.
+inline uint32_t get_rva(uint64_t offset, const PeSection &section) noexcept
+{
+    return static_cast<uint32_t>(offset - section.header().raw_data_position + section.virtual_address());
+}
+
 #endif  //_EXELIB_PEEXE_H_
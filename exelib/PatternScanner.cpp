@@ -0,0 +1,449 @@
+/// \file   PatternScanner.cpp
+/// Implementation of the PatternScanner class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PatternScanner.h"
+
+namespace {
+
+// Bytes so common in executables that an anchor containing them matches
+// more often than it should. Used to pick the most selective anchor.
+bool is_common_byte(uint8_t byte)
+{
+    return byte == 0x00 || byte == 0xFF || byte == 0xCC || byte == 0x90;
+}
+
+// Scanning proceeds in chunks of this size so that the automaton's pass
+// over each chunk finds the bytes still in the cache from the filter's pass.
+constexpr size_t    chunk_size{64 * 1024};
+
+int hex_digit_value(char ch)
+{
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+}   // anonymous namespace
+
+// C++14 requires a definition of a static data member that is odr-used.
+constexpr size_t PatternScanner::key_length;
+
+
+void PatternScanner::add_pattern(uint32_t id, const uint8_t *bytes, const uint8_t *mask, size_t length)
+{
+    Pattern pattern;
+
+    pattern.id = id;
+    pattern.bytes.assign(bytes, bytes + length);
+    if (mask)
+        pattern.mask.assign(mask, mask + length);
+    else
+        pattern.mask.assign(length, 0xFF);
+
+    // Apply the mask to the pattern bytes so verification can compare directly.
+    for (size_t i = 0; i < length; ++i)
+        pattern.bytes[i] &= pattern.mask[i];
+
+    // Find the longest run of fully-specified bytes. If it is long enough,
+    // the anchor is the window of four bytes within it containing the
+    // fewest common bytes; otherwise the anchor is the entire run.
+    size_t  run_offset{0};
+    size_t  run_length{0};
+
+    for (size_t i = 0; i < length; )
+    {
+        if (pattern.mask[i] != 0xFF)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t  run_start{i};
+
+        while (i < length && pattern.mask[i] == 0xFF)
+            ++i;
+
+        if (i - run_start > run_length)
+        {
+            run_offset = run_start;
+            run_length = i - run_start;
+        }
+    }
+
+    if (run_length == 0)
+        throw std::invalid_argument("Pattern must contain at least one byte without wildcards.");
+
+    pattern.anchor_offset = run_offset;
+    pattern.anchor_length = std::min(run_length, key_length);
+    pattern.key = 0;
+
+    if (run_length >= key_length)
+    {
+        size_t  best_common{key_length + 1};
+
+        for (size_t i = run_offset; i + key_length <= run_offset + run_length; ++i)
+        {
+            size_t  common = std::count_if(&pattern.bytes[i], &pattern.bytes[i] + key_length, is_common_byte);
+
+            if (common < best_common)
+            {
+                best_common = common;
+                pattern.anchor_offset = i;
+            }
+        }
+
+        std::memcpy(&pattern.key, &pattern.bytes[pattern.anchor_offset], key_length);
+    }
+
+    _patterns.push_back(std::move(pattern));
+    _compiled = false;
+}
+
+void PatternScanner::add_pattern(uint32_t id, const std::string &pattern)
+{
+    std::vector<uint8_t>    bytes;
+    std::vector<uint8_t>    mask;
+    size_t                  i{0};
+
+    while (i < pattern.size())
+    {
+        if (std::isspace(static_cast<unsigned char>(pattern[i])))
+        {
+            ++i;
+            continue;
+        }
+
+        if (i + 1 >= pattern.size())
+            throw std::invalid_argument("Incomplete byte in pattern \"" + pattern + "\".");
+
+        uint8_t byte{0};
+        uint8_t byte_mask{0};
+
+        for (size_t n = 0; n < 2; ++n)
+        {
+            char    ch{pattern[i + n]};
+
+            byte <<= 4;
+            byte_mask <<= 4;
+            if (ch != '?')
+            {
+                int value{hex_digit_value(ch)};
+
+                if (value < 0)
+                    throw std::invalid_argument("Invalid character in pattern \"" + pattern + "\".");
+                byte |= static_cast<uint8_t>(value);
+                byte_mask |= 0x0F;
+            }
+        }
+
+        bytes.push_back(byte);
+        mask.push_back(byte_mask);
+        i += 2;
+    }
+
+    add_pattern(id, bytes.data(), mask.data(), bytes.size());
+}
+
+void PatternScanner::compile()
+{
+    compile_filter();
+    compile_automaton();
+    _compiled = true;
+}
+
+void PatternScanner::compile_filter()
+{
+    size_t  count = std::count_if(_patterns.begin(), _patterns.end(),
+                                  [](const Pattern &p) { return p.anchor_length == key_length; });
+
+    // Size the filter at roughly 64 bits per pattern, which keeps false
+    // positives rare while the filter still fits comfortably in the cache.
+    _filter_bits = 10;
+    while (_filter_bits < 22 && (size_t{1} << _filter_bits) < count * 64)
+        ++_filter_bits;
+
+    const size_t    bucket_count{size_t{1} << _filter_bits};
+
+    _filter.assign(bucket_count / 32, 0);
+    _bucket_begin.assign(bucket_count + 1, 0);
+    _bucket_patterns.assign(count, 0);
+
+    for (const auto &pattern : _patterns)
+        if (pattern.anchor_length == key_length)
+            ++_bucket_begin[hash_key(pattern.key) + 1];
+
+    for (size_t b = 0; b < bucket_count; ++b)
+        _bucket_begin[b + 1] += _bucket_begin[b];
+
+    std::vector<uint32_t>   fill(_bucket_begin.begin(), _bucket_begin.end() - 1);
+
+    for (uint32_t p = 0; p < _patterns.size(); ++p)
+    {
+        if (_patterns[p].anchor_length != key_length)
+            continue;
+
+        uint32_t    hash{hash_key(_patterns[p].key)};
+
+        _filter[hash / 32] |= 1u << (hash % 32);
+        _bucket_patterns[fill[hash]++] = p;
+    }
+}
+
+void PatternScanner::compile_automaton()
+{
+    // Build a trie of the short anchors. State zero is the root; since no
+    // state can transition back into the root as a child, zero marks "no child".
+    std::vector<uint32_t>               children(256, 0);
+    std::vector<std::vector<uint32_t>>  outputs(1);
+
+    for (uint32_t p = 0; p < _patterns.size(); ++p)
+    {
+        if (_patterns[p].anchor_length == key_length)
+            continue;
+
+        const auto *anchor{_patterns[p].bytes.data() + _patterns[p].anchor_offset};
+        uint32_t    state{0};
+
+        for (size_t i = 0; i < _patterns[p].anchor_length; ++i)
+        {
+            auto   &child{children[(static_cast<size_t>(state) << 8) | anchor[i]]};
+
+            if (child == 0)
+            {
+                child = static_cast<uint32_t>(outputs.size());
+                outputs.emplace_back();
+                children.resize(children.size() + 256, 0);
+            }
+            state = children[(static_cast<size_t>(state) << 8) | anchor[i]];
+        }
+
+        outputs[state].push_back(p);
+    }
+
+    if (outputs.size() == 1)
+    {
+        // No short patterns, so no automaton.
+        _transitions.clear();
+        _output_begin.clear();
+        _outputs.clear();
+        return;
+    }
+
+    // Convert the trie into a complete transition table by following
+    // failure links breadth-first, so that every state's failure state
+    // has been finished before the state itself is visited.
+    const size_t            state_count{outputs.size()};
+    std::vector<uint32_t>   failure(state_count, 0);
+    std::deque<uint32_t>    queue;
+
+    _transitions.assign(state_count * 256, 0);
+
+    for (size_t c = 0; c < 256; ++c)
+    {
+        uint32_t    child{children[c]};
+
+        _transitions[c] = child;
+        if (child)
+            queue.push_back(child);
+    }
+
+    while (!queue.empty())
+    {
+        uint32_t    state{queue.front()};
+
+        queue.pop_front();
+
+        const auto &fail_outputs{outputs[failure[state]]};
+
+        outputs[state].insert(outputs[state].end(), fail_outputs.begin(), fail_outputs.end());
+
+        for (size_t c = 0; c < 256; ++c)
+        {
+            size_t      slot{(static_cast<size_t>(state) << 8) | c};
+            uint32_t    child{children[slot]};
+            uint32_t    fail_target{_transitions[(static_cast<size_t>(failure[state]) << 8) | c]};
+
+            if (child)
+            {
+                failure[child] = fail_target;
+                _transitions[slot] = child;
+                queue.push_back(child);
+            }
+            else
+            {
+                _transitions[slot] = fail_target;
+            }
+        }
+    }
+
+    // Flatten the outputs and flag the transitions leading to states that have any.
+    _output_begin.resize(state_count + 1);
+    _outputs.clear();
+    for (size_t s = 0; s < state_count; ++s)
+    {
+        _output_begin[s] = static_cast<uint32_t>(_outputs.size());
+        _outputs.insert(_outputs.end(), outputs[s].begin(), outputs[s].end());
+    }
+    _output_begin[state_count] = static_cast<uint32_t>(_outputs.size());
+
+    for (auto &target : _transitions)
+        if (_output_begin[target] != _output_begin[target + 1])
+            target |= output_flag;
+}
+
+bool PatternScanner::verify(const Pattern &pattern, const uint8_t *begin, const uint8_t *end, const uint8_t *start) const noexcept
+{
+    if (start < begin || static_cast<size_t>(end - start) < pattern.bytes.size())
+        return false;
+
+    for (size_t i = 0; i < pattern.bytes.size(); ++i)
+        if ((start[i] & pattern.mask[i]) != pattern.bytes[i])
+            return false;
+
+    return true;
+}
+
+void PatternScanner::scan(BytesView bytes, uint64_t base_offset, const Callback &callback) const
+{
+    if (!compiled())
+        throw std::logic_error("PatternScanner::compile must be called before scanning.");
+
+    const uint8_t  *begin{bytes.data()};
+    const uint8_t  *end{begin + bytes.size()};
+    const uint32_t *filter{_filter.data()};
+    const uint32_t *table{_transitions.data()};
+    const bool      use_filter{!_bucket_patterns.empty()};
+    const bool      use_automaton{!_transitions.empty()};
+    uint32_t        state{0};
+
+    auto report = [&](const Pattern &pattern, const uint8_t *start)
+                  {
+                      if (verify(pattern, begin, end, start))
+                          callback(PatternMatch{pattern.id, base_offset + static_cast<uint64_t>(start - begin), 0, PeImageRegion::Unmapped, nullptr});
+                  };
+
+    for (const uint8_t *chunk = begin; chunk < end; )
+    {
+        const uint8_t  *chunk_end{static_cast<size_t>(end - chunk) > chunk_size ? chunk + chunk_size : end};
+
+        if (use_filter && end - begin >= static_cast<ptrdiff_t>(key_length))
+        {
+            const uint8_t  *last{std::min(chunk_end, end - key_length + 1)};
+
+            for (const uint8_t *ptr = chunk; ptr < last; ++ptr)
+            {
+                uint32_t    key;
+
+                std::memcpy(&key, ptr, key_length);
+
+                uint32_t    hash{hash_key(key)};
+
+                if ((filter[hash / 32] & (1u << (hash % 32))) == 0)
+                    continue;
+
+                for (uint32_t b = _bucket_begin[hash]; b < _bucket_begin[hash + 1]; ++b)
+                {
+                    const auto &pattern{_patterns[_bucket_patterns[b]]};
+
+                    if (pattern.key == key && static_cast<size_t>(ptr - begin) >= pattern.anchor_offset)
+                        report(pattern, ptr - pattern.anchor_offset);
+                }
+            }
+        }
+
+        if (use_automaton)
+        {
+            for (const uint8_t *ptr = chunk; ptr < chunk_end; ++ptr)
+            {
+                uint32_t    next{table[(static_cast<size_t>(state) << 8) | *ptr]};
+
+                if (next & output_flag)
+                {
+                    next &= ~output_flag;
+
+                    for (uint32_t o = _output_begin[next]; o < _output_begin[next + 1]; ++o)
+                    {
+                        const auto &pattern{_patterns[_outputs[o]]};
+                        const auto  back{pattern.anchor_offset + pattern.anchor_length - 1};
+
+                        if (static_cast<size_t>(ptr - begin) >= back)
+                            report(pattern, ptr - back);
+                    }
+                }
+
+                state = next;
+            }
+        }
+
+        chunk = chunk_end;
+    }
+}
+
+void PatternScanner::scan_image(const PeExeInfo &pe, BytesView image, const Callback &callback) const
+{
+    const auto &sections{pe.sections()};
+    uint64_t    first_section{pe.overlay_position()};
+    uint64_t    overlay{first_section};
+
+    for (const auto &section : sections)
+        if (section.header().raw_data_position)
+            first_section = std::min(first_section, static_cast<uint64_t>(section.header().raw_data_position));
+
+    scan(image, 0, [&](const PatternMatch &match)
+                   {
+                       PatternMatch    rv{match};
+
+                       rv.section = find_section_by_file_offset(rv.file_offset, sections);
+                       if (rv.section)
+                       {
+                           rv.region = PeImageRegion::Section;
+                           rv.rva = get_rva(rv.file_offset, *rv.section);
+                       }
+                       else if (rv.file_offset < first_section)
+                       {
+                           rv.region = PeImageRegion::Headers;
+                       }
+                       else if (rv.file_offset >= overlay)
+                       {
+                           rv.region = PeImageRegion::Overlay;
+                       }
+
+                       callback(rv);
+                   });
+}
+
+void PatternScanner::scan_sections(const PeExeInfo &pe, const Callback &callback) const
+{
+    for (const auto &section : pe.sections())
+    {
+        if (!section.data_loaded() || section.data().empty())
+            continue;
+
+        scan(section.data(), section.header().raw_data_position,
+             [&](const PatternMatch &match)
+             {
+                 PatternMatch   rv{match};
+
+                 rv.region = PeImageRegion::Section;
+                 rv.section = &section;
+                 rv.rva = get_rva(rv.file_offset, section);
+
+                 callback(rv);
+             });
+    }
+}
@@ -0,0 +1,161 @@
+/// \file   PatternScanner.h
+/// Provides the PatternScanner class for searching executable images for
+/// many byte signatures, including wildcards, in a single pass.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_PATTERNSCANNER_H_
+#define _EXELIB_PATTERNSCANNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  Identifies the part of a PE image in which a match was found.
+enum class PeImageRegion
+{
+    Headers,    ///< Before the raw data of the first section.
+    Section,    ///< Within the raw data of a section.
+    Overlay,    ///< After the raw data of the last section.
+    Unmapped    ///< Between sections, in file padding not belonging to any section.
+};
+
+/// \brief  Describes a single match reported by the PatternScanner.
+struct PatternMatch
+{
+    uint32_t            pattern_id;     ///< The identifier given when the pattern was added.
+    uint64_t            file_offset;    ///< File offset of the first byte of the match.
+    uint32_t            rva;            ///< RVA of the first byte of the match. Zero unless \c region is PeImageRegion::Section.
+    PeImageRegion       region;         ///< The part of the image in which the match was found.
+    const PeSection    *section;        ///< The section containing the match, or \c nullptr.
+};
+
+/// \brief  Searches bytes for any number of signatures in a single pass.
+///
+/// Each pattern is a sequence of bytes, any of which may be wholly or
+/// partially wildcarded through a mask. For each pattern the scanner picks
+/// four consecutive fixed (non-wildcard) bytes as an anchor and records the
+/// anchor's hash in a compact bit filter. Scanning tests the four bytes at
+/// each position against the filter, which is small enough to stay in the
+/// cache, and only verifies complete patterns, wildcards and all, where the
+/// filter and the anchor itself match. Patterns having no run of four fixed
+/// bytes are matched with a (necessarily small) Aho-Corasick automaton in
+/// the same pass. Scanning is linear in the size of the input no matter how
+/// many patterns are added.
+///
+/// Add all the patterns, call #compile(), then scan as many inputs as
+/// needed. A compiled scanner is not modified by scanning, so one instance
+/// may be shared by several threads.
+class PatternScanner
+{
+public:
+    using Callback = std::function<void(const PatternMatch &)>;
+
+    PatternScanner() = default;
+
+    /// \brief  Add a pattern to the scanner.
+    /// \param id       An identifier reported with each match of this pattern.
+    /// \param bytes    The bytes of the pattern.
+    /// \param mask     A mask the same length as \p bytes. Bits set in a mask byte
+    ///                 must match the corresponding pattern byte; clear bits are
+    ///                 wildcards. Pass \c nullptr if the pattern has no wildcards.
+    /// \param length   The number of bytes in the pattern.
+    ///
+    /// A pattern must contain at least one byte with no wildcard bits.
+    /// Adding a pattern requires the scanner to be compiled again.
+    void add_pattern(uint32_t id, const uint8_t *bytes, const uint8_t *mask, size_t length);
+
+    /// \brief  Add a pattern expressed as a string of hex byte values.
+    /// \param id       An identifier reported with each match of this pattern.
+    /// \param pattern  Hex byte values optionally separated by spaces, such as
+    ///                 "4D 5A ?? 00 5?". A question mark in place of a hex digit
+    ///                 is a wildcard for that nibble.
+    void add_pattern(uint32_t id, const std::string &pattern);
+
+    /// \brief  Return the number of patterns added to the scanner.
+    size_t pattern_count() const noexcept
+    {
+        return _patterns.size();
+    }
+
+    /// \brief  Build the anchor filter and automaton. This must be called before scanning.
+    void compile();
+
+    /// \brief  Return \c true if the scanner has been compiled.
+    bool compiled() const noexcept
+    {
+        return _compiled;
+    }
+
+    /// \brief  Scan a block of bytes for all patterns.
+    /// \param bytes        The bytes to scan.
+    /// \param base_offset  Value added to each match position to produce
+    ///                     the reported \c file_offset.
+    /// \param callback     Function called once for each match. Only the
+    ///                     \c pattern_id and \c file_offset members are set;
+    ///                     \c region is PeImageRegion::Unmapped.
+    ///
+    /// Matches are reported roughly, but not strictly, in the order of
+    /// their positions.
+    /// Matches that would extend beyond either end of \p bytes are not reported.
+    void scan(BytesView bytes, uint64_t base_offset, const Callback &callback) const;
+
+    /// \brief  Scan an entire PE file image in a single pass.
+    /// \param pe           The PE portion of the executable loaded from \p image.
+    /// \param image        The complete file, typically memory-mapped.
+    /// \param callback     Function called once for each match, with the
+    ///                     match's RVA and section filled in from the section table.
+    void scan_image(const PeExeInfo &pe, BytesView image, const Callback &callback) const;
+
+    /// \brief  Scan the raw data of each section of a PE executable.
+    ///
+    /// This requires the section data to have been loaded using the
+    /// LoadOptions::LoadSectionData option. Sections whose data was not
+    /// loaded are skipped. Matches spanning two sections are not reported.
+    void scan_sections(const PeExeInfo &pe, const Callback &callback) const;
+
+private:
+    struct Pattern
+    {
+        uint32_t                id;
+        std::vector<uint8_t>    bytes;
+        std::vector<uint8_t>    mask;
+        size_t                  anchor_offset;  // position within the pattern of the fixed bytes used as the anchor
+        size_t                  anchor_length;  // number of anchor bytes; four unless the pattern has no longer fixed run
+        uint32_t                key;            // the four anchor bytes, for patterns using the filter
+    };
+
+    static constexpr size_t     key_length{sizeof(uint32_t)};
+    static constexpr uint32_t   output_flag{0x80000000};    // set in a transition when the target state has output
+
+    uint32_t hash_key(uint32_t key) const noexcept
+    {
+        return (key * 0x9E3779B1u) >> (32 - _filter_bits);
+    }
+
+    bool verify(const Pattern &pattern, const uint8_t *begin, const uint8_t *end, const uint8_t *start) const noexcept;
+    void compile_filter();
+    void compile_automaton();
+
+    std::vector<Pattern>    _patterns;
+    bool                    _compiled{false};
+
+    // The anchor filter, for patterns with at least four fixed bytes in a row.
+    unsigned                _filter_bits{0};
+    std::vector<uint32_t>   _filter;            // one bit per hash value
+    std::vector<uint32_t>   _bucket_begin;      // per hash value, index into _bucket_patterns; one extra entry at the end
+    std::vector<uint32_t>   _bucket_patterns;   // pattern indexes, grouped by hash value
+
+    // The Aho-Corasick automaton, for the remaining patterns.
+    std::vector<uint32_t>   _transitions;       // 256 entries per state; the full DFA
+    std::vector<uint32_t>   _output_begin;      // per state, index into _outputs; one extra entry at the end
+    std::vector<uint32_t>   _outputs;           // pattern indexes, grouped by state
+};
+
+#endif  //_EXELIB_PATTERNSCANNER_H_
@@ -0,0 +1,200 @@
+/// \file   SingleFileBundle.cpp
+/// Implementation of the SingleFileBundle class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
+
+#include "readers.h"
+#include "SingleFileBundle.h"
+
+namespace {
+
+// The SHA-256 hash of ".net core bundle", which the host contains so that
+// the bundler can find the place to record the offset of the manifest.
+constexpr uint8_t   bundle_signature[32]
+{
+    0x8B, 0x12, 0x02, 0xB9, 0x6A, 0x61, 0x20, 0x38, 0x72, 0x7B, 0x93, 0x02, 0x14, 0xD7, 0xA0, 0x32,
+    0x13, 0xF5, 0xB9, 0xE6, 0xEF, 0xAE, 0x33, 0x18, 0xEE, 0x3B, 0x2D, 0xCE, 0x24, 0xB3, 0x6A, 0xAE
+};
+
+constexpr uint32_t  max_supported_major_version{6};
+
+// The smallest possible manifest entry: offset, size, type, and an empty path.
+constexpr size_t    min_entry_size{8 + 8 + 1 + 1};
+
+// A read-only stream buffer over a view of memory, so that an embedded
+// file can be read through a std::istream without being copied.
+class BytesStreamBuf : public std::streambuf
+{
+public:
+    explicit BytesStreamBuf(BytesView bytes) noexcept
+    {
+        auto   *begin{const_cast<char *>(reinterpret_cast<const char *>(bytes.data()))};
+
+        setg(begin, begin, begin + bytes.size());
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if ((which & std::ios_base::in) == 0)
+            return pos_type(off_type(-1));
+
+        const off_type  size{egptr() - eback()};
+        off_type        pos{off};
+
+        if (dir == std::ios_base::cur)
+            pos += gptr() - eback();
+        else if (dir == std::ios_base::end)
+            pos += size;
+
+        if (pos < 0 || pos > size)
+            return pos_type(off_type(-1));
+
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+// Read a string written by .NET's BinaryWriter: its length in bytes as a
+// 7-bit encoded integer, followed by that many bytes of UTF-8.
+StringView read_string(BytesReader &reader, BytesView file)
+{
+    uint32_t    length{0};
+    uint8_t     byte;
+    unsigned    shift{0};
+
+    do
+    {
+        if (shift > 28)
+            throw std::runtime_error("Bundle manifest string length is malformed");
+
+        reader.read(byte);
+        length |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    const auto  pos{reader.tell()};
+
+    if (length > file.size() - pos)
+        throw std::out_of_range("Bundle manifest string extends beyond the end of the executable");
+
+    reader.seek(pos + length);
+    return {reinterpret_cast<const char *>(file.data() + pos), length};
+}
+
+}   // anonymous namespace
+
+
+uint64_t SingleFileBundle::find_manifest(BytesView file) noexcept
+{
+    const auto *begin{file.data()};
+    const auto *end{file.data() + file.size()};
+    const auto *p{begin + std::min(file.size(), sizeof(uint64_t))};
+
+    while (end - p >= static_cast<ptrdiff_t>(sizeof(bundle_signature)))
+    {
+        p = static_cast<const uint8_t *>(std::memchr(p, bundle_signature[0], end - p - sizeof(bundle_signature) + 1));
+        if (p == nullptr)
+            break;
+
+        if (std::memcmp(p, bundle_signature, sizeof(bundle_signature)) == 0)
+        {
+            BytesReader reader{file};
+            uint64_t    offset;
+
+            reader.seek(p - begin - sizeof(offset));
+            reader.read(offset);
+
+            return offset < file.size() ? offset : 0;
+        }
+
+        ++p;
+    }
+
+    return 0;
+}
+
+SingleFileBundle::SingleFileBundle(BytesView file)
+  : _file{file},
+    _header{}
+{
+    const auto  manifest{find_manifest(file)};
+
+    if (manifest == 0)
+        throw std::runtime_error("Executable is not a single-file bundle");
+
+    BytesReader reader{file};
+
+    reader.seek(static_cast<size_t>(manifest));
+    reader.read(_header.major_version);
+    reader.read(_header.minor_version);
+    reader.read(_header.file_count);
+
+    if (_header.major_version == 0 || _header.major_version > max_supported_major_version)
+        throw std::runtime_error("Unsupported bundle manifest version");
+
+    _header.bundle_id = read_string(reader, file);
+
+    if (_header.major_version >= 2)
+    {
+        reader.read(_header.deps_json_offset);
+        reader.read(_header.deps_json_size);
+        reader.read(_header.runtime_config_offset);
+        reader.read(_header.runtime_config_size);
+        reader.read(_header.flags);
+    }
+
+    // The count is not trusted to size the vector beyond what the rest of the file could hold.
+    _entries.reserve(std::min<size_t>(_header.file_count, (file.size() - reader.tell()) / min_entry_size));
+    for (uint32_t i = 0; i < _header.file_count; ++i)
+    {
+        BundleEntry entry{};
+        uint8_t     type;
+
+        reader.read(entry.offset);
+        reader.read(entry.size);
+        if (_header.major_version >= 6)
+            reader.read(entry.compressed_size);
+        reader.read(type);
+        entry.type = static_cast<BundleFileType>(type);
+        entry.path = read_string(reader, file);
+
+        if (entry.offset > file.size() || entry.stored_size() > file.size() - entry.offset)
+            throw std::out_of_range("Bundled file extends beyond the end of the executable");
+
+        _entries.push_back(entry);
+    }
+}
+
+const BundleEntry *SingleFileBundle::find_entry(StringView path) const noexcept
+{
+    for (const auto &entry : _entries)
+        if (entry.path == path)
+            return &entry;
+
+    return nullptr;
+}
+
+ExeInfo SingleFileBundle::load(const BundleEntry &entry, LoadOptions::Options options) const
+{
+    if (entry.is_compressed())
+        throw std::runtime_error("Bundled file is compressed");
+
+    BytesStreamBuf  buffer{content(entry)};
+    std::istream    stream{&buffer};
+
+    return ExeInfo{stream, options};
+}
@@ -0,0 +1,151 @@
+/// \file   SingleFileBundle.h
+/// Provides access to the files embedded in a .NET single-file application.
+///
+/// A single-file application is an application host executable with the
+/// application's assemblies, native libraries, and configuration files
+/// appended to it, followed by a manifest listing them. The host contains a
+/// fixed 32-byte signature, immediately preceded by the eight-byte offset of
+/// the manifest; in a host that is not a bundle, that offset is zero.
+///
+/// The files are read in place from a view of the whole executable, such as
+/// one obtained by mapping it into memory, so nothing is extracted.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_SINGLEFILEBUNDLE_H_
+#define _EXELIB_SINGLEFILEBUNDLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ExeInfo.h"
+#include "LoadOptions.h"
+#include "views.h"
+
+
+/// \brief  Kinds of file embedded in a bundle.
+enum class BundleFileType : uint8_t
+{
+    Unknown             = 0,
+    Assembly            = 1,    ///< A managed assembly
+    NativeBinary        = 2,    ///< A native library
+    DepsJson            = 3,    ///< The application's .deps.json file
+    RuntimeConfigJson   = 4,    ///< The application's .runtimeconfig.json file
+    Symbols             = 5     ///< A symbol file, such as a Portable PDB
+};
+
+/// \brief  Flags of a bundle manifest.
+enum class BundleFlags : uint64_t
+{
+    NetCoreApp3CompatMode   = 0x0001    ///< Every file is extracted to disk when the application starts
+};
+
+/// \brief  The header of a bundle manifest.
+struct BundleHeader
+{
+    uint32_t    major_version;          ///< 1 for .NET Core 3, 2 for .NET 5, and 6 from .NET 6 on
+    uint32_t    minor_version;
+    uint32_t    file_count;             ///< Number of embedded files
+    StringView  bundle_id;              ///< Unique identifier of the bundle, used to name its extraction directory
+    uint64_t    deps_json_offset;       ///< Offset of the .deps.json file, or zero. Not present in version 1.
+    uint64_t    deps_json_size;
+    uint64_t    runtime_config_offset;  ///< Offset of the .runtimeconfig.json file, or zero. Not present in version 1.
+    uint64_t    runtime_config_size;
+    uint64_t    flags;                  ///< Combination of BundleFlags values. Not present in version 1.
+};
+
+/// \brief  A file embedded in a bundle.
+struct BundleEntry
+{
+    uint64_t        offset;             ///< Offset of the file's content from the start of the executable
+    uint64_t        size;               ///< Size of the file, in bytes
+    uint64_t        compressed_size;    ///< Size of the stored, deflate-compressed content, or zero if it is stored as is
+    BundleFileType  type;
+    StringView      path;               ///< Path of the file relative to the application directory, in UTF-8
+
+    /// \brief  Return \c true if the content is stored compressed.
+    bool is_compressed() const noexcept
+    {
+        return compressed_size != 0;
+    }
+
+    /// \brief  Return the number of bytes the content occupies in the executable.
+    uint64_t stored_size() const noexcept
+    {
+        return is_compressed() ? compressed_size : size;
+    }
+};
+
+/// \brief  The manifest of a .NET single-file bundle, and views of the
+///         files embedded in it.
+///
+/// The object refers to the view given to its constructor, which must
+/// remain valid for as long as the object and any views or entries
+/// obtained from it are in use.
+class SingleFileBundle
+{
+public:
+    /// \brief  Read the manifest of a bundle.
+    /// \param file The content of the whole executable.
+    ///
+    /// A \c std::runtime_error exception is thrown if \p file is not a
+    /// bundle or its manifest is of an unsupported version, and a
+    /// \c std::out_of_range exception if the manifest or a file listed in
+    /// it extends beyond the end of \p file.
+    explicit SingleFileBundle(BytesView file);
+
+    /// \brief  Return the offset of the bundle manifest within an
+    ///         executable, or zero if the executable is not a bundle.
+    ///
+    /// The executable is searched for the bundle signature, which lies
+    /// within the host and so near its start.
+    static uint64_t find_manifest(BytesView file) noexcept;
+
+    /// \brief  Return \c true if an executable is a single-file bundle.
+    static bool is_bundle(BytesView file) noexcept
+    {
+        return find_manifest(file) != 0;
+    }
+
+    const BundleHeader &header() const noexcept
+    {
+        return _header;
+    }
+
+    /// \brief  Return the embedded files, in manifest order.
+    const std::vector<BundleEntry> &entries() const noexcept
+    {
+        return _entries;
+    }
+
+    /// \brief  Return the embedded file with the given relative path, or
+    ///         \c nullptr if there is none. Paths are compared exactly.
+    const BundleEntry *find_entry(StringView path) const noexcept;
+
+    /// \brief  Return a view of the content of an embedded file as it is
+    ///         stored in the executable, which is compressed if
+    ///         BundleEntry::is_compressed() is \c true.
+    BytesView content(const BundleEntry &entry) const noexcept
+    {
+        return _file.subview(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.stored_size()));
+    }
+
+    /// \brief  Load an embedded file as an executable, reading it directly
+    ///         from the view of the bundle.
+    /// \param entry    The embedded file, such as an Assembly or NativeBinary entry.
+    /// \param options  Flags indicating what portions of the file to load.
+    ///
+    /// The ExeInfo holds copies of the data it loads and so does not depend
+    /// on the view of the bundle. A \c std::runtime_error exception is
+    /// thrown if the file is stored compressed, since it would need to be
+    /// decompressed first.
+    ExeInfo load(const BundleEntry &entry, LoadOptions::Options options) const;
+
+private:
+    BytesView                   _file;
+    BundleHeader                _header;
+    std::vector<BundleEntry>    _entries;
+};
+
+#endif  //_EXELIB_SINGLEFILEBUNDLE_H_
@@ -0,0 +1,289 @@
+/// \file   StringExtractor.cpp
+/// Implementation of the StringExtractor class.
+///
+/// \author Jeff Bienstadt
+///
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EXELIB_STRINGS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "StringExtractor.h"
+
+namespace {
+
+constexpr size_t    block_size{16};
+
+/// \brief  Masks classifying a block of up to sixteen bytes, one bit per byte.
+struct BlockMasks
+{
+    uint32_t    printable;  // the byte is a printable character
+    uint32_t    wide;       // the byte is printable and the byte following it is zero
+};
+
+inline unsigned count_trailing_zeros(uint32_t value) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long   index;
+
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+inline bool is_printable(uint8_t byte) noexcept
+{
+    return (byte >= 0x20 && byte <= 0x7E) || byte == '\t';
+}
+
+/// \brief  Gather bits 0, 2, 4, ... 14 of \p value into bits 0 through 7.
+inline uint32_t gather_even_bits(uint32_t value) noexcept
+{
+    value &= 0x5555;
+    value = (value | (value >> 1)) & 0x3333;
+    value = (value | (value >> 2)) & 0x0F0F;
+    value = (value | (value >> 4)) & 0x00FF;
+    return value;
+}
+
+/// \brief  Classify \p available bytes, at most sixteen, starting at \p ptr.
+/// Bits for positions at or beyond \p available are clear.
+BlockMasks classify_tail(const uint8_t *ptr, size_t available) noexcept
+{
+    BlockMasks  masks{0, 0};
+    size_t      count{std::min(available, block_size)};
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (is_printable(ptr[i]))
+        {
+            masks.printable |= 1u << i;
+            if (i + 1 < available && ptr[i + 1] == 0)
+                masks.wide |= 1u << i;
+        }
+    }
+
+    return masks;
+}
+
+/// \brief  Classify the sixteen bytes at \p ptr. Seventeen bytes must be
+/// readable, since a byte's wide bit depends on the byte following it.
+inline BlockMasks classify_block(const uint8_t *ptr) noexcept
+{
+#if defined(EXELIB_STRINGS_SSE2)
+    // Printable characters compare, as signed bytes, above 0x1F and below 0x7F;
+    // bytes from 0x80 up are negative and so fail the first test.
+    const __m128i   bytes{_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr))};
+    const __m128i   next{_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + 1))};
+    const __m128i   printable{_mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)),
+                                                         _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F))),
+                                           _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')))};
+    const __m128i   wide{_mm_and_si128(printable, _mm_cmpeq_epi8(next, _mm_setzero_si128()))};
+
+    return BlockMasks{static_cast<uint32_t>(_mm_movemask_epi8(printable)),
+                      static_cast<uint32_t>(_mm_movemask_epi8(wide))};
+#else
+    return classify_tail(ptr, block_size + 1);
+#endif
+}
+
+/// \brief  Tracks a run of consecutive characters of one encoding.
+///
+/// Characters are fed in groups as bit masks; the \c Emit function is
+/// called with the positions of the first character of each completed run
+/// and of the position just past its last character.
+template<typename Emit>
+class RunTracker
+{
+public:
+    RunTracker(size_t char_size, Emit &emit) noexcept
+      : _char_size{char_size},
+        _emit(emit)
+    {}
+
+    /// \brief  Feed \p count characters, the first of which is at
+    /// \p position, with a set bit in \p mask for each valid character.
+    void feed(uint32_t mask, unsigned count, size_t position)
+    {
+        // Most groups neither begin nor end a run.
+        if (mask == (_active ? (1u << count) - 1 : 0))
+            return;
+
+        unsigned    i{0};
+
+        while (i < count)
+        {
+            uint32_t    rest{(_active ? ~mask : mask) >> i};
+            unsigned    skip{rest ? count_trailing_zeros(rest) : count};
+
+            if (i + skip >= count)
+                break;
+
+            i += skip;
+            if (_active)
+                _emit(_start, position + i * _char_size);
+            else
+                _start = position + i * _char_size;
+            _active = !_active;
+        }
+    }
+
+    /// \brief  Complete any run still in progress at \p end.
+    void finish(size_t end)
+    {
+        if (_active)
+            _emit(_start, end);
+        _active = false;
+    }
+
+private:
+    size_t      _char_size;
+    Emit       &_emit;
+    bool        _active{false};
+    size_t      _start{0};
+};
+
+/// \brief  Find the runs of printable characters in \p size bytes at \p data,
+/// calling \p emit with the encoding and the bounds of each run.
+template<typename Emit>
+void find_runs(const uint8_t *data, size_t size, Emit emit)
+{
+    auto emit_ascii = [&](size_t begin, size_t end) { emit(StringEncoding::Ascii, begin, end); };
+    auto emit_wide = [&](size_t begin, size_t end) { emit(StringEncoding::Utf16LE, begin, end); };
+
+    RunTracker<decltype(emit_ascii)>    ascii{1, emit_ascii};
+    RunTracker<decltype(emit_wide)>     wide_even{2, emit_wide};
+    RunTracker<decltype(emit_wide)>     wide_odd{2, emit_wide};
+    size_t                              pos{0};
+
+    auto feed = [&](const BlockMasks &masks)
+                {
+                    ascii.feed(masks.printable, block_size, pos);
+                    wide_even.feed(gather_even_bits(masks.wide), block_size / 2, pos);
+                    wide_odd.feed(gather_even_bits(masks.wide >> 1), block_size / 2, pos + 1);
+                };
+
+    for (; pos + block_size < size; pos += block_size)
+        feed(classify_block(data + pos));
+
+    // Positions past the end are clear in the final masks, ending any
+    // wide run that reaches the end of the data. An ASCII run or a wide
+    // run of the other parity may still be in progress.
+    if (pos < size)
+        feed(classify_tail(data + pos, size - pos));
+
+    ascii.finish(size);
+    wide_even.finish(size);
+    wide_odd.finish(size);
+}
+
+}   // anonymous namespace
+
+
+void StringExtractor::extract(BytesView bytes, uint64_t base_offset, const Callback &callback) const
+{
+    extract_region(bytes.data(), Region{base_offset, base_offset + bytes.size(), -1, 0}, callback);
+}
+
+void StringExtractor::extract(const PeExeInfo &pe, BytesView image, const Callback &callback) const
+{
+    std::vector<Region> regions;
+    const auto         &sections{pe.sections()};
+
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        const auto &header{sections[i].header()};
+
+        if (header.raw_data_position && header.size_of_raw_data)
+            regions.push_back(Region{header.raw_data_position,
+                                     static_cast<uint64_t>(header.raw_data_position) + header.size_of_raw_data,
+                                     static_cast<int>(i),
+                                     header.virtual_address});
+    }
+
+    extract_regions(regions, image, callback);
+}
+
+void StringExtractor::extract(const NeExeInfo &ne, BytesView image, const Callback &callback) const
+{
+    std::vector<Region> regions;
+    const auto         &segments{ne.segment_table()};
+
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const auto &segment{segments[i]};
+
+        if (segment.sector)     // zero means there is no sector data
+        {
+            uint64_t    begin{static_cast<uint64_t>(segment.sector) << ne.align_shift_count()};
+            uint64_t    length{segment.length ? segment.length : 65536u};
+
+            regions.push_back(Region{begin, begin + length, static_cast<int>(i), 0});
+        }
+    }
+
+    extract_regions(regions, image, callback);
+}
+
+void StringExtractor::extract_regions(std::vector<Region> &regions, BytesView image, const Callback &callback) const
+{
+    // Put the regions in file order, trim any overlap, and fill the gaps
+    // between them, so that every byte of the image is scanned exactly once.
+    std::sort(regions.begin(), regions.end(),
+              [](const Region &a, const Region &b) { return a.begin < b.begin; });
+
+    std::vector<Region> ordered;
+    uint64_t            position{0};
+
+    for (auto region : regions)
+    {
+        region.end = std::min<uint64_t>(region.end, image.size());
+        if (region.begin < position)
+        {
+            region.rva += static_cast<uint32_t>(position - region.begin);
+            region.begin = position;
+        }
+        if (region.begin >= region.end)
+            continue;
+
+        if (position < region.begin)
+            ordered.push_back(Region{position, region.begin, -1, 0});
+        ordered.push_back(region);
+        position = region.end;
+    }
+    if (position < image.size())
+        ordered.push_back(Region{position, image.size(), -1, 0});
+
+    for (const auto &region : ordered)
+        extract_region(image.data() + region.begin, region, callback);
+}
+
+void StringExtractor::extract_region(const uint8_t *data, const Region &region, const Callback &callback) const
+{
+    find_runs(data, static_cast<size_t>(region.end - region.begin),
+              [&](StringEncoding encoding, size_t begin, size_t end)
+              {
+                  size_t    length{encoding == StringEncoding::Ascii ? end - begin : (end - begin) / 2};
+
+                  if (length < _min_length)
+                      return;
+
+                  callback(ExtractedString{encoding,
+                                           region.begin + begin,
+                                           region.section < 0 ? 0 : region.rva + static_cast<uint32_t>(begin),
+                                           region.section,
+                                           length,
+                                           BytesView{data + begin, end - begin}});
+              });
+}
@@ -0,0 +1,108 @@
+/// \file   StringExtractor.h
+/// Provides the StringExtractor class for finding printable ASCII and
+/// UTF-16LE strings in executable images, in the manner of \c strings.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_STRINGEXTRACTOR_H_
+#define _EXELIB_STRINGEXTRACTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "NEExe.h"
+#include "PEExe.h"
+#include "views.h"
+
+
+/// \brief  The encoding of an extracted string.
+enum class StringEncoding
+{
+    Ascii,      ///< Single-byte printable characters.
+    Utf16LE     ///< Little-endian UTF-16 code units, each a printable character followed by a zero byte.
+};
+
+/// \brief  Describes a single string found by the StringExtractor.
+struct ExtractedString
+{
+    StringEncoding  encoding;       ///< The encoding of the string.
+    uint64_t        file_offset;    ///< File offset of the first byte of the string.
+    uint32_t        rva;            ///< For a PE image, the RVA of the string. For an NE image, the offset of
+                                    ///< the string within its segment. Zero if \c section is negative.
+    int             section;        ///< Index into the Section Table (PE) or Segment Table (NE) of the
+                                    ///< section or segment containing the string, or -1 if there is none.
+    size_t          length;         ///< The length of the string, in characters.
+    BytesView       bytes;          ///< The raw bytes of the string, not including any terminator.
+};
+
+/// \brief  Finds runs of printable characters in raw bytes.
+///
+/// Printable characters are those from space through tilde, plus the tab
+/// character. A UTF-16LE character is a printable character followed by a
+/// zero byte; strings are found at both even and odd file offsets.
+///
+/// The bytes are classified sixteen at a time using SSE2 instructions where
+/// they are available, and one at a time otherwise. Nothing is copied:
+/// each string is reported as a view into the bytes being scanned, so
+/// scanning a memory-mapped file never materializes its sections.
+class StringExtractor
+{
+public:
+    using Callback = std::function<void(const ExtractedString &)>;
+
+    /// \brief  Construct a StringExtractor.
+    /// \param min_length   The minimum number of characters in a reported string.
+    explicit StringExtractor(size_t min_length = 4) noexcept
+      : _min_length{min_length ? min_length : 1}
+    {}
+
+    /// \brief  Return the minimum number of characters in a reported string.
+    size_t min_length() const noexcept
+    {
+        return _min_length;
+    }
+
+    /// \brief  Find the strings in a block of bytes.
+    /// \param bytes        The bytes to scan.
+    /// \param base_offset  Value added to each string's position to produce
+    ///                     the reported \c file_offset.
+    /// \param callback     Function called once for each string found.
+    ///                     The \c section member is -1.
+    void extract(BytesView bytes, uint64_t base_offset, const Callback &callback) const;
+
+    /// \brief  Find the strings in an entire PE file image.
+    /// \param pe       The PE portion of the executable loaded from \p image.
+    /// \param image    The complete file, typically memory-mapped.
+    /// \param callback Function called once for each string found.
+    ///
+    /// The headers, each section's raw data, and the overlay are scanned
+    /// separately, so no string is reported as spanning two of them.
+    void extract(const PeExeInfo &pe, BytesView image, const Callback &callback) const;
+
+    /// \brief  Find the strings in an entire NE file image.
+    /// \param ne       The NE portion of the executable loaded from \p image.
+    /// \param image    The complete file, typically memory-mapped.
+    /// \param callback Function called once for each string found.
+    ///
+    /// Each segment's data is scanned separately from the rest of the file,
+    /// so no string is reported as spanning a segment boundary.
+    void extract(const NeExeInfo &ne, BytesView image, const Callback &callback) const;
+
+private:
+    struct Region
+    {
+        uint64_t    begin;      // file offset of the region
+        uint64_t    end;        // file offset just past the region
+        int         section;    // section or segment index, or -1
+        uint32_t    rva;        // RVA, or offset within the segment, of the beginning of the region
+    };
+
+    void extract_region(const uint8_t *data, const Region &region, const Callback &callback) const;
+    void extract_regions(std::vector<Region> &regions, BytesView image, const Callback &callback) const;
+
+    size_t  _min_length;
+};
+
+#endif  //_EXELIB_STRINGEXTRACTOR_H_
@@ -1,6 +1,6 @@
 /// \file   readers.h
 /// Provides helper functions as well as the BytesReader class for reading
-/// binary data from an input stream and from a byte vector.
+/// binary data from an input stream and from a byte vector or view.
 ///
 /// \author Jeff Bienstadt
 ///
@@ -10,9 +10,12 @@
 
 #include <climits>
 #include <istream>
+#include <stdexcept>
 #include <vector>
 #include <utility>
 
+#include "views.h"
+
 
 /// \brief  Read binary data from an input stream into various primitive types.
 /// \param stream       A reference to a std::istream from which to read bytes.
@@ -141,6 +144,10 @@ public:
       : _bytes{bytes}
     {}
 
+    BytesReader(BytesView bytes) noexcept
+      : _bytes{bytes}
+    {}
+
     BytesReader(const BytesReader &) = delete;              // The copy constructor is deleted
     BytesReader(BytesReader &&) = delete;                   // The move constructor is deleted
     BytesReader &operator=(const BytesReader &) = delete;   // The copy assignment operator is deleted
@@ -173,7 +180,7 @@ public:
     {
         value = 0;
         for (size_t shift = 0; shift < sizeof(T) * CHAR_BIT; shift += CHAR_BIT)
-            value |= static_cast<T>(_bytes.at(_pos++) << shift);
+            value |= static_cast<T>(static_cast<T>(at(_pos++)) << shift);
         return sizeof(T);
     }
 
@@ -185,7 +192,7 @@ public:
     size_t read(uint8_t *array, size_t count)
     {
         for (size_t i = 0; i < count; ++i)
-            array[i] = _bytes.at(_pos++);
+            array[i] = at(_pos++);
 
         return count;
     }
@@ -197,8 +204,15 @@ public:
     }
 
 private:
-    const std::vector<uint8_t> &_bytes;     // A reference to the given vector of bytes.
-    size_t                      _pos{0};    // The current position within the vector.
+    uint8_t at(size_t pos) const
+    {
+        if (pos >= _bytes.size())
+            throw std::out_of_range("BytesReader: attempt to read beyond the end of the data.");
+        return _bytes[pos];
+    }
+
+    BytesView   _bytes;     // A view of the given bytes.
+    size_t      _pos{0};    // The current position within the bytes.
 };
 
 #endif  //_EXELIB_READSTREAM_H_
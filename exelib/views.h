@@ -0,0 +1,183 @@
+/// \file   views.h
+/// Provides light-weight, non-owning views over bytes held elsewhere, such as
+/// in a memory-mapped file or in a vector loaded by the library.
+///
+/// \author Jeff Bienstadt
+///
+
+#ifndef _EXELIB_VIEWS_H_
+#define _EXELIB_VIEWS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+/// \brief  A non-owning view of a contiguous range of bytes.
+///
+/// \note   The view does not make a copy of the bytes. The memory it refers
+///         to must remain valid for as long as the view is in use.
+class BytesView
+{
+public:
+    using const_iterator = const uint8_t *;
+
+    /// \brief  Construct an empty view.
+    constexpr BytesView() noexcept
+    {}
+
+    /// \brief  Construct a view of \p size bytes beginning at \p data.
+    constexpr BytesView(const uint8_t *data, size_t size) noexcept
+      : _data{data},
+        _size{size}
+    {}
+
+    /// \brief  Construct a view of the content of a byte vector.
+    BytesView(const std::vector<uint8_t> &bytes) noexcept
+      : _data{bytes.data()},
+        _size{bytes.size()}
+    {}
+
+    /// \brief  Return a pointer to the first byte in the view.
+    constexpr const uint8_t *data() const noexcept
+    {
+        return _data;
+    }
+
+    /// \brief  Return the number of bytes in the view.
+    constexpr size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /// \brief  Return \c true if the view contains no bytes.
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return _data;
+    }
+
+    constexpr const_iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+
+    /// \brief  Return the byte at position \p pos. No bounds checking is performed.
+    constexpr uint8_t operator[](size_t pos) const noexcept
+    {
+        return _data[pos];
+    }
+
+    /// \brief  Return a view of at most \p count bytes starting at \p pos.
+    ///
+    /// The returned view is clipped to the boundaries of this view,
+    /// so it may be shorter than requested, or empty.
+    BytesView subview(size_t pos, size_t count = static_cast<size_t>(-1)) const noexcept
+    {
+        if (pos >= _size)
+            return {};
+
+        return {_data + pos, count < _size - pos ? count : _size - pos};
+    }
+
+private:
+    const uint8_t  *_data{nullptr};
+    size_t          _size{0};
+};
+
+/// \brief  A non-owning view of a sequence of characters, such as a string
+///         in the \#Strings heap of CLI metadata.
+///
+/// The characters are not necessarily followed by a nul.
+///
+/// \note   The view does not make a copy of the characters. The memory it
+///         refers to must remain valid for as long as the view is in use.
+class StringView
+{
+public:
+    using const_iterator = const char *;
+
+    /// \brief  Construct an empty view.
+    constexpr StringView() noexcept
+    {}
+
+    /// \brief  Construct a view of \p size characters beginning at \p data.
+    constexpr StringView(const char *data, size_t size) noexcept
+      : _data{data},
+        _size{size}
+    {}
+
+    /// \brief  Construct a view of a nul-terminated string.
+    StringView(const char *str) noexcept
+      : _data{str},
+        _size{std::strlen(str)}
+    {}
+
+    /// \brief  Construct a view of the content of a \c std::string.
+    StringView(const std::string &str) noexcept
+      : _data{str.data()},
+        _size{str.size()}
+    {}
+
+    /// \brief  Return a pointer to the first character in the view.
+    constexpr const char *data() const noexcept
+    {
+        return _data;
+    }
+
+    /// \brief  Return the number of characters in the view.
+    constexpr size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /// \brief  Return \c true if the view contains no characters.
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return _data;
+    }
+
+    constexpr const_iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+
+    /// \brief  Return the character at position \p pos. No bounds checking is performed.
+    constexpr char operator[](size_t pos) const noexcept
+    {
+        return _data[pos];
+    }
+
+    /// \brief  Return a \c std::string containing a copy of the characters.
+    std::string str() const
+    {
+        return {_data, _size};
+    }
+
+    friend bool operator==(StringView a, StringView b) noexcept
+    {
+        return a._size == b._size && (a._size == 0 || std::memcmp(a._data, b._data, a._size) == 0);
+    }
+
+    friend bool operator!=(StringView a, StringView b) noexcept
+    {
+        return !(a == b);
+    }
+
+private:
+    const char *_data{nullptr};
+    size_t      _size{0};
+};
+
+#endif  //_EXELIB_VIEWS_H_
@@ -696,12 +696,12 @@ void MainWindow::populate_tree()
                     else if (tmp_name == "#Strings")
                     {
                         data_type = TreeItemDataType::peCliStreamStrings;
-                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->get_strings_heap_strings().size()) + ')';
+                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->strings_heap().size()) + ')';
                     }
                     else if (tmp_name == "#US")
                     {
                         data_type = TreeItemDataType::peCliStreamUserStrings;
-                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->get_us_heap_strings().size()) + ')';
+                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->user_strings_heap().size()) + ')';
                     }
                     else if (tmp_name == "#GUID")
                     {
@@ -711,7 +711,7 @@ void MainWindow::populate_tree()
                     else if (tmp_name == "#Blob")
                     {
                         data_type = TreeItemDataType::peCliStreamBlob;
-                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->get_blob_heap_blobs().size()) + ')';
+                        tmp_name += " (" + std::to_string(pe->cli()->metadata()->blob_heap().size()) + ')';
                     }
                     else    // Custom stream. Probably shouldn't be here, but we'll show it's name in the tree if we can.
                     {
@@ -926,6 +926,8 @@ void MainWindow::populate_tree()
                                     count = tables->type_spec_table()->size();
                                     type = TreeItemDataType::peCliTableTypeSpec;
                                     break;
+                                default:
+                                    break;
                             }
 
                             if (table_name)
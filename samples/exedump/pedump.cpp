@@ -709,6 +709,36 @@ const char *get_table_type_name(PeCliMetadataTableId id)
             return "TypeRef";
         case PeCliMetadataTableId::TypeSpec:
             return "TypeSpec";
+        case PeCliMetadataTableId::FieldPtr:
+            return "FieldPtr";
+        case PeCliMetadataTableId::MethodPtr:
+            return "MethodPtr";
+        case PeCliMetadataTableId::ParamPtr:
+            return "ParamPtr";
+        case PeCliMetadataTableId::EventPtr:
+            return "EventPtr";
+        case PeCliMetadataTableId::PropertyPtr:
+            return "PropertyPtr";
+        case PeCliMetadataTableId::ENCLog:
+            return "ENCLog";
+        case PeCliMetadataTableId::ENCMap:
+            return "ENCMap";
+        case PeCliMetadataTableId::Document:
+            return "Document";
+        case PeCliMetadataTableId::MethodDebugInformation:
+            return "MethodDebugInformation";
+        case PeCliMetadataTableId::LocalScope:
+            return "LocalScope";
+        case PeCliMetadataTableId::LocalVariable:
+            return "LocalVariable";
+        case PeCliMetadataTableId::LocalConstant:
+            return "LocalConstant";
+        case PeCliMetadataTableId::ImportScope:
+            return "ImportScope";
+        case PeCliMetadataTableId::StateMachineMethod:
+            return "StateMachineMethod";
+        case PeCliMetadataTableId::CustomDebugInformation:
+            return "CustomDebugInformation";
     }
 
     // we should never get here
@@ -1753,6 +1783,8 @@ void dump_cli_metadata_tables(const PeCli &cli, std::ostream &outstream)
                 case PeCliMetadataTableId::TypeSpec:
                     dump_type_spec_table(ptables->type_spec_table(), *cli.metadata(), outstream);
                     break;
+                default:
+                    break;  // tables of uncompressed streams and Portable PDBs are not dumped
             }
         }
     }